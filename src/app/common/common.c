@@ -12,6 +12,10 @@
 #include "raw.h"
 #include "sys_plat.h"
 #include "udp.h"
+#include "vlan.h"
+#include "bond.h"
+#include "acl.h"
+#include "snapshot.h"
 
 // 动态获取的网络接口信息
 static netif_info_t netif_info;
@@ -107,6 +111,18 @@ net_err_t tiny_net_init(void)
     // 以太网卡初始化
     ether_init();
 
+    // VLAN子接口初始化
+    vlan_init();
+
+    // 链路聚合初始化
+    bond_init();
+
+    // 入口分类初始化
+    acl_init();
+
+    // 快速重启快照初始化，记录在网卡激活且工作线程启动后恢复
+    snapshot_init();
+
     // 虚拟网卡初始化
     netdev_init();
 
@@ -125,5 +141,8 @@ net_err_t tiny_net_init(void)
     // 回环网卡初始化
     loop_init();
 
+    // 在工作线程中恢复已激活网卡的邻居与静态路由
+    snapshot_restore();
+
     return NET_ERR_OK;
 }
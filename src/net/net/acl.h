@@ -0,0 +1,68 @@
+#ifndef TINY_NET_ACL_H
+#define TINY_NET_ACL_H
+
+#include <stdint.h>
+#include "ipaddr.h"
+#include "net_cfg.h"
+#include "net_err.h"
+#include "pktbuf.h"
+
+typedef enum acl_action_t
+{
+    // 放行，不再匹配后续规则
+    ACL_ACTION_ACCEPT = 0,
+    // 丢弃，不再匹配后续规则
+    ACL_ACTION_DROP,
+    // 只计数，继续匹配后续规则
+    ACL_ACTION_COUNT,
+} acl_action_t;
+
+// 入口分类规则，各字段取默认值时表示不限制；带IP、协议或端口条件的规则只匹配IPv4帧
+typedef struct acl_rule_t
+{
+    // 以太网类型，0表示任意；带802.1Q标签的帧按内层类型匹配
+    uint16_t ethertype;
+    // 源与目的地址前缀，前缀长度为0表示任意
+    ipaddr_t src_ip;
+    uint8_t src_prefix;
+    ipaddr_t dst_ip;
+    uint8_t dst_prefix;
+    // IP上层协议，0表示任意
+    uint8_t protocol;
+    // 源与目的端口范围(含两端)，只对TCP/UDP首片有效，0~65535表示任意
+    uint16_t src_port_min;
+    uint16_t src_port_max;
+    uint16_t dst_port_min;
+    uint16_t dst_port_max;
+    acl_action_t action;
+} acl_rule_t;
+
+typedef struct acl_stats_t
+{
+    // 生效的规则数量
+    int rule_nr;
+    // 各规则命中次数，下标与加入顺序一致
+    uint64_t hits[ACL_RULE_MAX];
+} acl_stats_t;
+
+net_err_t acl_init();
+
+// 规则模板：所有字段不限制，动作为放行
+void acl_rule_init(acl_rule_t* rule);
+
+// 追加一条待生效的规则，规则按加入顺序匹配
+net_err_t acl_add_rule(const acl_rule_t* rule);
+
+// 清空待生效的规则，提交后关闭分类
+void acl_clear();
+
+// 编译待生效的规则并切换，命中计数清零；等仍在使用旧规则表的分类结束后返回
+net_err_t acl_commit();
+
+// 对以太网帧分类，可在驱动线程中调用；没有命中终止规则时放行
+acl_action_t acl_classify(pktbuf_t* buf);
+
+// 获取各规则命中次数
+net_err_t acl_get_stats(acl_stats_t* stats);
+
+#endif //TINY_NET_ACL_H
@@ -40,28 +40,60 @@ typedef struct arp_entity_t
     uint8_t p_addr[IPV4_ADDR_LEN];
     uint8_t hwaddr[ETHER_HWADDR_LEN];
 
+    // 状态参照RFC 4861，RESOLVE及之后的状态都可直接用于发送
     enum
     {
         NET_ARP_FREE,
+        // 等待首次解析，发送的包排队
         NET_ARP_WAITING,
-        NET_ARP_RESOLVE
+        // 最近得到确认
+        NET_ARP_RESOLVE,
+        // 确认已过期，未再使用
+        NET_ARP_STALE,
+        // 过期后又被使用，等待上层流量确认后再探测
+        NET_ARP_DELAY,
+        // 正在单播探测
+        NET_ARP_PROBE,
+        // 静态配置，不老化、不淘汰，也不被收到的包改写
+        NET_ARP_PERMANENT,
     } state;
 
     // 超时毫秒数
     int timeout;
     // 重试计数
     int retry_cnt;
+    // 代数：缓存项释放或MAC地址改变时更新，使已有的引用失效
+    uint32_t gen;
     nlist_node_t node;
     nlist_t buf_list;
     netif_t* netif;
 } arp_entity_t;
 
+// 邻居引用：由路由项与套接字持有，代数一致时直接使用缓存项的MAC地址，无需查表
+typedef struct arp_ref_t
+{
+    arp_entity_t* entity;
+    uint32_t gen;
+} arp_ref_t;
+
+// 保存到快照文件的邻居记录，网卡按名称对应
+typedef struct arp_record_t
+{
+    char netif_name[NETIF_NAME_LEN];
+    uint8_t p_addr[IPV4_ADDR_LEN];
+    uint8_t hwaddr[ETHER_HWADDR_LEN];
+    uint8_t permanent;
+} arp_record_t;
+
 // ARP缓存初始化
 net_err_t arp_init();
 
 // 发送ARP请求
 net_err_t arp_make_request(netif_t* netif, const ipaddr_t* addr);
 
+// 向已知MAC地址单播ARP请求，确认邻居是否仍可达
+net_err_t arp_make_probe(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr);
+
 // 发送无回报ARP请求
 net_err_t arp_make_gratuitous_request(netif_t* netif);
 
@@ -80,6 +112,27 @@ void arp_clear(const netif_t* netif);
 // 查找对应IP地址的MAC地址
 const uint8_t* arp_find(const netif_t* netif, const ipaddr_t* addr);
 
+// 通过引用取MAC地址，引用失效时返回NULL；只在工作线程中调用
+const uint8_t* arp_ref_use(arp_ref_t* ref);
+
+// 查找已解析的邻居并建立引用，返回MAC地址；未解析、本机或广播地址返回NULL且不建立引用
+const uint8_t* arp_ref_get(arp_ref_t* ref, const netif_t* netif, const ipaddr_t* addr);
+
+// 添加静态邻居，已有的缓存项改为静态并发出等待的包；转到工作线程中执行，需在net_start之后调用
+net_err_t arp_add_static(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr);
+
+// 删除静态邻居；转到工作线程中执行，需在net_start之后调用
+net_err_t arp_remove_static(const netif_t* netif, const ipaddr_t* addr);
+
+// 同arp_add_static，只在工作线程中调用
+net_err_t arp_entry_add_static(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr);
+
+// 预加载邻居：已有缓存项时忽略；以STALE状态加入，首次使用后在后台探测确认
+net_err_t arp_preload(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr);
+
+// 导出已解析与静态的邻居，返回记录数量
+int arp_export(arp_record_t* records, int max);
+
 // 根据收到的IP数据包更新ARP缓存
 void arp_update_from_ip_buf(netif_t* netif, pktbuf_t* buf);
 
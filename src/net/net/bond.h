@@ -0,0 +1,68 @@
+#ifndef TINY_NET_BOND_H
+#define TINY_NET_BOND_H
+
+#include <stdint.h>
+#include "net_cfg.h"
+#include "net_err.h"
+#include "netif.h"
+#include "pktbuf.h"
+#include "timer.h"
+
+typedef enum bond_mode_t
+{
+    // 主备：只用一个成员收发，链路断开时切换到下一个可用成员
+    BOND_MODE_ACTIVE_BACKUP = 0,
+    // 负载分担：按L3/L4流哈希在可用成员中选择发送成员，同一流保持顺序
+    BOND_MODE_BALANCE_XOR,
+} bond_mode_t;
+
+typedef struct bond_stats_t
+{
+    // 主备切换次数
+    uint64_t failovers;
+    // 各成员发送的包数，下标与加入顺序一致
+    uint64_t tx_packets[BOND_MEMBER_MAX];
+    // 没有可用成员而丢弃的包数
+    uint64_t tx_dropped;
+} bond_stats_t;
+
+// 聚合接口私有数据，只在工作线程中访问
+typedef struct bond_t
+{
+    netif_t* netif;
+    bond_mode_t mode;
+    // 按加入顺序排列的成员
+    netif_t* members[BOND_MEMBER_MAX];
+    int member_nr;
+    // 链路连通的成员下标，负载分担模式按哈希在其中选择
+    int up[BOND_MEMBER_MAX];
+    int up_nr;
+    // 主备模式当前使用的成员下标，-1表示没有可用成员
+    int active;
+    // 定期查询成员载波状态，驱动成员的链路状态
+    net_timer_t monitor;
+    bond_stats_t stats;
+} bond_t;
+
+net_err_t bond_init();
+
+// 创建聚合接口，加入第一个成员后才有MAC地址；监视定时器交给工作线程添加，不能在工作线程中调用
+netif_t* bond_open(const char* name, bond_mode_t mode);
+
+// 加入成员：成员需已打开且未激活，聚合接口需未激活；之后成员的收发都经过聚合接口，
+// 成员的接收过滤改为聚合接口的MAC地址
+net_err_t bond_add_member(netif_t* netif, netif_t* member);
+
+// 成员链路状态变化后重新计算可用成员
+void bond_link_update(netif_t* netif);
+
+// 处理成员收到的帧：主备模式只接收当前成员的帧，之后交给聚合接口的链路层
+net_err_t bond_input(netif_t* member, pktbuf_t* buf);
+
+// 获取当前收发成员，负载分担模式返回第一个可用成员，没有时返回NULL
+netif_t* bond_active_member(netif_t* netif);
+
+// 获取统计信息
+net_err_t bond_get_stats(netif_t* netif, bond_stats_t* stats);
+
+#endif //TINY_NET_BOND_H
@@ -0,0 +1,75 @@
+#ifndef TINY_NET_DRR_H
+#define TINY_NET_DRR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "net_cfg.h"
+#include "net_err.h"
+#include "nlist.h"
+#include "nlocker.h"
+#include "pktbuf.h"
+#include "sys.h"
+
+// 一个流的子队列
+typedef struct drr_queue_t
+{
+    // 排队的包
+    nlist_t buf_list;
+    // 积压字节数
+    uint32_t bytes;
+    // 本轮剩余可发送的字节数
+    uint32_t deficit;
+    // 是否在活动链表中
+    bool active;
+    // 活动链表节点
+    nlist_node_t node;
+} drr_queue_t;
+
+typedef struct drr_stats_t
+{
+    // 入队与出队的包数
+    uint64_t enqueued;
+    uint64_t dequeued;
+    // 子队列超出字节上限丢弃的包数
+    uint64_t dropped;
+    // 当前积压的包数与字节数
+    uint32_t backlog;
+    uint32_t backlog_bytes;
+} drr_stats_t;
+
+// 发送方向差额轮询调度器：工作线程按流哈希入队，驱动线程轮流从各子队列出队
+typedef struct drr_t
+{
+    bool enabled;
+    // 每轮为子队列增加的可发送字节数
+    uint32_t quantum;
+    // 每个子队列的积压字节上限
+    uint32_t limit;
+    drr_queue_t queues[DRR_QUEUE_NR];
+    // 有积压的子队列，按轮询顺序排列
+    nlist_t active_list;
+    nlocker_t locker;
+    // 可出队的包数
+    sys_sem_t recv_sem;
+    drr_stats_t stats;
+} drr_t;
+
+// 创建调度器
+net_err_t drr_init(drr_t* drr, uint32_t quantum, uint32_t limit);
+
+// 按流哈希放入子队列，子队列超出字节上限时返回NET_ERR_FULL，包仍由调用者释放
+net_err_t drr_enqueue(drr_t* drr, pktbuf_t* buf, uint32_t hash);
+
+// 取出一个包，timeout_ms与fixq_recv相同：小于0不等待，0一直等待
+pktbuf_t* drr_dequeue(drr_t* drr, int32_t timeout_ms);
+
+// 不等待地取出最多cnt个包，返回取出的数量
+int drr_dequeue_burst(drr_t* drr, pktbuf_t** bufs, int cnt);
+
+// 释放积压的包
+void drr_flush(drr_t* drr);
+
+// 销毁调度器
+void drr_destroy(drr_t* drr);
+
+#endif //TINY_NET_DRR_H
@@ -30,6 +30,25 @@ typedef struct ether_header_t
 } ether_header_t;
 #pragma pack()
 
+// 802.1Q标签长度
+#define ETHER_VLAN_TAG_LEN 4
+
+#pragma pack(1)
+typedef struct ether_vlan_header_t
+{
+    // 目的MAC地址
+    uint8_t dest_mac[ETHER_HWADDR_LEN];
+    // 源MAC地址
+    uint8_t src_mac[ETHER_HWADDR_LEN];
+    // 标签协议标识，固定为0x8100
+    uint16_t tpid;
+    // 标签控制信息：优先级3位，CFI 1位，VLAN ID 12位
+    uint16_t tci;
+    // 内层以太网协议类型
+    uint16_t protocol;
+} ether_vlan_header_t;
+#pragma pack()
+
 #pragma pack(1)
 typedef struct ether_frame_t
 {
@@ -32,6 +32,19 @@ typedef struct func_msg_t
     sys_sem_t wait_sem;
 } func_msg_t;
 
+struct exmsg_work_t;
+
+typedef void (*exmsg_work_func_t)(struct exmsg_work_t* work);
+
+// 延迟工作：工作线程处理完当前消息后执行，避免协议处理中的递归调用
+typedef struct exmsg_work_t
+{
+    nlist_node_t node;
+    exmsg_work_func_t func;
+    // 是否已在待执行列表中
+    bool pending;
+} exmsg_work_t;
+
 typedef struct exmsg_t
 {
     nlist_node_t node;
@@ -52,4 +65,10 @@ net_err_t exmsg_netif_in(netif_t* netif);
 
 net_err_t exmsg_func_exec(exmsg_func_t func, void* arg);
 
+// 初始化延迟工作
+void exmsg_work_init(exmsg_work_t* work, exmsg_work_func_t func);
+
+// 调度延迟工作，只能在工作线程中调用；已在列表中时不重复加入
+void exmsg_work_schedule(exmsg_work_t* work);
+
 #endif //TINY_NET_EXMSG_H
@@ -20,6 +20,8 @@ net_err_t fixq_init(fixq_t* q, void** buf, int size, nlocker_type_t share_type);
 
 net_err_t fixq_send(fixq_t* q, void* msg, int32_t timeout_ms);
 
+int fixq_send_burst(fixq_t* q, void** msgs, int cnt);
+
 void *fixq_recv(fixq_t* q, int32_t timeout_ms);
 
 void fixq_destroy(fixq_t* q);
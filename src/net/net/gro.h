@@ -0,0 +1,51 @@
+#ifndef TINY_NET_GRO_H
+#define TINY_NET_GRO_H
+
+#include <stdint.h>
+#include "net_cfg.h"
+#include "net_err.h"
+#include "netif.h"
+#include "pktbuf.h"
+
+// 合并完成后交付给链路层的处理函数
+typedef net_err_t (*gro_deliver_t)(netif_t* netif, pktbuf_t* buf);
+
+// 一次批量接收期间的合并状态
+typedef struct gro_t
+{
+    netif_t* netif;
+    gro_deliver_t deliver;
+    // 正在合并的包，NULL表示没有
+    pktbuf_t* head;
+    // 合并包当前的IP总长度
+    int ip_len;
+} gro_t;
+
+typedef struct gro_stats_t
+{
+    // 进入GRO的帧数
+    uint64_t packets_in;
+    // 交付给链路层的包数，与packets_in之比即合并率
+    uint64_t packets_out;
+    // 被合并进其他包的帧数
+    uint64_t merged;
+    // 合并包在上层被拆回的数据报数
+    uint64_t split;
+} gro_stats_t;
+
+// 初始化合并状态
+void gro_init(gro_t* gro, netif_t* netif, gro_deliver_t deliver);
+
+// 接收一帧：与正在合并的包同流时合并，否则先交付之前的包
+void gro_receive(gro_t* gro, pktbuf_t* buf);
+
+// 交付正在合并的包
+void gro_flush(gro_t* gro);
+
+// 记录合并包被拆分出的数据报数量
+void gro_count_split(int cnt);
+
+// 获取GRO统计信息
+void gro_get_stats(gro_stats_t* stats);
+
+#endif //TINY_NET_GRO_H
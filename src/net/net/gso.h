@@ -0,0 +1,14 @@
+#ifndef TINY_NET_GSO_H
+#define TINY_NET_GSO_H
+
+#include "net_cfg.h"
+#include "net_err.h"
+#include "netif.h"
+#include "pktbuf.h"
+
+// 将GSO大包按gso_size分段，分段的负载引用大包的数据块，不复制
+// 包头以大包的包头为模板逐段修正长度、标识与校验和；segs至少容纳GSO_MAX_SEGS个
+// 大包本身不释放，分段的数据块引用大包的数据区，大包可先于分段释放
+net_err_t gso_segment(netif_t* netif, pktbuf_t* buf, pktbuf_t** segs, int* cnt);
+
+#endif //TINY_NET_GSO_H
@@ -1,6 +1,7 @@
 #ifndef TINY_NET_IPV4_H
 #define TINY_NET_IPV4_H
 
+#include "arp.h"
 #include "ipaddr.h"
 #include "net_err.h"
 #include "netif.h"
@@ -89,24 +90,78 @@ typedef struct route_entry_t
     netif_t* netif;
     nlist_node_t node;
     int mask_1_cnt;
+    // 网关路由的下一跳邻居，所有经过该网关的包共用
+    arp_ref_t neigh;
+    // 手工配置的静态路由，保存到快照文件；网卡激活时自动添加的路由不保存
+    bool is_static;
 } route_entry_t;
 
+// 保存到快照文件的静态路由记录，网卡按名称对应
+typedef struct route_record_t
+{
+    char netif_name[NETIF_NAME_LEN];
+    uint8_t net[IPV4_ADDR_LEN];
+    uint8_t mask[IPV4_ADDR_LEN];
+    uint8_t next_hop[IPV4_ADDR_LEN];
+} route_record_t;
+
+// 目的地址缓存：套接字保存上次发送的路由与邻居，目的地址不变且路由表未改变时跳过查找
+typedef struct ipv4_dst_t
+{
+    ipaddr_t dest;
+    route_entry_t* route;
+    // 路由表代数，增删路由后缓存失效
+    uint32_t route_gen;
+    // 直连路由的目的邻居
+    arp_ref_t neigh;
+} ipv4_dst_t;
+
+// IP层统计，记录不属于任何网卡的事件
+typedef struct ipv4_stats_t
+{
+    // 找不到路由而丢弃的发送包数
+    uint64_t out_no_route;
+} ipv4_stats_t;
+
 net_err_t ipv4_init();
 
 void route_entry_init();
 
-void route_entry_add(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop, netif_t* netif);
+route_entry_t* route_entry_add(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop, netif_t* netif);
 
 void route_entry_remove(const ipaddr_t* net, const ipaddr_t* mask);
 
+// 添加静态路由，相同网络与掩码的路由已存在时失败；转到工作线程中执行，需在net_start之后调用
+net_err_t route_add_static(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop, netif_t* netif);
+
+// 同route_add_static，只在工作线程中调用
+net_err_t route_entry_add_static(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop,
+                                 netif_t* netif);
+
+// 导出静态路由，返回记录数量
+int route_export(route_record_t* records, int max);
+
 int ipv4_hdr_size(const ipv4_pkt_t* pkt);
 
+// 获取IP层统计信息
+void ipv4_get_stats(ipv4_stats_t* stats);
+
+// 补全发送时跳过的首部校验和，头部为主机字节序且不带选项
+void ipv4_header_csum_complete(ipv4_pkt_t* pkt);
+
 void ipv4_set_hdr_size(ipv4_pkt_t* pkt, int size);
 
 net_err_t ipv4_input(netif_t* netif, pktbuf_t* buf);
 
+// 本机回环包的IPv4输入，跳过头部与校验和验证；失败时由调用者释放buf
+net_err_t ipv4_input_local(netif_t* netif, pktbuf_t* buf);
+
 net_err_t ipv4_output(uint8_t protocol, const ipaddr_t* dest_ip, const ipaddr_t* src_ip, pktbuf_t* buf);
 
+// 带目的地址缓存的发送，dst可为NULL；缓存随发送更新
+net_err_t ipv4_output_dst(uint8_t protocol, const ipaddr_t* dest_ip, const ipaddr_t* src_ip, pktbuf_t* buf,
+                          ipv4_dst_t* dst);
+
 route_entry_t* find_route_entry(const ipaddr_t* dest_ip);
 
 #endif //TINY_NET_IPV4_H
@@ -26,26 +26,128 @@
 // 数据包缓冲区数量
 #define PKTBUF_BUF_COUNT 100
 
+// 巨帧数据区大小，单块即可容纳一个最大MTU的以太网帧
+#define PKTBUF_JUMBO_PAYLOAD_SIZE 9216
+
+// 巨帧数据区数量
+#define PKTBUF_JUMBO_BLK_COUNT 16
+
+// 剩余长度超过该值时优先使用巨帧数据区，减少块链长度；高于以太网MTU帧，普通帧不占用巨帧数据区
+#define PKTBUF_JUMBO_THRESHOLD 2048
+
 // 网络接口硬件地址长度
 #define NETIF_HWADDR_LEN 10
 
 // 网络接口名称最大长度
 #define NETIF_NAME_LEN 10
 
+// 网络接口最小MTU，IPv4要求链路至少能承载68字节
+#define NETIF_MTU_MIN 68
+
+// 网络接口最大MTU（巨帧）
+#define NETIF_MTU_MAX 9000
+
 // 网络接口输入队列大小
 #define NETIF_IN_QUEUE_SIZE 128
 
 // 网络接口输出队列大小
 #define NETIF_OUT_QUEUE_SIZE 128
 
+// 网络接口最大收发队列数量
+#define NETIF_QUEUE_MAX 4
+
+// 多队列时批量入队按队列分组的批大小
+#define NETIF_BURST_MAX 64
+
+// 每个网卡的统计槽位数量，前面的槽位由收发线程独占，最后一个由其余线程共用
+#define NETIF_STATS_SLOT_NR 8
+
+// 发送整形器每个网卡最多暂存的包数
+#define SHAPER_QUEUE_SIZE 128
+
+// 发送公平队列的子队列数量，按流哈希分配
+#define DRR_QUEUE_NR 16
+
+// 发送公平队列默认每轮额度，单位：字节，不小于一个以太网帧
+#define DRR_QUANTUM_DEFAULT 1514
+
+// 发送公平队列每个子队列默认的积压字节上限
+#define DRR_QUEUE_BYTES_DEFAULT (64 * 1024)
+
+// 可以承载VLAN子接口的父接口数量，每个父接口占用一张4096项的子接口表
+#define VLAN_PARENT_MAX 2
+
+// 入口分类规则最大数量，规则按位图匹配，不能超过32
+#define ACL_RULE_MAX 32
+
+// 聚合接口最大数量
+#define BOND_MAX 2
+
+// 每个聚合接口最多的成员数量
+#define BOND_MEMBER_MAX 4
+
+// 聚合接口检查成员载波状态的周期，单位：毫秒
+#define BOND_MONITOR_MS 100
+
+// 是否启用快速重启快照：启动时加载邻居与静态路由，运行中定期保存，1启用，默认关闭
+#define SNAPSHOT_ENABLE 0
+
+// 快照文件路径
+#define SNAPSHOT_PATH "tiny_net.snap"
+
+// 定期保存快照的间隔，单位：秒，0表示只在调用snapshot_save时保存
+#define SNAPSHOT_SAVE_PERIOD 60
+
+// 是否启用接收中断调节：按到达速率攒批后再通知工作线程，1启用，0每批立即通知
+#define RXMOD_ENABLE 1
+
+// 接收调节最大批量，单位：包
+#define RXMOD_BATCH_MAX 64
+
+// 接收调节最长等待时间，单位：微秒
+#define RXMOD_TMO_MAX_US 200
+
+// 到达速率低于该值时每个包立即通知，单位：包/秒
+#define RXMOD_LOW_PPS 10000
+
+// 到达速率达到该值时使用最长等待时间，单位：包/秒
+#define RXMOD_HIGH_PPS 200000
+
+// 到达速率采样窗口，单位：微秒
+#define RXMOD_SAMPLE_US 1000
+
+// 攒批期间工作线程检查超时的节拍，单位：毫秒；包突然停止时最多延迟这么久
+#define RXMOD_TICK_MS 1
+
+// RSS哈希密钥长度
+#define RSS_KEY_LEN 40
+
+// RSS间接表大小，必须为2的幂
+#define RSS_RETA_SIZE 128
+
+// 是否启用接收合并(GRO)，1启用，0关闭
+#define GRO_ENABLE 1
+
+// GRO单个合并包最多包含的数据报数量
+#define GRO_MAX_SEGS 16
+
+// GSO大包最多分成的段数
+#define GSO_MAX_SEGS 64
+
+// 回环接口MTU，包在内存中传递，取IP总长度上限避免分片
+#define LOOP_MTU 65535
+
 // 网络接口设备数量
 #define NETIF_DEV_CNT 10
 
 // 定时器名称最大长度
 #define TIMER_NAME_LEN 16
 
-// ARP 缓存大小
-#define ARP_CACHE_SIZE 50
+// ARP 缓存大小，须为2的幂
+#define ARP_CACHE_SIZE 64
+
+// ARP 缓存哈希表槽位数量，取缓存大小的两倍使负载不超过一半，槽位下标用掩码取模
+#define ARP_HASH_SIZE (ARP_CACHE_SIZE * 2)
 
 // ARP 最大等待发送的数据包数量
 #define ARP_MAX_PKT_WAITING 5
@@ -56,12 +158,27 @@
 // ARP 缓存项稳定状态超时时间，单位：秒
 #define ARP_ENTRY_STABLE_TMO 120
 
+// ARP 收到IPv4包时刷新已解析缓存项的最小间隔，单位：秒
+#define ARP_ENTRY_CONFIRM_TMO 10
+
 // ARP 缓存项等待解析超时时间，单位：秒
 #define ARP_ENTRY_PENDING_TMO 5
 
 // ARP 最大重试次数
 #define ARP_MAX_RETRY_COUNT 5
 
+// ARP 过期后未使用的缓存项保留时间，单位：秒
+#define ARP_ENTRY_STALE_TMO 300
+
+// ARP 过期缓存项被使用后开始单播探测前的等待时间，单位：秒
+#define ARP_ENTRY_DELAY_TMO 5
+
+// ARP 单播探测间隔，单位：秒
+#define ARP_ENTRY_PROBE_TMO 1
+
+// ARP 单播探测次数，全部失败后删除缓存项
+#define ARP_MAX_PROBE_COUNT 3
+
 // IP协议版本
 #define NET_VERSION_IPV4 4
 
@@ -71,6 +188,9 @@
 // 分片缓冲区最大数量
 #define IPV4_FRAGS_BUFFER_MAX_NR 20
 
+// 重组后IP数据报的最大长度
+#define IPV4_REASM_MAX_SIZE 65535
+
 // 原始套接字最大数量
 #define RAW_MAX_NR 64
 
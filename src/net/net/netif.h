@@ -7,6 +7,10 @@
 #include "net_cfg.h"
 #include "net_err.h"
 #include "pktbuf.h"
+#include "rss.h"
+#include "drr.h"
+#include "shaper.h"
+#include "rxmod.h"
 
 typedef struct netif_hwaddr_t
 {
@@ -27,6 +31,57 @@ typedef enum netif_type_t
     NETIF_TYPE_SIZE,
 } netif_type_t;
 
+// 网卡卸载能力：可直接发送UDP GSO大包，由网卡或内核分段
+#define NETIF_FEATURE_GSO_UDP (1 << 0)
+
+// 网卡卸载能力：可补全发送包的部分校验和
+#define NETIF_FEATURE_CSUM_PARTIAL (1 << 1)
+
+// 数据不离开内存，接收方无需验证校验和，如回环与内存网卡；校验和由驱动补全后交付
+#define NETIF_FEATURE_CSUM_SKIP (1 << 2)
+
+// 丢包原因
+typedef enum netif_drop_t
+{
+    // 收发队列已满
+    NETIF_DROP_QUEUE_FULL = 0,
+    // pktbuf不足
+    NETIF_DROP_NO_BUF,
+    // 帧或包头格式错误
+    NETIF_DROP_BAD_FRAME,
+    // 校验和错误
+    NETIF_DROP_CHECKSUM,
+    // 目的地址不是本机
+    NETIF_DROP_NOT_FOR_US,
+    // 不支持的上层协议
+    NETIF_DROP_NO_PROTO,
+    // 没有匹配的套接字
+    NETIF_DROP_NO_SOCKET,
+    // 套接字接收队列已满
+    NETIF_DROP_SOCK_FULL,
+    // 分片重组失败
+    NETIF_DROP_REASM,
+    // ARP等待队列溢出
+    NETIF_DROP_ARP_QUEUE,
+    // 链路断开或没有可用的聚合成员
+    NETIF_DROP_LINK_DOWN,
+    // 被入口分类规则丢弃
+    NETIF_DROP_ACL,
+    // 丢包原因数量
+    NETIF_DROP_NR,
+} netif_drop_t;
+
+// 网卡收发统计
+typedef struct netif_stats_t
+{
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    // 按原因分类的丢包数
+    uint64_t drops[NETIF_DROP_NR];
+} netif_stats_t;
+
 struct netif_t;
 
 typedef struct netif_open_options_t
@@ -37,12 +92,31 @@ typedef struct netif_open_options_t
     // 关闭接口函数指针
     net_err_t (*close)(struct netif_t* netif);
 
-    // 发送数据函数指针
+    // 发送数据函数指针，设置了xmit的网卡可为NULL
     net_err_t (*linkoutput)(struct netif_t* netif);
+
+    // 直接发送函数指针，可选；设置后无链路层的网卡发送不经过发送队列
+    net_err_t (*xmit)(struct netif_t* netif, pktbuf_t* buf);
+
+    // 设置接收的目的MAC地址，可选；网卡按地址过滤接收时需提供，加入聚合接口时改为聚合接口的地址
+    net_err_t (*set_rx_addr)(struct netif_t* netif, const uint8_t* addr);
+
+    // 查询载波状态，可选；返回1表示连通，0表示断开，小于0表示无法获取
+    int (*carrier)(struct netif_t* netif);
 } netif_open_options_t;
 
 struct link_layer_t;
 
+// 抓包方向
+typedef enum netif_capture_dir_t
+{
+    NETIF_CAPTURE_RX = 0,
+    NETIF_CAPTURE_TX,
+} netif_capture_dir_t;
+
+// 抓包回调，在工作线程中调用，不得修改或释放buf
+typedef void (*netif_capture_t)(struct netif_t* netif, pktbuf_t* buf, netif_capture_dir_t dir);
+
 typedef struct netif_t
 {
     // Interface name
@@ -59,22 +133,59 @@ typedef struct netif_t
     netif_type_t type;
     // 最大传输单元
     int mtu;
+    // 驱动收发缓冲区能承载的最大MTU，由驱动在打开时设置，0表示不可调整
+    int mtu_max;
+    // 卸载能力，NETIF_FEATURE_*，由驱动在打开时设置
+    uint32_t features;
+    // 统计计数，每个线程只写自己的槽位，读取时汇总
+    netif_stats_t stats[NETIF_STATS_SLOT_NR];
+    // 发送整形器，速率为0时不生效
+    shaper_t shaper;
+    // 发送公平队列，启用后代替out_q交给驱动
+    drr_t drr;
+    // 接收中断调节，决定驱动入队后何时通知工作线程
+    rxmod_t rxmod;
+    // VLAN子接口的父接口，物理接口为NULL
+    struct netif_t* vlan_parent;
+    // VLAN子接口的VLAN ID
+    uint16_t vlan_id;
+    // 父接口上按VLAN ID直接索引的子接口表，未创建子接口时为NULL
+    struct vlan_table_t* vlans;
+    // 链路状态，打开时为连通，由驱动或管理程序通过netif_set_link更新
+    bool link_up;
+    // 所属的聚合接口，作为聚合成员时收发都经过该接口，否则为NULL
+    struct netif_t* bond_master;
     // 链表节点
     nlist_node_t node;
     // 接收队列
-    fixq_t in_q;
+    fixq_t in_q[NETIF_QUEUE_MAX];
     // 接收队列私有数据指针
-    void* in_q_buf[NETIF_IN_QUEUE_SIZE];
+    void* in_q_buf[NETIF_QUEUE_MAX][NETIF_IN_QUEUE_SIZE];
     // 发送队列
-    fixq_t out_q;
+    fixq_t out_q[NETIF_QUEUE_MAX];
     // 发送队列私有数据指针
-    void* out_q_buf[NETIF_OUT_QUEUE_SIZE];
+    void* out_q_buf[NETIF_QUEUE_MAX][NETIF_OUT_QUEUE_SIZE];
+    // 使用中的接收与发送队列数量
+    int rx_queue_nr;
+    int tx_queue_nr;
+    // 下一次轮询的接收与发送队列
+    int rx_next;
+    int tx_next;
+    // 多队列时的入队通知，所有队列为空时取包方在此等待
+    sys_sem_t rx_sem;
+    sys_sem_t tx_sem;
+    // 按流哈希选择接收队列
+    rss_t rss;
     // 打开选项
     netif_open_options_t* opts;
     // 打开选项私有数据指针
     void* opts_data;
     // 链路层指针
     const struct link_layer_t* link_layer;
+    // 抓包回调，为NULL时不抓包
+    netif_capture_t capture;
+    // 抓包私有数据指针
+    void* capture_data;
 
     // 接口状态
     enum
@@ -111,6 +222,9 @@ netif_t* netif_open(const char* dev_name, const netif_open_options_t* opts, void
 // 设置网卡硬件地址
 net_err_t netif_set_hwaddr(netif_t* netif, const uint8_t* hwaddr, uint8_t hwaddr_len);
 
+// 设置网卡MTU，范围为 NETIF_MTU_MIN ~ 驱动支持的最大MTU
+net_err_t netif_set_mtu(netif_t* netif, int mtu);
+
 // 设置网卡IP地址、子网掩码和默认网关
 net_err_t netif_set_addr(netif_t* netif, const ipaddr_t* ipaddr, const ipaddr_t* netmask, const ipaddr_t* gateway);
 
@@ -126,18 +240,53 @@ net_err_t netif_close(netif_t* netif);
 // 设置默认网卡
 void netif_set_default(netif_t* netif);
 
-// 将数据包放入网卡的接收队列
+// 设置收发队列数量，在网卡激活前调用；接收队列间接表重置为轮流分配
+net_err_t netif_set_queues(netif_t* netif, int rx_queue_nr, int tx_queue_nr);
+
+// 设置接收队列的RSS密钥与间接表，参数为NULL时保持不变
+net_err_t netif_set_rss(netif_t* netif, const uint8_t* key, int key_len, const uint8_t* reta, int reta_size);
+
+// 计算数据包对应的接收队列
+int netif_rx_queue(netif_t* netif, pktbuf_t* buf);
+
+// 将数据包放入网卡的接收队列，多队列时按流哈希选择队列；GSO大包先分段
+// 以太网卡的包先过入口分类，被丢弃时释放并返回NET_ERR_OK
 net_err_t netif_put_in(netif_t* netif, pktbuf_t* buf, int tmo);
 
-// 从网卡的接收队列获取数据包
+// 本机发给自己的包放入接收队列，不经过入口分类，其余同netif_put_in
+net_err_t netif_put_in_local(netif_t* netif, pktbuf_t* buf, int tmo);
+
+// 批量放入网卡的接收队列，只通知一次工作线程，返回成功放入与被入口分类丢弃的数量
+// 未放入的包被移到 bufs[返回值, cnt) 由调用者处理
+int netif_put_in_burst(netif_t* netif, pktbuf_t** bufs, int cnt);
+
+// 从网卡的接收队列获取数据包；多队列时轮询各队列且不等待
 pktbuf_t* netif_get_in(netif_t* netif, int tmo);
 
-// 将数据包放入网卡的发送队列
+// 从指定接收队列获取数据包
+pktbuf_t* netif_get_in_q(netif_t* netif, int queue, int tmo);
+
+// 将数据包放入网卡的发送队列，多队列时按流哈希选择队列；网卡不支持GSO时大包先分段
 net_err_t netif_put_out(netif_t* netif, pktbuf_t* buf, int tmo);
 
-// 从网卡的发送队列获取数据包
+// 跳过整形器直接放入发送队列，供整形器放行时使用
+net_err_t netif_put_out_raw(netif_t* netif, pktbuf_t* buf, int tmo);
+
+// 把包交给抓包回调，调用前需确认netif->capture不为NULL；部分校验和在此补全
+void netif_capture_pkt(netif_t* netif, pktbuf_t* buf, netif_capture_dir_t dir);
+
+// 从网卡的发送队列获取数据包；多队列时轮询各队列且不等待
 pktbuf_t* netif_get_out(netif_t* netif, int tmo);
 
+// 不等待地批量获取发送包，返回获取的数量
+int netif_get_out_burst(netif_t* netif, pktbuf_t** bufs, int cnt);
+
+// 从指定发送队列获取数据包，供每个队列独立的发送线程使用
+pktbuf_t* netif_get_out_q(netif_t* netif, int queue, int tmo);
+
+// 网卡所有接收队列中积压的包数
+int netif_in_count(netif_t* netif);
+
 // 通过网卡发送数据包
 net_err_t netif_out(netif_t* netif, ipaddr_t* ipaddr, pktbuf_t* buf);
 
@@ -147,4 +296,50 @@ net_err_t netif_register_link_layer(const link_layer_t* ll);
 // 获取默认网卡
 netif_t* netif_get_default();
 
+// 按名称查找网卡，只在工作线程中调用
+netif_t* netif_find(const char* name);
+
+// 获取当前线程的统计槽位，其他模块的按线程计数也使用这个下标
+int netif_stats_slot();
+
+// 独占槽位用完后各线程共用的槽位
+#define NETIF_STATS_SLOT_SHARED (NETIF_STATS_SLOT_NR - 1)
+
+// 给槽位slot上的计数加val，共用槽位上使用原子加
+void netif_stats_add(int slot, uint64_t* counter, uint64_t val);
+
+// 记录收到的包
+void netif_stats_rx(netif_t* netif, uint32_t bytes);
+
+// 记录发出的包
+void netif_stats_tx(netif_t* netif, uint32_t bytes);
+
+// 记录一次丢包
+void netif_stats_drop(netif_t* netif, netif_drop_t reason);
+
+// 汇总各线程槽位，获取网卡统计信息
+net_err_t netif_get_stats(netif_t* netif, netif_stats_t* stats);
+
+// 设置发送整形：rate为速率(字节/秒)，burst为桶容量(字节)，rate为0时关闭；交给工作线程执行，不能在工作线程中调用
+net_err_t netif_set_shaper(netif_t* netif, uint32_t rate, uint32_t burst);
+
+// 启用发送公平队列：按流哈希分到子队列，差额轮询出队；quantum与limit为0时使用默认值
+// 只支持单发送队列的网卡，需在激活前调用
+net_err_t netif_set_drr(netif_t* netif, uint32_t quantum, uint32_t limit);
+
+// 获取发送公平队列的统计信息
+net_err_t netif_get_drr_stats(netif_t* netif, drr_stats_t* stats);
+
+// 获取发送整形器的统计信息
+net_err_t netif_get_shaper_stats(netif_t* netif, shaper_stats_t* stats);
+
+// 更新链路状态，聚合成员的变化会触发主备切换或重新分配；需在工作线程中调用
+void netif_set_link(netif_t* netif, bool up);
+
+// 工作线程处理完接收队列后调用：网卡正在攒批时启动超时检查节拍
+void netif_rxmod_schedule(netif_t* netif);
+
+// 获取接收中断调节的当前批量、等待时间与统计信息
+net_err_t netif_get_rxmod_stats(netif_t* netif, rxmod_stats_t* stats);
+
 #endif //TINY_NET_NETIF_H
@@ -8,14 +8,49 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// 外部数据区释放回调，start为数据区起始地址
+typedef void (*pktblk_release_t)(void* arg, uint8_t* start);
+
 typedef struct pktblk_t
 {
     nlist_node_t node;
     uint8_t* data;
     uint8_t payload[PKTBUF_PAYLOAD_SIZE];
     uint32_t size;
+    // 数据区起始与结束地址，内部块指向payload，外部块指向外部内存
+    uint8_t* start;
+    uint8_t* end;
+    // 外部数据区释放回调，内部块为NULL
+    pktblk_release_t release;
+    void* release_arg;
+    // 数据区引用计数，被克隆块引用时大于1，归零时才释放数据区
+    int ref;
+    // 克隆块所引用的数据区所属块，普通块为NULL
+    struct pktblk_t* owner;
 } pktblk_t;
 
+// GSO大包类型
+typedef enum pktbuf_gso_t
+{
+    // 普通包
+    PKTBUF_GSO_NONE = 0,
+    // UDP大包，按gso_size分为多个数据报
+    PKTBUF_GSO_UDP,
+} pktbuf_gso_t;
+
+// 校验和状态
+typedef enum pktbuf_csum_t
+{
+    // 校验和需要软件完整计算或验证
+    PKTBUF_CSUM_NONE = 0,
+    // 无需校验和：数据未离开内存，如回环与内存网卡
+    PKTBUF_CSUM_UNNECESSARY,
+    // 部分校验和：从csum_start起求和，结果写到csum_start + csum_offset，字段中已填入伪首部和
+    PKTBUF_CSUM_PARTIAL,
+    // 接收方向已由网卡或内核验证
+    PKTBUF_CSUM_VERIFIED,
+} pktbuf_csum_t;
+
 typedef struct pktbuf_t
 {
     uint32_t total_size;
@@ -25,8 +60,24 @@ typedef struct pktbuf_t
     pktblk_t* curr_blk;
     uint8_t* blk_offset;
     int ref_count;
+    // 包内数据报数量，GRO合并后大于1，普通包为1
+    uint16_t segs;
+    // GSO描述：大包类型与每段负载长度，包头作为各分段的包头模板
+    uint8_t gso_type;
+    uint16_t gso_size;
+    // 校验和状态，部分校验和的起始位置相对包头，随添加、移除包头调整
+    uint8_t csum_state;
+    uint16_t csum_start;
+    uint16_t csum_offset;
 } pktbuf_t;
 
+// 包数据中的一段连续区域，供驱动聚合发送(writev/sendmsg)
+typedef struct pktbuf_iovec_t
+{
+    uint8_t* base;
+    int len;
+} pktbuf_iovec_t;
+
 static pktblk_t* pktbuf_first_blk(const pktbuf_t* pktbuf)
 {
     nlist_node_t* first = nlist_first(&pktbuf->blk_list);
@@ -55,6 +106,13 @@ static inline pktblk_t* pktblock_get_prev(const pktblk_t* block)
     return nlist_entry(prev, pktblk_t, node);
 }
 
+// 校验和已验证或无需校验，接收方向可跳过软件验证；
+// 接收到的部分校验和只来自不离开内存的网卡，数据未经线路传输，同样可信
+static inline bool pktbuf_csum_trusted(const pktbuf_t* pktbuf)
+{
+    return pktbuf->csum_state != PKTBUF_CSUM_NONE;
+}
+
 static inline int pktbuf_total(const pktbuf_t* pktbuf)
 {
     return pktbuf ? (int)pktbuf->total_size : 0;
@@ -66,9 +124,21 @@ net_err_t pktbuf_init();
 // 分配pktbuf
 pktbuf_t* pktbuf_alloc(int size);
 
+// 使用外部数据区分配pktbuf，数据位于[start + offset, start + offset + size)，不复制数据
+pktbuf_t* pktbuf_alloc_ext(uint8_t* start, int capacity, int offset, int size, pktblk_release_t release, void* arg);
+
+// 批量分配pktbuf，sizes[i]为第i个包的大小，返回成功分配的数量
+int pktbuf_alloc_burst(pktbuf_t** bufs, const int* sizes, int cnt);
+
 // 释放pktbuf
 void pktbuf_free(pktbuf_t* pktbuf);
 
+// 克隆pktbuf，新包与源包共享数据区，写入共享块前先复制
+pktbuf_t* pktbuf_clone(pktbuf_t* src);
+
+// 克隆pktbuf中[offset, offset + size)的数据，新包与源包共享数据区，写入共享块前先复制
+pktbuf_t* pktbuf_clone_range(pktbuf_t* src, int offset, int size);
+
 // 添加包头
 net_err_t pktbuf_add_header(pktbuf_t* pktbuf, int size, bool is_cont);
 
@@ -81,7 +151,7 @@ net_err_t pktbuf_resize(pktbuf_t* pktbuf, int new_size);
 // 拼接两个包
 net_err_t join_pktbuf(pktbuf_t* dst, pktbuf_t* src);
 
-// 设置包头连续
+// 设置包头连续，完成后前size字节位于首块且不与其他包共享，可直接修改
 net_err_t pktbuf_set_cont(pktbuf_t* pktbuf, int size);
 
 // 重置访问位置
@@ -93,6 +163,9 @@ net_err_t pktbuf_write(pktbuf_t* pktbuf, const uint8_t* buf, int size);
 // 从pktbuf中读数据
 net_err_t pktbuf_read(pktbuf_t* pktbuf, uint8_t* buf, int size);
 
+// 按块链导出包数据的各段，不复制；返回段数，段数超过cnt时返回-1，只有一段时数据本身连续
+int pktbuf_to_iovec(const pktbuf_t* pktbuf, pktbuf_iovec_t* iov, int cnt);
+
 // 从pktbuf中窥探数据，不移动访问位置
 net_err_t pktbuf_peek(pktbuf_t* pktbuf, uint8_t* buf, int size, int offset);
 
@@ -111,4 +184,10 @@ void pktbuf_incr_ref(pktbuf_t* pktbuf);
 // 计算pktbuf的16位校验和
 uint16_t pktbuf_checksum16(pktbuf_t* buf, int size, uint32_t pre_sum, bool complement);
 
+// 标记部分校验和，由网卡或pktbuf_csum_complete补全
+void pktbuf_set_csum_partial(pktbuf_t* pktbuf, int start, int offset);
+
+// 软件补全部分校验和，完成后状态为PKTBUF_CSUM_NONE
+net_err_t pktbuf_csum_complete(pktbuf_t* pktbuf);
+
 #endif // TINY_NET_PKTBUF_H
@@ -10,6 +10,8 @@ typedef enum protocol_type_t
     PROTOCOL_TYPE_IPv4 = 0x0800,
     // IPv6 协议
     PROTOCOL_TYPE_IPv6 = 0x86DD,
+    // 802.1Q VLAN标签
+    PROTOCOL_TYPE_VLAN = 0x8100,
     // ICMP 协议
     PROTOCOL_TYPE_ICMP_V4 = 0x01,
     // ICMPv6 协议
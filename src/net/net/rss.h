@@ -0,0 +1,41 @@
+#ifndef TINY_NET_RSS_H
+#define TINY_NET_RSS_H
+
+#include <stdint.h>
+#include "net_cfg.h"
+#include "net_err.h"
+#include "pktbuf.h"
+
+typedef struct rss_t
+{
+    // Toeplitz哈希密钥
+    uint8_t key[RSS_KEY_LEN];
+    // 间接表：哈希值低位 -> 队列号
+    uint8_t reta[RSS_RETA_SIZE];
+} rss_t;
+
+// 使用默认密钥，间接表在queue_nr个队列间轮流分配
+void rss_init(rss_t* rss, int queue_nr);
+
+// 设置哈希密钥
+net_err_t rss_set_key(rss_t* rss, const uint8_t* key, int key_len);
+
+// 设置间接表，表项不能超过queue_nr；size小于RSS_RETA_SIZE时循环填充
+net_err_t rss_set_reta(rss_t* rss, const uint8_t* reta, int size, int queue_nr);
+
+// 计算Toeplitz哈希
+uint32_t rss_toeplitz(const uint8_t* key, const uint8_t* data, int len);
+
+// 以太网帧的流哈希：IPv4 TCP/UDP 取四元组，其余IPv4取地址对，非IPv4返回0
+uint32_t rss_hash_frame(const rss_t* rss, const uint8_t* frame, int len);
+
+// pktbuf中以太网帧的流哈希
+uint32_t rss_hash_pktbuf(const rss_t* rss, pktbuf_t* buf);
+
+// 由哈希值查间接表得到队列号
+static inline int rss_queue(const rss_t* rss, const uint32_t hash)
+{
+    return rss->reta[hash & (RSS_RETA_SIZE - 1)];
+}
+
+#endif //TINY_NET_RSS_H
@@ -0,0 +1,62 @@
+#ifndef TINY_NET_RXMOD_H
+#define TINY_NET_RXMOD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "net_cfg.h"
+#include "net_err.h"
+#include "nlocker.h"
+
+typedef struct rxmod_stats_t
+{
+    // 当前批量大小，1表示每批立即通知
+    uint32_t batch;
+    // 当前等待时间，单位：微秒
+    uint32_t tmo_us;
+    // 平滑后的到达速率，单位：包/秒
+    uint32_t rate_pps;
+    // 经过调节的包数
+    uint64_t packets;
+    // 通知工作线程的次数
+    uint64_t notifies;
+    // 未攒满批量、因等待超时而通知的次数
+    uint64_t timeouts;
+} rxmod_stats_t;
+
+// 接收中断调节：驱动线程入队后决定是否通知工作线程，低负载立即通知，高负载攒批
+typedef struct rxmod_t
+{
+    bool enabled;
+    nlocker_t locker;
+    // 已入队但未通知的包数
+    uint32_t pending;
+    // 第一个未通知包的入队时刻，单位：微秒
+    uint32_t pending_since;
+    // 当前采样窗口的起点与收到的包数
+    uint32_t sample_start;
+    uint32_t sample_pkts;
+    rxmod_stats_t stats;
+} rxmod_t;
+
+// 初始化调节器，初始为立即通知
+net_err_t rxmod_init(rxmod_t* rxmod);
+
+// 记录驱动放入的nr个包，返回是否需要通知工作线程
+bool rxmod_arrive(rxmod_t* rxmod, int nr);
+
+// 工作线程节拍检查：有等待超时的包时返回其包数并清除计数，由调用者通知
+int rxmod_expire(rxmod_t* rxmod);
+
+// rxmod_arrive要求通知但通知失败时调用，把这nr个包重新记为未通知，避免丢失唤醒
+void rxmod_notify_failed(rxmod_t* rxmod, int nr);
+
+// 是否正在攒批，攒批期间工作线程需定期调用rxmod_expire
+bool rxmod_active(rxmod_t* rxmod);
+
+// 获取统计信息
+void rxmod_get_stats(rxmod_t* rxmod, rxmod_stats_t* stats);
+
+// 销毁调节器
+void rxmod_destroy(rxmod_t* rxmod);
+
+#endif //TINY_NET_RXMOD_H
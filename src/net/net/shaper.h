@@ -0,0 +1,77 @@
+#ifndef TINY_NET_SHAPER_H
+#define TINY_NET_SHAPER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "net_cfg.h"
+#include "net_err.h"
+#include "pktbuf.h"
+#include "sys.h"
+#include "timer.h"
+
+struct netif_t;
+
+// 等待令牌的包及其入队时间
+typedef struct shaper_entry_t
+{
+    pktbuf_t* buf;
+    // 入队时刻，整形器时钟，单位：微秒
+    uint64_t time_us;
+} shaper_entry_t;
+
+typedef struct shaper_stats_t
+{
+    // 放行到发送队列的包数与字节数
+    uint64_t packets;
+    uint64_t bytes;
+    // 因令牌不足而排队等待的包数
+    uint64_t delayed;
+    // 暂存队列已满丢弃的包数
+    uint64_t dropped;
+    // 当前积压的包数与字节数
+    uint32_t backlog;
+    uint32_t backlog_bytes;
+    // 积压包数峰值
+    uint32_t backlog_max;
+    // 排队包的累计与最大整形延迟，单位：毫秒
+    uint64_t delay_total_ms;
+    uint32_t delay_max_ms;
+} shaper_stats_t;
+
+// 发送方向令牌桶整形器，只在工作线程中使用
+typedef struct shaper_t
+{
+    struct netif_t* netif;
+    // 令牌补充速率，单位：字节/秒，0表示不整形
+    uint32_t rate;
+    // 桶容量，单位：字节
+    uint32_t burst;
+    // 当前令牌，单位：1/1000字节；大包放行后可为负，需先补足欠额
+    int64_t tokens;
+    // 上次补充令牌的时间，单位：微秒
+    uint32_t last_us;
+    // 整形器时钟，单位：微秒，用于统计排队延迟
+    uint64_t clock_us;
+    // 等待令牌的包，环形队列
+    shaper_entry_t queue[SHAPER_QUEUE_SIZE];
+    int head;
+    int count;
+    // 令牌足够时释放排队包的节拍定时器
+    net_timer_t timer;
+    bool timer_active;
+    shaper_stats_t stats;
+} shaper_t;
+
+// 初始化整形器，默认不整形
+void shaper_init(shaper_t* shaper, struct netif_t* netif);
+
+// 设置速率与桶容量，rate为0时关闭整形并立即放行积压的包
+net_err_t shaper_config(shaper_t* shaper, uint32_t rate, uint32_t burst);
+
+// 发送一个包：令牌足够且无积压时直接放入发送队列，否则排队等待；失败时包仍由调用者释放
+net_err_t shaper_output(shaper_t* shaper, pktbuf_t* buf);
+
+// 丢弃积压的包并停止定时器
+void shaper_flush(shaper_t* shaper);
+
+#endif //TINY_NET_SHAPER_H
@@ -0,0 +1,17 @@
+#ifndef TINY_NET_SNAPSHOT_H
+#define TINY_NET_SNAPSHOT_H
+
+#include "net_err.h"
+#include "netif.h"
+
+// 加载快照文件中的邻居与静态路由，并启动定期保存
+net_err_t snapshot_init();
+
+// 在工作线程中为已激活的网卡恢复邻居与静态路由，每条记录只恢复一次；
+// 需在net_start之后调用，不能在工作线程中调用，之后新激活的网卡可再次调用恢复
+net_err_t snapshot_restore();
+
+// 在工作线程中保存快照，停机前调用；需在net_start之后调用
+net_err_t snapshot_save();
+
+#endif //TINY_NET_SNAPSHOT_H
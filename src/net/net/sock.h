@@ -2,6 +2,7 @@
 #define TINY_NET_SOCK_H
 
 #include "exmsg.h"
+#include "ipv4.h"
 #include "net_err.h"
 
 typedef int x_socklen_t;
@@ -65,6 +66,8 @@ typedef struct sock_t
     sock_wait_t* send_wait;
     sock_wait_t* conn_wait;
     nlist_node_t node;
+    // 上次发送的路由与邻居，已连接的套接字每次都能命中
+    ipv4_dst_t dst;
 } sock_t;
 
 typedef struct x_socket_t
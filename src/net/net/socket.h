@@ -37,6 +37,13 @@
 #undef IPPROTO_TCP
 #define IPPROTO_TCP        6
 
+#undef SOL_UDP
+#define SOL_UDP            17
+
+// UDP分段发送：值为每个数据报的负载长度，0关闭
+#undef UDP_SEGMENT
+#define UDP_SEGMENT        103
+
 typedef struct x_timeval
 {
     int tv_sec;
@@ -5,6 +5,8 @@
 
 void sys_time_curr (net_time_t * time);
 int sys_time_goes (net_time_t * pre);
+// 单调递增的微秒计数，用于短时间间隔测量，约71分钟回绕一次，只能取差值使用
+uint32_t sys_time_us (void);
 
 // 计数信号量相关：由具体平台实现
 sys_sem_t sys_sem_create(int init_count);
@@ -19,4 +21,8 @@ void sys_mutex_lock(sys_mutex_t mutex);
 void sys_mutex_unlock(sys_mutex_t mutex);
 int sys_mutex_is_valid(sys_mutex_t mutex);
 
+// 整个文件读写：由具体平台实现，返回读写的字节数，失败或平台不支持文件时返回-1
+int sys_file_save(const char* path, const void* data, int size);
+int sys_file_load(const char* path, void* data, int size);
+
 #endif //TINY_NET_SYS_H
\ No newline at end of file
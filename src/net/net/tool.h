@@ -64,6 +64,9 @@ static inline uint16_t net_to_host_u16(const uint16_t val)
 // 计算16位校验和
 uint16_t checksum16(const void* data, uint16_t size, uint32_t pre_sum, bool complement);
 
+// 计算伪首部的累加和（不取反），用于部分校验和的预填值
+uint16_t checksum16_pseudo_hdr(const uint8_t* src_ip, const uint8_t* dst_ip, uint8_t protocol, uint16_t len);
+
 // 计算伪首部校验和
 uint16_t checksum16_pseudo(pktbuf_t* buf, const ipaddr_t* src_ip, const ipaddr_t* dst_ip, uint8_t protocol);
 
@@ -24,12 +24,16 @@ typedef struct udp_t
     sock_t base;
     sock_wait_t recv_wait;
     nlist_t recv_list;
+    // UDP_SEGMENT选项：大于0时超长发送按此长度分为多个数据报
+    uint16_t gso_size;
 } udp_t;
 
 net_err_t upd_init();
 
 sock_t* udp_create(int family, int protocol);
 
-net_err_t upd_output(const ipaddr_t* dest_ip, uint16_t dest_port, const ipaddr_t* src_ip, uint16_t src_port, pktbuf_t* buf);
+// dst为套接字的目的地址缓存，可为NULL
+net_err_t upd_output(const ipaddr_t* dest_ip, uint16_t dest_port, const ipaddr_t* src_ip, uint16_t src_port, pktbuf_t* buf,
+                     ipv4_dst_t* dst);
 
 #endif //TINY_NET_UDP_H
@@ -0,0 +1,28 @@
+#ifndef TINY_NET_VLAN_H
+#define TINY_NET_VLAN_H
+
+#include <stdint.h>
+#include "net_err.h"
+#include "netif.h"
+#include "pktbuf.h"
+
+// VLAN ID数量，12位
+#define VLAN_ID_NR 4096
+
+// 父接口上的子接口表，按VLAN ID直接索引
+typedef struct vlan_table_t
+{
+    netif_t* netif[VLAN_ID_NR];
+    // 已创建的子接口数量，为0时释放
+    int count;
+} vlan_table_t;
+
+net_err_t vlan_init();
+
+// 在以太网父接口上创建VLAN子接口，vlan_id范围1~4094；子接口共用父接口的收发线程
+netif_t* vlan_open(netif_t* parent, uint16_t vlan_id, const char* name);
+
+// 处理父接口收到的带标签帧：去掉标签后交给对应子接口，没有子接口时丢弃
+net_err_t vlan_input(netif_t* netif, pktbuf_t* buf);
+
+#endif //TINY_NET_VLAN_H
@@ -0,0 +1,513 @@
+#include "acl.h"
+#include "dbug.h"
+#include "ether.h"
+#include "netif.h"
+#include "nlocker.h"
+#include "protocol.h"
+
+// 分类需要窥探的帧头长度：带标签的以太网头、最长IP头与端口
+#define ACL_FRAME_PEEK (sizeof(ether_vlan_header_t) + 60 + 4)
+
+// 每棵前缀树的结点上限：根结点加上每条规则最多32个结点
+#define ACL_TRIE_NODE_MAX (ACL_RULE_MAX * 32 + 1)
+
+// 端口区间上限：每条规则最多引入两个边界
+#define ACL_PORT_RANGE_MAX (ACL_RULE_MAX * 2 + 1)
+
+// 规则表读者计数的原子操作，计数与切换规则表之间需要全序
+#if defined(_MSC_VER)
+#define ACL_ATOMIC_ADD(p, v) InterlockedExchangeAdd((volatile LONG*)(p), (LONG)(v))
+#define ACL_BARRIER() MemoryBarrier()
+#else
+#define ACL_ATOMIC_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define ACL_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+// 提交时等待旧规则表读者退出的查询间隔，单位：毫秒
+#define ACL_QUIESCE_POLL_MS 1
+
+// 前缀树结点，rules为前缀在此结束的规则位图；子结点下标为0表示不存在(根结点不会是子结点)
+typedef struct acl_trie_node_t
+{
+    int16_t child[2];
+    uint32_t rules;
+} acl_trie_node_t;
+
+typedef struct acl_trie_t
+{
+    acl_trie_node_t nodes[ACL_TRIE_NODE_MAX];
+    int node_nr;
+} acl_trie_t;
+
+// 端口按边界切成互不重叠的区间，每个区间记录覆盖它的规则位图
+typedef struct acl_ports_t
+{
+    uint32_t start[ACL_PORT_RANGE_MAX];
+    uint32_t rules[ACL_PORT_RANGE_MAX];
+    int nr;
+} acl_ports_t;
+
+// 编译后的规则表：每个字段查出匹配的规则位图，按位与后最低位即优先级最高的规则
+typedef struct acl_table_t
+{
+    int rule_nr;
+    acl_action_t action[ACL_RULE_MAX];
+    // 指定以太网类型的规则
+    uint16_t type[ACL_RULE_MAX];
+    uint32_t type_rules[ACL_RULE_MAX];
+    int type_nr;
+    // 不限以太网类型的规则
+    uint32_t type_any;
+    // 不带IP层条件的规则，非IPv4帧只能匹配这些规则
+    uint32_t l3_any;
+    // 不带端口条件的规则，无端口的包只能匹配这些规则
+    uint32_t port_any;
+    acl_trie_t src_trie;
+    acl_trie_t dst_trie;
+    uint32_t protocol[256];
+    acl_ports_t src_ports;
+    acl_ports_t dst_ports;
+} acl_table_t;
+
+// 待生效的规则，只在提交时读取
+static acl_rule_t rule_edit[ACL_RULE_MAX];
+static int rule_edit_nr;
+
+// 双份规则表交替编译，驱动线程只读取生效的一份，NULL表示不分类
+static acl_table_t table_buf[2];
+static acl_table_t* volatile table_active;
+
+// 各份规则表正在分类的读者数，提交时等旧表的读者归零后才能再次编译它
+static volatile long table_readers[2];
+
+// 各份规则表的命中计数，每个线程只写自己的统计槽位
+static uint64_t rule_hits[2][NETIF_STATS_SLOT_NR][ACL_RULE_MAX];
+
+// 保护规则编辑与提交
+static nlocker_t acl_locker;
+
+// 未初始化时不分类，编辑接口直接返回错误
+static bool acl_inited = false;
+
+net_err_t acl_init()
+{
+    rule_edit_nr = 0;
+    table_active = NULL;
+    table_readers[0] = table_readers[1] = 0;
+    plat_memset(rule_hits, 0, sizeof(rule_hits));
+    net_err_t err = nlocker_init(&acl_locker, NLOCKER_TYPE_THREAD);
+    if (err != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_NETIF, "acl_init: failed to init locker");
+        return err;
+    }
+    acl_inited = true;
+    return NET_ERR_OK;
+}
+
+void acl_rule_init(acl_rule_t* rule)
+{
+    plat_memset(rule, 0, sizeof(acl_rule_t));
+    ipaddr_set_any(&rule->src_ip);
+    ipaddr_set_any(&rule->dst_ip);
+    rule->src_port_max = 0xFFFF;
+    rule->dst_port_max = 0xFFFF;
+    rule->action = ACL_ACTION_ACCEPT;
+}
+
+static bool acl_rule_has_port(const acl_rule_t* rule)
+{
+    return rule->src_port_min != 0 || rule->src_port_max != 0xFFFF ||
+        rule->dst_port_min != 0 || rule->dst_port_max != 0xFFFF;
+}
+
+net_err_t acl_add_rule(const acl_rule_t* rule)
+{
+    if (rule->src_prefix > 32 || rule->dst_prefix > 32 || rule->src_port_min > rule->src_port_max ||
+        rule->dst_port_min > rule->dst_port_max || rule->action > ACL_ACTION_COUNT)
+    {
+        dbug_error(DBG_MOD_NETIF, "acl_add_rule: invalid rule");
+        return NET_ERR_INVALID_PARAM;
+    }
+    const bool ip_cond = rule->src_prefix || rule->dst_prefix || rule->protocol || acl_rule_has_port(rule);
+    if (ip_cond && rule->ethertype != 0 && rule->ethertype != PROTOCOL_TYPE_IPv4)
+    {
+        dbug_error(DBG_MOD_NETIF, "acl_add_rule: ip conditions on ethertype 0x%04X", rule->ethertype);
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (!acl_inited)
+    {
+        dbug_error(DBG_MOD_NETIF, "acl_add_rule: acl not inited");
+        return NET_ERR_INVALID_STATE;
+    }
+
+    nlocker_lock(&acl_locker);
+    if (rule_edit_nr >= ACL_RULE_MAX)
+    {
+        nlocker_unlock(&acl_locker);
+        dbug_error(DBG_MOD_NETIF, "acl_add_rule: rule table full");
+        return NET_ERR_FULL;
+    }
+    rule_edit[rule_edit_nr++] = *rule;
+    nlocker_unlock(&acl_locker);
+    return NET_ERR_OK;
+}
+
+void acl_clear()
+{
+    if (!acl_inited)
+    {
+        return;
+    }
+    nlocker_lock(&acl_locker);
+    rule_edit_nr = 0;
+    nlocker_unlock(&acl_locker);
+}
+
+static void acl_trie_insert(acl_trie_t* trie, const uint8_t* addr, const int prefix, const uint32_t bit)
+{
+    int node = 0;
+    for (int i = 0; i < prefix; i++)
+    {
+        const int b = (addr[i / 8] >> (7 - i % 8)) & 1;
+        if (trie->nodes[node].child[b] == 0)
+        {
+            const int next = trie->node_nr++;
+            trie->nodes[next].child[0] = trie->nodes[next].child[1] = 0;
+            trie->nodes[next].rules = 0;
+            trie->nodes[node].child[b] = (int16_t)next;
+        }
+        node = trie->nodes[node].child[b];
+    }
+    trie->nodes[node].rules |= bit;
+}
+
+// 沿地址逐位下行，经过的结点上的规则前缀都与地址匹配
+static uint32_t acl_trie_lookup(const acl_trie_t* trie, const uint8_t* addr)
+{
+    int node = 0;
+    uint32_t rules = trie->nodes[0].rules;
+    for (int i = 0; i < 32; i++)
+    {
+        node = trie->nodes[node].child[(addr[i / 8] >> (7 - i % 8)) & 1];
+        if (node == 0)
+        {
+            break;
+        }
+        rules |= trie->nodes[node].rules;
+    }
+    return rules;
+}
+
+// 收集所有规则的区间边界，排序去重后计算每个区间被哪些规则覆盖
+static void acl_ports_build(acl_ports_t* ports, const uint16_t* min, const uint16_t* max, const int rule_nr)
+{
+    ports->nr = 0;
+    ports->start[ports->nr++] = 0;
+    for (int i = 0; i < rule_nr; i++)
+    {
+        const uint32_t points[2] = {min[i], (uint32_t)max[i] + 1};
+        for (int j = 0; j < 2; j++)
+        {
+            if (points[j] > 0xFFFF)
+            {
+                continue;
+            }
+            // 插入排序，边界数量很少
+            int pos = ports->nr;
+            while (pos > 0 && ports->start[pos - 1] > points[j])
+            {
+                pos--;
+            }
+            if (pos > 0 && ports->start[pos - 1] == points[j])
+            {
+                continue;
+            }
+            for (int k = ports->nr; k > pos; k--)
+            {
+                ports->start[k] = ports->start[k - 1];
+            }
+            ports->start[pos] = points[j];
+            ports->nr++;
+        }
+    }
+
+    for (int r = 0; r < ports->nr; r++)
+    {
+        ports->rules[r] = 0;
+        for (int i = 0; i < rule_nr; i++)
+        {
+            if (min[i] <= ports->start[r] && ports->start[r] <= max[i])
+            {
+                ports->rules[r] |= 1u << i;
+            }
+        }
+    }
+}
+
+// 二分查找端口所在区间
+static uint32_t acl_ports_lookup(const acl_ports_t* ports, const uint16_t port)
+{
+    int lo = 0;
+    int hi = ports->nr - 1;
+    while (lo < hi)
+    {
+        const int mid = (lo + hi + 1) / 2;
+        if (ports->start[mid] <= port)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return ports->rules[lo];
+}
+
+static void acl_compile(acl_table_t* table, const acl_rule_t* rules, const int rule_nr)
+{
+    uint16_t src_min[ACL_RULE_MAX], src_max[ACL_RULE_MAX];
+    uint16_t dst_min[ACL_RULE_MAX], dst_max[ACL_RULE_MAX];
+
+    plat_memset(table, 0, sizeof(acl_table_t));
+    table->rule_nr = rule_nr;
+    table->src_trie.node_nr = 1;
+    table->dst_trie.node_nr = 1;
+
+    for (int i = 0; i < rule_nr; i++)
+    {
+        const acl_rule_t* rule = &rules[i];
+        const uint32_t bit = 1u << i;
+        const bool port_cond = acl_rule_has_port(rule);
+        const bool ip_cond = rule->src_prefix || rule->dst_prefix || rule->protocol || port_cond;
+
+        table->action[i] = rule->action;
+
+        // 带IP层条件的规则隐含IPv4类型
+        const uint16_t type = ip_cond ? PROTOCOL_TYPE_IPv4 : rule->ethertype;
+        if (type == 0)
+        {
+            table->type_any |= bit;
+        }
+        else
+        {
+            int t = 0;
+            while (t < table->type_nr && table->type[t] != type)
+            {
+                t++;
+            }
+            if (t == table->type_nr)
+            {
+                table->type[table->type_nr++] = type;
+            }
+            table->type_rules[t] |= bit;
+        }
+
+        if (!ip_cond)
+        {
+            table->l3_any |= bit;
+        }
+        if (!port_cond)
+        {
+            table->port_any |= bit;
+        }
+
+        acl_trie_insert(&table->src_trie, rule->src_ip.a_addr, rule->src_prefix, bit);
+        acl_trie_insert(&table->dst_trie, rule->dst_ip.a_addr, rule->dst_prefix, bit);
+
+        for (int p = 0; p < 256; p++)
+        {
+            if (rule->protocol == 0 || rule->protocol == p)
+            {
+                table->protocol[p] |= bit;
+            }
+        }
+
+        src_min[i] = rule->src_port_min;
+        src_max[i] = rule->src_port_max;
+        dst_min[i] = rule->dst_port_min;
+        dst_max[i] = rule->dst_port_max;
+    }
+
+    acl_ports_build(&table->src_ports, src_min, src_max, rule_nr);
+    acl_ports_build(&table->dst_ports, dst_min, dst_max, rule_nr);
+}
+
+// 读者进入前先计数再确认规则表仍然生效，切换后等旧表计数归零即可保证没有读者在使用
+static void acl_quiesce(const int index)
+{
+    ACL_BARRIER();
+    while (table_readers[index] != 0)
+    {
+        sys_sleep(ACL_QUIESCE_POLL_MS);
+    }
+}
+
+net_err_t acl_commit()
+{
+    if (!acl_inited)
+    {
+        dbug_error(DBG_MOD_NETIF, "acl_commit: acl not inited");
+        return NET_ERR_INVALID_STATE;
+    }
+    nlocker_lock(&acl_locker);
+    acl_table_t* old = table_active;
+    if (rule_edit_nr == 0)
+    {
+        table_active = NULL;
+    }
+    else
+    {
+        // 上次提交已等待过非生效的一份，可以直接覆盖
+        const int index = old == &table_buf[0] ? 1 : 0;
+        acl_compile(&table_buf[index], rule_edit, rule_edit_nr);
+        plat_memset(rule_hits[index], 0, sizeof(rule_hits[index]));
+        ACL_BARRIER();
+        table_active = &table_buf[index];
+    }
+
+    if (old != NULL)
+    {
+        acl_quiesce((int)(old - table_buf));
+    }
+    nlocker_unlock(&acl_locker);
+    return NET_ERR_OK;
+}
+
+// 从帧头查出各字段匹配的规则位图
+static uint32_t acl_match(const acl_table_t* table, const uint8_t* frame, const int len)
+{
+    int l3 = sizeof(ether_header_t);
+    uint16_t type = frame[12] << 8 | frame[13];
+    if (type == PROTOCOL_TYPE_VLAN && len >= (int)sizeof(ether_vlan_header_t))
+    {
+        type = frame[16] << 8 | frame[17];
+        l3 = sizeof(ether_vlan_header_t);
+    }
+
+    uint32_t match = table->type_any;
+    for (int t = 0; t < table->type_nr; t++)
+    {
+        if (table->type[t] == type)
+        {
+            match |= table->type_rules[t];
+            break;
+        }
+    }
+    if (match == 0)
+    {
+        return 0;
+    }
+
+    if (type != PROTOCOL_TYPE_IPv4 || len < l3 + 20)
+    {
+        return match & table->l3_any;
+    }
+
+    const uint8_t* ip = frame + l3;
+    const int ip_hdr_len = (ip[0] & 0x0F) * 4;
+    match &= acl_trie_lookup(&table->src_trie, ip + 12);
+    match &= acl_trie_lookup(&table->dst_trie, ip + 16);
+    match &= table->protocol[ip[9]];
+
+    // 非首片没有端口，只能匹配不带端口条件的规则
+    const int frag = (ip[6] << 8 | ip[7]) & 0x1FFF;
+    if (match != 0 && frag == 0 && (ip[9] == PROTOCOL_TYPE_TCP || ip[9] == PROTOCOL_TYPE_UDP) &&
+        len >= l3 + ip_hdr_len + 4)
+    {
+        const uint8_t* port = ip + ip_hdr_len;
+        match &= acl_ports_lookup(&table->src_ports, port[0] << 8 | port[1]);
+        match &= acl_ports_lookup(&table->dst_ports, port[2] << 8 | port[3]);
+    }
+    else
+    {
+        match &= table->port_any;
+    }
+    return match;
+}
+
+static acl_action_t acl_table_classify(const acl_table_t* table, const int index, pktbuf_t* buf)
+{
+    uint8_t frame[ACL_FRAME_PEEK];
+    const int total = pktbuf_total(buf);
+    const int len = total < (int)ACL_FRAME_PEEK ? total : (int)ACL_FRAME_PEEK;
+    if (len < (int)sizeof(ether_header_t) || pktbuf_peek(buf, frame, len, 0) != NET_ERR_OK)
+    {
+        // 残帧交给以太网层检查
+        return ACL_ACTION_ACCEPT;
+    }
+
+    // 从低位(先加入的规则)开始，计数规则继续往后匹配
+    uint32_t match = acl_match(table, frame, len);
+    const int slot = netif_stats_slot();
+    for (int i = 0; match != 0; i++, match >>= 1)
+    {
+        if (!(match & 1))
+        {
+            continue;
+        }
+        netif_stats_add(slot, &rule_hits[index][slot][i], 1);
+        if (table->action[i] != ACL_ACTION_COUNT)
+        {
+            return table->action[i];
+        }
+    }
+    return ACL_ACTION_ACCEPT;
+}
+
+acl_action_t acl_classify(pktbuf_t* buf)
+{
+    if (!acl_inited)
+    {
+        return ACL_ACTION_ACCEPT;
+    }
+
+    for (;;)
+    {
+        const acl_table_t* table = table_active;
+        if (table == NULL)
+        {
+            return ACL_ACTION_ACCEPT;
+        }
+
+        // 计数后规则表已被切换时退出重试，避免使用提交者认为已无读者的旧表
+        const int index = (int)(table - table_buf);
+        ACL_ATOMIC_ADD(&table_readers[index], 1);
+        if (table != table_active)
+        {
+            ACL_ATOMIC_ADD(&table_readers[index], -1);
+            continue;
+        }
+
+        const acl_action_t action = acl_table_classify(table, index, buf);
+        ACL_ATOMIC_ADD(&table_readers[index], -1);
+        return action;
+    }
+}
+
+net_err_t acl_get_stats(acl_stats_t* stats)
+{
+    if (stats == NULL)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    plat_memset(stats, 0, sizeof(acl_stats_t));
+    const acl_table_t* table = table_active;
+    if (table == NULL)
+    {
+        return NET_ERR_OK;
+    }
+
+    const int index = (int)(table - table_buf);
+    stats->rule_nr = table->rule_nr;
+    for (int s = 0; s < NETIF_STATS_SLOT_NR; s++)
+    {
+        for (int i = 0; i < stats->rule_nr; i++)
+        {
+            stats->hits[i] += rule_hits[index][s][i];
+        }
+    }
+    return NET_ERR_OK;
+}
@@ -1,5 +1,6 @@
 #include "arp.h"
 #include "dbug.h"
+#include "exmsg.h"
 #include "ipv4.h"
 #include "mblock.h"
 #include "tool.h"
@@ -8,14 +9,26 @@
 
 #define to_scan_cnt(tmo_sec) ((tmo_sec) / ARP_TIMER_TMO)
 
+#if (ARP_HASH_SIZE & (ARP_HASH_SIZE - 1)) != 0
+#error "ARP_HASH_SIZE must be a power of two"
+#endif
+#define ARP_HASH_MASK (ARP_HASH_SIZE - 1)
+
 static net_timer_t cache_timer;
 
 static arp_entity_t cache_tbl[ARP_CACHE_SIZE];
 
 static mblock_t cache_block;
 
+// 按最近使用排序，头部最新，缓存满时淘汰尾部
 static nlist_t cache_list;
 
+// 按(网卡, IP地址)索引缓存项的开放寻址哈希表，线性探测，删除时后移补位不留墓碑
+static arp_entity_t* cache_hash[ARP_HASH_SIZE];
+
+// 缓存项代数的来源，全局递增，复用的缓存项不会与旧引用的代数相同
+static uint32_t cache_gen;
+
 // 用于初始化缓存项时的空MAC地址
 static const uint8_t empty_hwaddr[ETHER_HWADDR_LEN] = {0};
 
@@ -32,7 +45,8 @@ static void display_arp_entity(const arp_entity_t* entity)
     plat_printf("  Netif:%s ", entity->netif ? entity->netif->name : "NULL");
     plat_printf("  Timeout:%d ms ", entity->timeout);
     plat_printf("  Retry Count:%d ", entity->retry_cnt);
-    plat_printf("  State:%s ", entity->state == NET_ARP_RESOLVE ? "stable" : "pending");
+    static const char* state_name[] = {"free", "pending", "reachable", "stale", "delay", "probe", "permanent"};
+    plat_printf("  State:%s ", state_name[entity->state]);
     plat_printf("  buf:%d\n", nlist_count(&entity->buf_list));
 }
 
@@ -44,7 +58,7 @@ static void display_arp_tbl()
     arp_entity_t* entity = cache_tbl;
     for (int i = 0; i < ARP_CACHE_SIZE; i++, entity++)
     {
-        if (entity->state != NET_ARP_RESOLVE)
+        if (entity->state < NET_ARP_RESOLVE)
         {
             continue;
         }
@@ -82,6 +96,96 @@ static void display_arp_pkt(const arp_pkt_t* pkt)
 #define  display_arp_pkt(pkt)
 #endif
 
+// 哈希表中的起始位置
+static int cache_hash_home(const netif_t* netif, const uint8_t* ip)
+{
+    uint32_t key;
+    plat_memcpy(&key, ip, IPV4_ADDR_LEN);
+    key ^= (uint32_t)((uintptr_t)netif >> 4);
+    key *= 2654435761u;
+    return (int)((key >> 8) & ARP_HASH_MASK);
+}
+
+// 查找缓存项所在的哈希槽，不存在时返回探测结束处的空槽
+static int cache_hash_slot(const netif_t* netif, const uint8_t* ip)
+{
+    int slot = cache_hash_home(netif, ip);
+    while (cache_hash[slot] != NULL)
+    {
+        const arp_entity_t* entity = cache_hash[slot];
+        if (entity->netif == netif && plat_memcmp(entity->p_addr, ip, IPV4_ADDR_LEN) == 0)
+        {
+            break;
+        }
+        slot = (slot + 1) & ARP_HASH_MASK;
+    }
+    return slot;
+}
+
+// 按缓存项的网卡与IP地址加入哈希表，表大小为缓存项数量的两倍，总有空槽
+static void cache_hash_insert(arp_entity_t* entity)
+{
+    cache_hash[cache_hash_slot(entity->netif, entity->p_addr)] = entity;
+}
+
+// 从哈希表移除，之后探测链上起始位置不在空洞之后的项前移补位
+static void cache_hash_remove(const arp_entity_t* entity)
+{
+    int hole = cache_hash_slot(entity->netif, entity->p_addr);
+    if (cache_hash[hole] != entity)
+    {
+        return;
+    }
+
+    int next = hole;
+    while (1)
+    {
+        next = (next + 1) & ARP_HASH_MASK;
+        arp_entity_t* moved = cache_hash[next];
+        if (moved == NULL)
+        {
+            break;
+        }
+
+        // 起始位置在(hole, next]环形区间内的项留在原处，否则移到空洞
+        const int home = cache_hash_home(moved->netif, moved->p_addr);
+        const bool stay = hole < next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!stay)
+        {
+            cache_hash[hole] = moved;
+            hole = next;
+        }
+    }
+    cache_hash[hole] = NULL;
+}
+
+// 是否已有可用于发送的MAC地址
+static bool cache_usable(const arp_entity_t* entity)
+{
+    return entity->state >= NET_ARP_RESOLVE;
+}
+
+// 挪到LRU链表头部，表示最近使用过
+static void cache_touch(arp_entity_t* entity)
+{
+    if (nlist_first(&cache_list) != &entity->node)
+    {
+        nlist_remove(&cache_list, &entity->node);
+        nlist_insert_first(&cache_list, &entity->node);
+    }
+}
+
+// 用缓存项发送：过期的缓存项继续使用，同时开始延迟探测计时
+static void cache_use(arp_entity_t* entity)
+{
+    if (entity->state == NET_ARP_STALE)
+    {
+        entity->state = NET_ARP_DELAY;
+        entity->timeout = to_scan_cnt(ARP_ENTRY_DELAY_TMO);
+    }
+    cache_touch(entity);
+}
+
 // 释放缓存项中的等待发送的包
 static void cache_cleanup(arp_entity_t* entity)
 {
@@ -118,14 +222,20 @@ static arp_entity_t* cache_alloc(const int force)
     arp_entity_t* entity = (arp_entity_t*)mblock_alloc(&cache_block, -1);
     if (entity == NULL && force)
     {
-        // 强制分配时，释放掉最旧的缓存项
-        nlist_node_t* node = nlist_remove_last(&cache_list);
+        // 强制分配时，释放掉最旧的非静态缓存项
+        nlist_node_t* node = nlist_last(&cache_list);
+        while (node != NULL && nlist_entry(node, arp_entity_t, node)->state == NET_ARP_PERMANENT)
+        {
+            node = nlist_node_prev(node);
+        }
         if (node == NULL)
         {
             dbug_error(DBG_MOD_ARP, "cache_alloc: no free arp entity");
             return NULL;
         }
+        nlist_remove(&cache_list, node);
         entity = nlist_entry(node, arp_entity_t, node);
+        cache_hash_remove(entity);
         cache_cleanup(entity);
     }
 
@@ -134,6 +244,7 @@ static arp_entity_t* cache_alloc(const int force)
         // 重置缓存项
         plat_memset(entity, 0, sizeof(arp_entity_t));
         entity->state = NET_ARP_FREE;
+        entity->gen = ++cache_gen;
 
         // 初始化链表结点
         nlist_node_init(&entity->node);
@@ -150,22 +261,15 @@ static void cache_free(arp_entity_t* entity)
         return;
     }
     cache_cleanup(entity);
+    cache_hash_remove(entity);
     nlist_remove(&cache_list, &entity->node);
+    entity->gen = ++cache_gen;
     mblock_free(&cache_block, entity);
 }
 
-static arp_entity_t* cache_find(const uint8_t* ip)
+static arp_entity_t* cache_find(const netif_t* netif, const uint8_t* ip)
 {
-    nlist_node_t* node;
-    nlist_for_each(node, &cache_list)
-    {
-        arp_entity_t* entity = nlist_entry(node, arp_entity_t, node);
-        if (plat_memcmp(entity->p_addr, ip, IPV4_ADDR_LEN) == 0)
-        {
-            return entity;
-        }
-    }
-    return NULL;
+    return cache_hash[cache_hash_slot(netif, ip)];
 }
 
 const uint8_t* arp_find(const netif_t* netif, const ipaddr_t* addr)
@@ -186,18 +290,58 @@ const uint8_t* arp_find(const netif_t* netif, const ipaddr_t* addr)
     uint8_t ip_buffer[IPV4_ADDR_LEN];
     ipaddr_to_buf(addr, ip_buffer);
 
-    arp_entity_t* entity = cache_find(ip_buffer);
-    if (entity != NULL && entity->state == NET_ARP_RESOLVE)
+    arp_entity_t* entity = cache_find(netif, ip_buffer);
+    if (entity != NULL && cache_usable(entity))
     {
+        cache_use(entity);
         return entity->hwaddr;
     }
 
     return NULL;
 }
 
+const uint8_t* arp_ref_use(arp_ref_t* ref)
+{
+    arp_entity_t* entity = ref->entity;
+    if (entity == NULL || entity->gen != ref->gen)
+    {
+        return NULL;
+    }
+    cache_use(entity);
+    return entity->hwaddr;
+}
+
+const uint8_t* arp_ref_get(arp_ref_t* ref, const netif_t* netif, const ipaddr_t* addr)
+{
+    ref->entity = NULL;
+    if (addr->q_addr == netif->ipaddr.q_addr || is_local_broadcast_ip(addr) ||
+        is_directed_broadcast_ip(&netif->netmask, addr))
+    {
+        return NULL;
+    }
+
+    uint8_t ip_buffer[IPV4_ADDR_LEN];
+    ipaddr_to_buf(addr, ip_buffer);
+    arp_entity_t* entity = cache_find(netif, ip_buffer);
+    if (entity == NULL || !cache_usable(entity))
+    {
+        return NULL;
+    }
+
+    ref->entity = entity;
+    ref->gen = entity->gen;
+    cache_use(entity);
+    return entity->hwaddr;
+}
+
 static void cache_entity_set(arp_entity_t* entity, const uint8_t* hwaddr, const uint8_t* ip, netif_t* netif,
                              const int state)
 {
+    // MAC地址改变时旧引用失效，下次发送重新查表
+    if (plat_memcmp(entity->hwaddr, hwaddr, ETHER_HWADDR_LEN) != 0)
+    {
+        entity->gen = ++cache_gen;
+    }
     plat_memcpy(entity->hwaddr, hwaddr, ETHER_HWADDR_LEN);
     plat_memcpy(entity->p_addr, ip, IPV4_ADDR_LEN);
     entity->netif = netif;
@@ -222,7 +366,7 @@ static net_err_t cache_insert(netif_t* netif, const uint8_t* ip, const uint8_t*
     {
         return NET_ERR_INVALID_PARAM;
     }
-    arp_entity_t* entity = cache_find(ip);
+    arp_entity_t* entity = cache_find(netif, ip);
     if (entity == NULL)
     {
         entity = cache_alloc(force);
@@ -232,18 +376,18 @@ static net_err_t cache_insert(netif_t* netif, const uint8_t* ip, const uint8_t*
             return NET_ERR_MEM;
         }
         cache_entity_set(entity, hwaddr, ip, netif, NET_ARP_RESOLVE);
+        cache_hash_insert(entity);
         nlist_insert_first(&cache_list, &entity->node);
     }
+    else if (entity->state == NET_ARP_PERMANENT)
+    {
+        // 静态邻居只能由配置修改
+        return NET_ERR_OK;
+    }
     else
     {
         cache_entity_set(entity, hwaddr, ip, netif, NET_ARP_RESOLVE);
-
-        // 挪到链表头部，表示最近使用过
-        if (nlist_first(&cache_list) != &entity->node)
-        {
-            nlist_remove(&cache_list, &entity->node);
-            nlist_insert_first(&cache_list, &entity->node);
-        }
+        cache_touch(entity);
 
         net_err_t err = cache_entity_send_all(entity);
         if (err != NET_ERR_OK)
@@ -266,6 +410,10 @@ static void arp_cache_tmo(net_timer_t* timer, void* arg)
         next = nlist_node_next(curr);
 
         arp_entity_t* entity = nlist_entry(curr, arp_entity_t, node);
+        if (entity->state == NET_ARP_PERMANENT)
+        {
+            continue;
+        }
 
         if (--entity->timeout > 0) // 未超时
         {
@@ -289,11 +437,33 @@ static void arp_cache_tmo(net_timer_t* timer, void* arg)
             arp_make_request(entity->netif, &addr);
             break;
         case NET_ARP_RESOLVE:
+            // 确认过期后仍可使用，下次发送时才开始探测
             dbug_info(DBG_MOD_ARP, "state NET_ARP_RESOLVE");
-            entity->state = NET_ARP_WAITING;
-            entity->timeout = to_scan_cnt(ARP_ENTRY_PENDING_TMO);
-            entity->retry_cnt = ARP_MAX_RETRY_COUNT;
-            arp_make_request(entity->netif, &addr);
+            entity->state = NET_ARP_STALE;
+            entity->timeout = to_scan_cnt(ARP_ENTRY_STALE_TMO);
+            break;
+        case NET_ARP_STALE:
+            dbug_info(DBG_MOD_ARP, "state NET_ARP_STALE");
+            cache_free(entity);
+            break;
+        case NET_ARP_DELAY:
+            // 等待期间没有收到对方的包，开始单播探测
+            dbug_info(DBG_MOD_ARP, "state NET_ARP_DELAY");
+            entity->state = NET_ARP_PROBE;
+            entity->timeout = to_scan_cnt(ARP_ENTRY_PROBE_TMO);
+            entity->retry_cnt = ARP_MAX_PROBE_COUNT;
+            arp_make_probe(entity->netif, &addr, entity->hwaddr);
+            break;
+        case NET_ARP_PROBE:
+            dbug_info(DBG_MOD_ARP, "state NET_ARP_PROBE");
+            if (--entity->retry_cnt <= 0)
+            {
+                dbug_info(DBG_MOD_ARP, "ARP探测失败，释放缓存项");
+                cache_free(entity);
+                break;
+            }
+            entity->timeout = to_scan_cnt(ARP_ENTRY_PROBE_TMO);
+            arp_make_probe(entity->netif, &addr, entity->hwaddr);
             break;
         default:
             break;
@@ -310,6 +480,7 @@ static void arp_cache_tmo(net_timer_t* timer, void* arg)
 static net_err_t cache_init()
 {
     nlist_init(&cache_list);
+    plat_memset(cache_hash, 0, sizeof(cache_hash));
 
     net_err_t err = mblock_init(&cache_block, &cache_tbl, sizeof(arp_entity_t), ARP_CACHE_SIZE, NLOCKER_TYPE_NONE);
     if (err != NET_ERR_OK)
@@ -338,7 +509,8 @@ net_err_t arp_init()
     return NET_ERR_OK;
 }
 
-net_err_t arp_make_request(netif_t* netif, const ipaddr_t* addr)
+// 发送ARP请求，dest_mac为广播地址或探测对象的MAC地址
+static net_err_t arp_send_request(netif_t* netif, const ipaddr_t* addr, const uint8_t* dest_mac)
 {
     pktbuf_t* buf = pktbuf_alloc(sizeof(arp_pkt_t));
     if (buf == NULL)
@@ -362,7 +534,7 @@ net_err_t arp_make_request(netif_t* netif, const ipaddr_t* addr)
 
     display_arp_pkt(arp_pkt);
 
-    net_err_t err = ether_raw_out(netif, PROTOCOL_TYPE_ARP, ether_broadcast_addr(), buf);
+    net_err_t err = ether_raw_out(netif, PROTOCOL_TYPE_ARP, dest_mac, buf);
     if (err != NET_ERR_OK)
     {
         dbug_error(DBG_MOD_ARP, "ether_raw_out fail");
@@ -373,6 +545,16 @@ net_err_t arp_make_request(netif_t* netif, const ipaddr_t* addr)
     return NET_ERR_OK;
 }
 
+net_err_t arp_make_request(netif_t* netif, const ipaddr_t* addr)
+{
+    return arp_send_request(netif, addr, ether_broadcast_addr());
+}
+
+net_err_t arp_make_probe(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr)
+{
+    return arp_send_request(netif, addr, hwaddr);
+}
+
 net_err_t arp_make_gratuitous_request(netif_t* netif)
 {
     return arp_make_request(netif, &netif->ipaddr);
@@ -491,11 +673,12 @@ net_err_t arp_resolve(netif_t* netif, const ipaddr_t* addr, pktbuf_t* buf)
     uint8_t ip_buffer[IPV4_ADDR_LEN];
     ipaddr_to_buf(addr, ip_buffer);
 
-    arp_entity_t* entity = cache_find(ip_buffer);
+    arp_entity_t* entity = cache_find(netif, ip_buffer);
     if (entity != NULL)
     {
-        if (entity->state == NET_ARP_RESOLVE) // 已解析，直接发送
+        if (cache_usable(entity)) // 已解析，直接发送
         {
+            cache_use(entity);
             return ether_raw_out(netif, PROTOCOL_TYPE_IPv4, entity->hwaddr, buf);
         }
 
@@ -505,6 +688,7 @@ net_err_t arp_resolve(netif_t* netif, const ipaddr_t* addr, pktbuf_t* buf)
         if (nlist_count(&entity->buf_list) >= ARP_MAX_PKT_WAITING)
         {
             dbug_warn(DBG_MOD_ARP, "arp_resolve: waiting queue full");
+            netif_stats_drop(netif, NETIF_DROP_ARP_QUEUE);
             pktbuf_free(buf);
             return NET_ERR_FULL;
         }
@@ -524,6 +708,7 @@ net_err_t arp_resolve(netif_t* netif, const ipaddr_t* addr, pktbuf_t* buf)
     }
 
     cache_entity_set(entity, empty_hwaddr, ip_buffer, netif, NET_ARP_WAITING);
+    cache_hash_insert(entity);
 
     // 加入等待发送队列
     nlist_init(&entity->buf_list);
@@ -552,8 +737,8 @@ void arp_clear(const netif_t* netif)
 
 void arp_update_from_ip_buf(netif_t* netif,  pktbuf_t* buf)
 {
-    // 确保包是连续的
-    net_err_t err = pktbuf_set_cont(buf, sizeof(ipv4_header_t));
+    // 确保以太网头与IP头连续，之后的IPv4输入也依赖这一点
+    net_err_t err = pktbuf_set_cont(buf, sizeof(ether_header_t) + sizeof(ipv4_header_t));
     if (err != NET_ERR_OK)
     {
         dbug_error(DBG_MOD_ARP, "arp_update_from_ip_buf: pktbuf_set_cont failed, err=%d", err);
@@ -573,5 +758,137 @@ void arp_update_from_ip_buf(netif_t* netif,  pktbuf_t* buf)
     uint8_t src_ip[IPV4_ADDR_LEN];
     plat_memcpy(src_ip, &ip_hdr->src_addr, IPV4_ADDR_LEN);
 
+    // 已解析且MAC未变的邻居，距上次确认不足ARP_ENTRY_CONFIRM_TMO时不再刷新，
+    // 剩余时间由扫描计数直接判断，无需读时钟；临近过期时自然落入刷新
+    const arp_entity_t* entity = cache_find(netif, src_ip);
+    if (entity != NULL && entity->state == NET_ARP_RESOLVE &&
+        entity->timeout > to_scan_cnt(ARP_ENTRY_STABLE_TMO - ARP_ENTRY_CONFIRM_TMO) &&
+        plat_memcmp(entity->hwaddr, eth_hdr->src_mac, ETHER_HWADDR_LEN) == 0)
+    {
+        return;
+    }
+
     cache_insert(netif, src_ip, eth_hdr->src_mac, 0);
 }
+
+net_err_t arp_entry_add_static(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr)
+{
+    uint8_t ip_buffer[IPV4_ADDR_LEN];
+    ipaddr_to_buf(addr, ip_buffer);
+    if (*(uint32_t*)ip_buffer == 0)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    arp_entity_t* entity = cache_find(netif, ip_buffer);
+    if (entity == NULL)
+    {
+        entity = cache_alloc(1);
+        if (entity == NULL)
+        {
+            dbug_error(DBG_MOD_ARP, "arp_add_static: cache_alloc fail");
+            return NET_ERR_MEM;
+        }
+        cache_entity_set(entity, hwaddr, ip_buffer, netif, NET_ARP_PERMANENT);
+        cache_hash_insert(entity);
+        nlist_insert_first(&cache_list, &entity->node);
+        return NET_ERR_OK;
+    }
+
+    cache_entity_set(entity, hwaddr, ip_buffer, netif, NET_ARP_PERMANENT);
+    cache_touch(entity);
+    return cache_entity_send_all(entity);
+}
+
+// 静态邻居的配置请求，由调用线程交给工作线程执行
+typedef struct arp_static_req_t
+{
+    netif_t* netif;
+    const ipaddr_t* addr;
+    const uint8_t* hwaddr;
+} arp_static_req_t;
+
+static net_err_t arp_add_static_req_in(const func_msg_t* msg)
+{
+    const arp_static_req_t* req = msg->arg;
+    return arp_entry_add_static(req->netif, req->addr, req->hwaddr);
+}
+
+net_err_t arp_add_static(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr)
+{
+    arp_static_req_t req = {.netif = netif, .addr = addr, .hwaddr = hwaddr};
+    return exmsg_func_exec(arp_add_static_req_in, &req);
+}
+
+static net_err_t arp_remove_static_req_in(const func_msg_t* msg)
+{
+    const arp_static_req_t* req = msg->arg;
+    uint8_t ip_buffer[IPV4_ADDR_LEN];
+    ipaddr_to_buf(req->addr, ip_buffer);
+
+    arp_entity_t* entity = cache_find(req->netif, ip_buffer);
+    if (entity == NULL || entity->state != NET_ARP_PERMANENT)
+    {
+        return NET_ERR_NOT_EXIST;
+    }
+    cache_free(entity);
+    return NET_ERR_OK;
+}
+
+net_err_t arp_remove_static(const netif_t* netif, const ipaddr_t* addr)
+{
+    arp_static_req_t req = {.netif = (netif_t*)netif, .addr = addr, .hwaddr = NULL};
+    return exmsg_func_exec(arp_remove_static_req_in, &req);
+}
+
+net_err_t arp_preload(netif_t* netif, const ipaddr_t* addr, const uint8_t* hwaddr)
+{
+    uint8_t ip_buffer[IPV4_ADDR_LEN];
+    ipaddr_to_buf(addr, ip_buffer);
+    if (*(uint32_t*)ip_buffer == 0)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (cache_find(netif, ip_buffer) != NULL)
+    {
+        return NET_ERR_OK;
+    }
+
+    // 不淘汰已有缓存项，预加载的项排在最旧的位置
+    arp_entity_t* entity = cache_alloc(0);
+    if (entity == NULL)
+    {
+        return NET_ERR_FULL;
+    }
+    cache_entity_set(entity, hwaddr, ip_buffer, netif, NET_ARP_STALE);
+    entity->timeout = to_scan_cnt(ARP_ENTRY_STALE_TMO);
+    cache_hash_insert(entity);
+    nlist_insert_last(&cache_list, &entity->node);
+    return NET_ERR_OK;
+}
+
+int arp_export(arp_record_t* records, const int max)
+{
+    int nr = 0;
+    nlist_node_t* node;
+    nlist_for_each(node, &cache_list)
+    {
+        const arp_entity_t* entity = nlist_entry(node, arp_entity_t, node);
+        if (nr >= max)
+        {
+            break;
+        }
+        if (!cache_usable(entity))
+        {
+            continue;
+        }
+
+        arp_record_t* record = &records[nr++];
+        plat_memset(record, 0, sizeof(arp_record_t));
+        plat_strncpy(record->netif_name, entity->netif->name, NETIF_NAME_LEN - 1);
+        plat_memcpy(record->p_addr, entity->p_addr, IPV4_ADDR_LEN);
+        plat_memcpy(record->hwaddr, entity->hwaddr, ETHER_HWADDR_LEN);
+        record->permanent = entity->state == NET_ARP_PERMANENT;
+    }
+    return nr;
+}
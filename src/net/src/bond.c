@@ -0,0 +1,314 @@
+#include "bond.h"
+#include "arp.h"
+#include "dbug.h"
+#include "ether.h"
+#include "exmsg.h"
+#include "mblock.h"
+#include "rss.h"
+
+static bond_t bond_buffer[BOND_MAX];
+
+static mblock_t bond_mblock;
+
+net_err_t bond_init()
+{
+    return mblock_init(&bond_mblock, bond_buffer, sizeof(bond_t), BOND_MAX, NLOCKER_TYPE_THREAD);
+}
+
+// 查询各成员的载波状态，变化时更新成员链路，由netif_set_link触发切换
+static void bond_monitor(net_timer_t* timer, void* arg)
+{
+    bond_t* bond = arg;
+    for (int i = 0; i < bond->member_nr; i++)
+    {
+        netif_t* member = bond->members[i];
+        if (member->opts->carrier == NULL)
+        {
+            continue;
+        }
+
+        const int carrier = member->opts->carrier(member);
+        if (carrier >= 0)
+        {
+            netif_set_link(member, carrier != 0);
+        }
+    }
+}
+
+// 定时器链表只由工作线程访问，监视定时器的增删交给工作线程执行
+static net_err_t bond_monitor_start_req_in(const func_msg_t* msg)
+{
+    bond_t* bond = msg->arg;
+    return net_timer_add(&bond->monitor, "bond", bond_monitor, bond, BOND_MONITOR_MS, TIMER_FLAG_PERIODIC);
+}
+
+static net_err_t bond_monitor_stop_req_in(const func_msg_t* msg)
+{
+    bond_t* bond = msg->arg;
+    return net_timer_remove(&bond->monitor);
+}
+
+static net_err_t bond_netif_open(netif_t* netif, void* data)
+{
+    bond_t* bond = data;
+    net_err_t err = exmsg_func_exec(bond_monitor_start_req_in, bond);
+    if (err < 0)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_open: add monitor timer failed, err=%d", err);
+        return err;
+    }
+    bond->netif = netif;
+
+    // MTU与卸载能力在加入成员时收窄为所有成员的交集
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = ETHER_PAYLOAD_MAX_LEN;
+    netif->mtu_max = NETIF_MTU_MAX;
+    netif->features = NETIF_FEATURE_GSO_UDP | NETIF_FEATURE_CSUM_PARTIAL;
+    return NET_ERR_OK;
+}
+
+// 成员恢复为独立网卡并重新接收自己地址的帧，私有数据随之释放
+static net_err_t bond_netif_close(netif_t* netif)
+{
+    bond_t* bond = netif->opts_data;
+    exmsg_func_exec(bond_monitor_stop_req_in, bond);
+    for (int i = 0; i < bond->member_nr; i++)
+    {
+        netif_t* member = bond->members[i];
+        member->bond_master = NULL;
+        if (member->opts->set_rx_addr != NULL)
+        {
+            member->opts->set_rx_addr(member, member->hwaddr.addr);
+        }
+    }
+    mblock_free(&bond_mblock, bond);
+    return NET_ERR_OK;
+}
+
+// 为一个包选择发送成员，返回成员下标，没有可用成员时返回-1
+static int bond_select(bond_t* bond, pktbuf_t* buf)
+{
+    if (bond->mode == BOND_MODE_ACTIVE_BACKUP)
+    {
+        return bond->active;
+    }
+    if (bond->up_nr == 0)
+    {
+        return -1;
+    }
+    return bond->up[rss_hash_pktbuf(&bond->netif->rss, buf) % bond->up_nr];
+}
+
+// 发送队列中的包分配到成员的发送队列，每个用到的成员最后通知一次
+static net_err_t bond_netif_output(netif_t* netif)
+{
+    bond_t* bond = netif->opts_data;
+    bool kick[BOND_MEMBER_MAX] = {false};
+
+    pktbuf_t* buf;
+    while ((buf = netif_get_out(netif, -1)) != NULL)
+    {
+        const int index = bond_select(bond, buf);
+        if (index < 0)
+        {
+            bond->stats.tx_dropped++;
+            netif_stats_drop(netif, NETIF_DROP_LINK_DOWN);
+            pktbuf_free(buf);
+            continue;
+        }
+
+        netif_t* member = bond->members[index];
+        if (netif_put_out(member, buf, -1) != NET_ERR_OK)
+        {
+            dbug_warn(DBG_MOD_NETIF, "bond_output: %s put to member %s failed", netif->name, member->name);
+            pktbuf_free(buf);
+            continue;
+        }
+        bond->stats.tx_packets[index]++;
+        kick[index] = true;
+    }
+
+    for (int i = 0; i < bond->member_nr; i++)
+    {
+        if (kick[i])
+        {
+            bond->members[i]->opts->linkoutput(bond->members[i]);
+        }
+    }
+    return NET_ERR_OK;
+}
+
+static netif_open_options_t bond_netif_ops = {
+    .open = bond_netif_open,
+    .close = bond_netif_close,
+    .linkoutput = bond_netif_output,
+};
+
+netif_t* bond_open(const char* name, const bond_mode_t mode)
+{
+    bond_t* bond = mblock_alloc(&bond_mblock, -1);
+    if (bond == NULL)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_open: no free bond");
+        return NULL;
+    }
+    plat_memset(bond, 0, sizeof(bond_t));
+    bond->mode = mode;
+    bond->active = -1;
+
+    netif_t* netif = netif_open(name, &bond_netif_ops, bond);
+    if (netif == NULL)
+    {
+        // 打开成功后的失败已由关闭函数释放，此时netif已被设置
+        if (bond->netif == NULL)
+        {
+            mblock_free(&bond_mblock, bond);
+        }
+        return NULL;
+    }
+    return netif;
+}
+
+net_err_t bond_add_member(netif_t* netif, netif_t* member)
+{
+    if (netif->opts != &bond_netif_ops)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_add_member: %s is not a bond", netif->name);
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (netif->state != NETIF_STATE_OPENED || member->state != NETIF_STATE_OPENED)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_add_member: bond and member must be opened and inactive");
+        return NET_ERR_INVALID_STATE;
+    }
+    if (member->type != NETIF_TYPE_ETHERNET || member->opts == &bond_netif_ops || member->bond_master != NULL ||
+        member->vlan_parent != NULL || member->vlans != NULL)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_add_member: %s can not be a member", member->name);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    bond_t* bond = netif->opts_data;
+    if (bond->member_nr >= BOND_MEMBER_MAX)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_add_member: %s is full", netif->name);
+        return NET_ERR_FULL;
+    }
+
+    // 第一个成员的MAC地址作为聚合接口的地址，所有成员都用它收发
+    const uint8_t* addr = bond->member_nr == 0 ? member->hwaddr.addr : netif->hwaddr.addr;
+    if (member->opts->set_rx_addr != NULL && member->opts->set_rx_addr(member, addr) != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_NETIF, "bond_add_member: %s set rx addr failed", member->name);
+        return NET_ERR_IO;
+    }
+
+    if (bond->member_nr == 0)
+    {
+        netif_set_hwaddr(netif, member->hwaddr.addr, member->hwaddr.len);
+        netif->mtu = member->mtu;
+        netif->features &= member->features;
+    }
+    else
+    {
+        netif->mtu = member->mtu < netif->mtu ? member->mtu : netif->mtu;
+        netif->features &= member->features;
+    }
+    netif->mtu_max = netif->mtu;
+
+    member->bond_master = netif;
+    bond->members[bond->member_nr++] = member;
+    bond_link_update(netif);
+    return NET_ERR_OK;
+}
+
+void bond_link_update(netif_t* netif)
+{
+    bond_t* bond = netif->opts_data;
+
+    bond->up_nr = 0;
+    for (int i = 0; i < bond->member_nr; i++)
+    {
+        if (bond->members[i]->link_up)
+        {
+            bond->up[bond->up_nr++] = i;
+        }
+    }
+
+    // 当前成员仍可用时不切换，避免链路恢复时来回抖动
+    const int prev = bond->active;
+    if (bond->active < 0 || !bond->members[bond->active]->link_up)
+    {
+        bond->active = bond->up_nr > 0 ? bond->up[0] : -1;
+    }
+    if (bond->active == prev)
+    {
+        return;
+    }
+
+    if (prev >= 0)
+    {
+        bond->stats.failovers++;
+        dbug_warn(DBG_MOD_NETIF, "bond %s: %s down, switch to %s", netif->name, bond->members[prev]->name,
+                  bond->active >= 0 ? bond->members[bond->active]->name : "none");
+    }
+
+    // 主备切换后发送免费ARP，让交换机学习新的端口
+    if (bond->mode == BOND_MODE_ACTIVE_BACKUP && bond->active >= 0 && netif->state == NETIF_STATE_ACTIVE)
+    {
+        arp_make_gratuitous_request(netif);
+    }
+}
+
+net_err_t bond_input(netif_t* member, pktbuf_t* buf)
+{
+    netif_t* netif = member->bond_master;
+    bond_t* bond = netif->opts_data;
+
+    if (netif->state != NETIF_STATE_ACTIVE || !member->link_up)
+    {
+        netif_stats_drop(member, NETIF_DROP_LINK_DOWN);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
+    }
+
+    // 主备模式丢弃备用成员收到的帧，避免交换机泛洪时重复接收
+    if (bond->mode == BOND_MODE_ACTIVE_BACKUP && (bond->active < 0 || bond->members[bond->active] != member))
+    {
+        netif_stats_drop(member, NETIF_DROP_NOT_FOR_US);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
+    }
+
+    netif_stats_rx(netif, buf->total_size);
+    if (netif->capture)
+    {
+        netif_capture_pkt(netif, buf, NETIF_CAPTURE_RX);
+    }
+    return netif->link_layer->input(netif, buf);
+}
+
+netif_t* bond_active_member(netif_t* netif)
+{
+    if (netif->opts != &bond_netif_ops)
+    {
+        return NULL;
+    }
+
+    const bond_t* bond = netif->opts_data;
+    if (bond->mode == BOND_MODE_ACTIVE_BACKUP)
+    {
+        return bond->active >= 0 ? bond->members[bond->active] : NULL;
+    }
+    return bond->up_nr > 0 ? bond->members[bond->up[0]] : NULL;
+}
+
+net_err_t bond_get_stats(netif_t* netif, bond_stats_t* stats)
+{
+    if (netif == NULL || stats == NULL || netif->opts != &bond_netif_ops)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    *stats = ((bond_t*)netif->opts_data)->stats;
+    return NET_ERR_OK;
+}
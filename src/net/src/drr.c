@@ -0,0 +1,163 @@
+#include "drr.h"
+
+net_err_t drr_init(drr_t* drr, const uint32_t quantum, const uint32_t limit)
+{
+    if (quantum == 0 || limit == 0)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    if (nlocker_init(&drr->locker, NLOCKER_TYPE_THREAD) != NET_ERR_OK)
+    {
+        return NET_ERR_SYS;
+    }
+    drr->recv_sem = sys_sem_create(0);
+    if (drr->recv_sem == SYS_SEM_INVALID)
+    {
+        nlocker_destroy(&drr->locker);
+        return NET_ERR_SYS;
+    }
+
+    drr->quantum = quantum;
+    drr->limit = limit;
+    nlist_init(&drr->active_list);
+    for (int i = 0; i < DRR_QUEUE_NR; i++)
+    {
+        drr_queue_t* q = &drr->queues[i];
+        nlist_init(&q->buf_list);
+        nlist_node_init(&q->node);
+        q->bytes = 0;
+        q->deficit = 0;
+        q->active = false;
+    }
+    plat_memset(&drr->stats, 0, sizeof(drr_stats_t));
+    drr->enabled = true;
+    return NET_ERR_OK;
+}
+
+net_err_t drr_enqueue(drr_t* drr, pktbuf_t* buf, const uint32_t hash)
+{
+    drr_queue_t* q = &drr->queues[hash % DRR_QUEUE_NR];
+
+    nlocker_lock(&drr->locker);
+    if (q->bytes + buf->total_size > drr->limit)
+    {
+        drr->stats.dropped++;
+        nlocker_unlock(&drr->locker);
+        return NET_ERR_FULL;
+    }
+
+    nlist_insert_last(&q->buf_list, &buf->node);
+    q->bytes += buf->total_size;
+
+    // 新激活的子队列排到本轮末尾，带一个quantum的额度
+    if (!q->active)
+    {
+        q->active = true;
+        q->deficit = drr->quantum;
+        nlist_insert_last(&drr->active_list, &q->node);
+    }
+
+    drr->stats.enqueued++;
+    drr->stats.backlog++;
+    drr->stats.backlog_bytes += buf->total_size;
+    nlocker_unlock(&drr->locker);
+
+    sys_sem_notify(drr->recv_sem);
+    return NET_ERR_OK;
+}
+
+// 调用者需持有locker且已确认有积压：额度不够队首包的子队列补充quantum后移到末尾
+static pktbuf_t* drr_dequeue_locked(drr_t* drr)
+{
+    while (1)
+    {
+        nlist_node_t* node = nlist_first(&drr->active_list);
+        drr_queue_t* q = nlist_entry(node, drr_queue_t, node);
+        pktbuf_t* buf = nlist_entry(nlist_first(&q->buf_list), pktbuf_t, node);
+
+        if (q->deficit < buf->total_size)
+        {
+            q->deficit += drr->quantum;
+            nlist_remove(&drr->active_list, &q->node);
+            nlist_insert_last(&drr->active_list, &q->node);
+            continue;
+        }
+
+        nlist_remove(&q->buf_list, &buf->node);
+        q->deficit -= buf->total_size;
+        q->bytes -= buf->total_size;
+
+        // 子队列取空后退出轮询，剩余额度不保留
+        if (nlist_count(&q->buf_list) == 0)
+        {
+            q->active = false;
+            q->deficit = 0;
+            nlist_remove(&drr->active_list, &q->node);
+        }
+
+        drr->stats.dequeued++;
+        drr->stats.backlog--;
+        drr->stats.backlog_bytes -= buf->total_size;
+        return buf;
+    }
+}
+
+pktbuf_t* drr_dequeue(drr_t* drr, const int32_t timeout_ms)
+{
+    nlocker_lock(&drr->locker);
+    if (timeout_ms < 0 && drr->stats.backlog == 0)
+    {
+        nlocker_unlock(&drr->locker);
+        return NULL;
+    }
+    nlocker_unlock(&drr->locker);
+
+    if (sys_sem_wait(drr->recv_sem, (uint32_t)timeout_ms) < 0)
+    {
+        return NULL;
+    }
+
+    nlocker_lock(&drr->locker);
+    pktbuf_t* buf = drr_dequeue_locked(drr);
+    nlocker_unlock(&drr->locker);
+    return buf;
+}
+
+int drr_dequeue_burst(drr_t* drr, pktbuf_t** bufs, const int cnt)
+{
+    // 只取当前已有的包，信号量逐个扣减与入队时的通知对应
+    nlocker_lock(&drr->locker);
+    const int nr = cnt < (int)drr->stats.backlog ? cnt : (int)drr->stats.backlog;
+    nlocker_unlock(&drr->locker);
+
+    for (int i = 0; i < nr; i++)
+    {
+        sys_sem_wait(drr->recv_sem, 0);
+    }
+
+    nlocker_lock(&drr->locker);
+    for (int i = 0; i < nr; i++)
+    {
+        bufs[i] = drr_dequeue_locked(drr);
+    }
+    nlocker_unlock(&drr->locker);
+    return nr;
+}
+
+void drr_flush(drr_t* drr)
+{
+    pktbuf_t* buf;
+    while ((buf = drr_dequeue(drr, -1)) != NULL)
+    {
+        pktbuf_free(buf);
+    }
+}
+
+void drr_destroy(drr_t* drr)
+{
+    drr_flush(drr);
+    sys_sem_free(drr->recv_sem);
+    nlocker_destroy(&drr->locker);
+    drr->enabled = false;
+}
@@ -5,6 +5,8 @@
 #include "netif.h"
 #include "tool.h"
 #include "ipv4.h"
+#include "vlan.h"
+#include "bond.h"
 
 #if DBG_DISPLAY_ENABLE(DBG_MOD_ETHER)
 static void display_ether_frame(const char* title, const ether_frame_t* frame, const uint32_t frame_len)
@@ -30,6 +32,9 @@ static void display_ether_frame(const char* title, const ether_frame_t* frame, c
     case PROTOCOL_TYPE_IPv4:
         plat_printf("    协议: IPv4\n");
         break;
+    case PROTOCOL_TYPE_VLAN:
+        plat_printf("    协议: 802.1Q VLAN\n");
+        break;
     default:
         plat_printf("    协议: 未知\n");
         break;
@@ -37,9 +42,11 @@ static void display_ether_frame(const char* title, const ether_frame_t* frame, c
 }
 #endif
 
-static net_err_t frame_is_valid(const ether_frame_t* frame, const uint32_t frame_len)
+static net_err_t frame_is_valid(const netif_t* netif, const uint32_t frame_len, const int segs)
 {
-    if (frame_len < sizeof(ether_header_t) || frame_len > sizeof(ether_frame_t))
+    // 单帧上限随接口MTU变化；GRO合并的包包含多个数据报，不受单帧最大长度限制
+    const uint32_t frame_max = sizeof(ether_header_t) + (netif->mtu > 0 ? netif->mtu : ETHER_PAYLOAD_MAX_LEN);
+    if (frame_len < sizeof(ether_header_t) || (segs <= 1 && frame_len > frame_max))
     {
         return NET_ERR_FRAME;
     }
@@ -58,28 +65,41 @@ static void ether_close(netif_t* netif)
     arp_clear(netif);
 }
 
-// 输入函数指针
+// 输入函数指针，丢弃的帧在此释放并返回成功，返回错误时由调用者释放
 static net_err_t ether_input(netif_t* netif, pktbuf_t* buf)
 {
     dbug_info(DBG_MOD_ETHER, "ether_input: received pktbuf=%p, len=%d", buf, buf->total_size);
 
+    // 聚合成员收到的帧由聚合接口处理，ARP与IP只看到聚合接口
+    if (netif->bond_master != NULL)
+    {
+        return bond_input(netif, buf);
+    }
+
     // 设置包的连续性
     net_err_t err = pktbuf_set_cont(buf, sizeof(ether_header_t));
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_ETHER, "ether_input: pktbuf_set_cont failed, err=%d", err);
         pktbuf_free(buf);
-        return err;
+        return NET_ERR_OK;
     }
 
     ether_frame_t* frame = (ether_frame_t*)pktbuf_data(buf);
 
-    err = frame_is_valid(frame, buf->total_size);
+    // 带标签的帧先按VLAN ID交给子接口，长度由子接口按去掉标签后的帧检查
+    if (x_ntohs(frame->header.protocol) == PROTOCOL_TYPE_VLAN)
+    {
+        return vlan_input(netif, buf);
+    }
+
+    err = frame_is_valid(netif, buf->total_size, buf->segs);
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_ETHER, "ether_input: invalid ether frame, err=%d", err);
+        netif_stats_drop(netif, NETIF_DROP_BAD_FRAME);
         pktbuf_free(buf);
-        return err;
+        return NET_ERR_OK;
     }
 
     uint16_t protocol = x_ntohs(frame->header.protocol);
@@ -92,7 +112,7 @@ static net_err_t ether_input(netif_t* netif, pktbuf_t* buf)
         {
             dbug_warn(DBG_MOD_ETHER, "ether_input: pktbuf_remove_header failed, err=%d", err);
             pktbuf_free(buf);
-            return err;
+            return NET_ERR_OK;
         }
         return arp_in(netif, buf);
     case PROTOCOL_TYPE_IPv4:
@@ -104,11 +124,12 @@ static net_err_t ether_input(netif_t* netif, pktbuf_t* buf)
         {
             dbug_warn(DBG_MOD_ETHER, "ether_input: pktbuf_remove_header failed, err=%d", err);
             pktbuf_free(buf);
-            return err;
+            return NET_ERR_OK;
         }
         return ipv4_input(netif, buf);
     default:
         dbug_warn(DBG_MOD_ETHER, "不支持的协议 protocol 0x%04X", protocol);
+        netif_stats_drop(netif, NETIF_DROP_NO_PROTO);
         break;
     }
 
@@ -180,8 +201,13 @@ net_err_t ether_raw_out(netif_t* netif, const uint16_t protocol, const uint8_t*
         }
     }
 
-    // 添加以太网头
-    if ((err = pktbuf_add_header(buf, sizeof(ether_header_t), true)) != NET_ERR_OK)
+    // 发给自己的包不离开本机，VLAN子接口也不加标签
+    const bool to_self = plat_memcmp(netif->hwaddr.addr, dest_mac, ETHER_HWADDR_LEN) == 0;
+    const bool tagged = netif->vlan_parent != NULL && !to_self;
+
+    // 添加以太网头，VLAN子接口在源MAC后插入标签
+    const int hdr_size = tagged ? sizeof(ether_vlan_header_t) : sizeof(ether_header_t);
+    if ((err = pktbuf_add_header(buf, hdr_size, true)) != NET_ERR_OK)
     {
         dbug_error(DBG_MOD_ETHER, "ether_raw_out: pktbuf_add_header failed, err=%d", err);
         return err;
@@ -190,14 +216,24 @@ net_err_t ether_raw_out(netif_t* netif, const uint16_t protocol, const uint8_t*
     ether_frame_t* frame = (ether_frame_t*)pktbuf_data(buf);
     plat_memcpy(frame->header.dest_mac, dest_mac, ETHER_HWADDR_LEN);
     plat_memcpy(frame->header.src_mac, netif->hwaddr.addr, ETHER_HWADDR_LEN);
-    frame->header.protocol = x_htons(protocol);
+    if (tagged)
+    {
+        ether_vlan_header_t* vlan_hdr = (ether_vlan_header_t*)frame;
+        vlan_hdr->tpid = x_htons(PROTOCOL_TYPE_VLAN);
+        vlan_hdr->tci = x_htons(netif->vlan_id);
+        vlan_hdr->protocol = x_htons(protocol);
+    }
+    else
+    {
+        frame->header.protocol = x_htons(protocol);
+    }
 
     display_ether_frame("发送以太网数据包", frame, pktbuf_total(buf));
 
-    // 如果发送给自己的MAC地址，则不需要通过网卡发送，直接放入接收队列
-    if (plat_memcmp(netif->hwaddr.addr, dest_mac, ETHER_HWADDR_LEN) == 0)
+    // 如果发送给自己的MAC地址，则不需要通过网卡发送，直接放入接收队列；本机的包不做入口分类
+    if (to_self)
     {
-        return netif_put_in(netif, buf, -1);
+        return netif_put_in_local(netif, buf, -1);
     }
 
     // 将数据包放入网卡的发送队列
@@ -6,6 +6,7 @@
 #include "mblock.h"
 #include "timer.h"
 #include "ipv4.h"
+#include "gro.h"
 
 static void* msg_tbl[EXMSG_QUEUE_SIZE];
 
@@ -15,12 +16,17 @@ static exmsg_t msg_buf[EXMSG_QUEUE_SIZE];
 
 static mblock_t msg_mblock;
 
+// 待执行的延迟工作，只在工作线程中访问
+static nlist_t work_list;
+
 net_err_t exmsg_init()
 {
     dbug_info(DBG_MOD_EXMSG, "exmsg init...");
 
     net_err_t err = NET_ERR_OK;
 
+    nlist_init(&work_list);
+
     // 初始化消息内存块
     err = mblock_init(&msg_mblock, msg_buf, sizeof(exmsg_t), EXMSG_QUEUE_SIZE, NLOCKER_TYPE_THREAD);
     if (err != NET_ERR_OK)
@@ -45,29 +51,52 @@ fail:
     return err;
 }
 
+// 将一个输入包交给链路层或IPv4处理
+static net_err_t netif_input_deliver(netif_t* netif, pktbuf_t* buf)
+{
+    net_err_t err = NET_ERR_OK;
+    // 是否注册对应链路层协议处理函数
+    if (netif->link_layer != NULL)
+    {
+        err = netif->link_layer->input(netif, buf);
+    }
+    else
+    {
+        err = ipv4_input(netif, buf);
+    }
+
+    if (err != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_EXMSG, "处理输入数据包失败，err=%d", err);
+        pktbuf_free(buf);
+    }
+    return err;
+}
+
 static net_err_t do_netif_input(const exmsg_t* msg)
 {
     netif_t* netif = msg->netif.netif;
     pktbuf_t* buf;
-    while ((buf = netif_get_in(netif, -1)) != NULL)
+#if GRO_ENABLE
+    // 以太网接口先经过GRO，同一批中连续的同流包合并后再交付
+    if (netif->link_layer != NULL && netif->link_layer->type == NETIF_TYPE_ETHERNET)
     {
-        net_err_t err = NET_ERR_OK;
-        // 是否注册对应链路层协议处理函数
-        if (netif->link_layer != NULL)
-        {
-            err = netif->link_layer->input(netif, buf);
-        }
-        else
+        gro_t gro;
+        gro_init(&gro, netif, netif_input_deliver);
+        while ((buf = netif_get_in(netif, -1)) != NULL)
         {
-            err = ipv4_input(netif, buf);
-        }
-
-        if (err != NET_ERR_OK)
-        {
-            dbug_error(DBG_MOD_EXMSG, "处理输入数据包失败，err=%d", err);
-            pktbuf_free(buf);
+            gro_receive(&gro, buf);
         }
+        gro_flush(&gro);
+        netif_rxmod_schedule(netif);
+        return NET_ERR_OK;
+    }
+#endif
+    while ((buf = netif_get_in(netif, -1)) != NULL)
+    {
+        netif_input_deliver(netif, buf);
     }
+    netif_rxmod_schedule(netif);
     return NET_ERR_OK;
 }
 
@@ -83,6 +112,18 @@ static net_err_t do_func(func_msg_t* func_msg)
     return NET_ERR_OK;
 }
 
+// 执行所有延迟工作，执行中新调度的工作也在本轮完成
+static void do_deferred_work()
+{
+    nlist_node_t* node;
+    while ((node = nlist_remove_first(&work_list)) != NULL)
+    {
+        exmsg_work_t* work = nlist_entry(node, exmsg_work_t, node);
+        work->pending = false;
+        work->func(work);
+    }
+}
+
 static void work_thread(void* arg)
 {
     dbug_info(DBG_MOD_EXMSG, "exmsg work_thread started");
@@ -117,6 +158,7 @@ static void work_thread(void* arg)
             mblock_free(&msg_mblock, msg);
         }
         net_timer_check_mo(sys_time_goes(&plat_start_time));
+        do_deferred_work();
     }
 }
 
@@ -149,6 +191,23 @@ net_err_t exmsg_netif_in(netif_t* netif)
     return NET_ERR_OK;
 }
 
+void exmsg_work_init(exmsg_work_t* work, const exmsg_work_func_t func)
+{
+    nlist_node_init(&work->node);
+    work->func = func;
+    work->pending = false;
+}
+
+void exmsg_work_schedule(exmsg_work_t* work)
+{
+    if (work->pending)
+    {
+        return;
+    }
+    work->pending = true;
+    nlist_insert_last(&work_list, &work->node);
+}
+
 net_err_t exmsg_func_exec(const exmsg_func_t func, void* arg)
 {
     func_msg_t func_msg;
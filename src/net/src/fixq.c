@@ -79,6 +79,43 @@ net_err_t fixq_send(fixq_t* q, void* msg, const int32_t timeout_ms)
     return NET_ERR_OK;
 }
 
+int fixq_send_burst(fixq_t* q, void** msgs, const int cnt)
+{
+    if (q == NULL || cnt <= 0)
+    {
+        return 0;
+    }
+
+    // 与fixq_send一致，先占用发送信号量再加锁写入；不等待，只写入能占到空位的数量
+    int nr = 0;
+    while (nr < cnt && sys_sem_trywait(q->send_sem) == 0)
+    {
+        nr++;
+    }
+    if (nr == 0)
+    {
+        return 0;
+    }
+
+    nlocker_lock(&q->locker);
+    for (int i = 0; i < nr; i++)
+    {
+        q->buf[q->in++] = msgs[i];
+        if (q->in >= q->size)
+        {
+            q->in = 0;
+        }
+    }
+    q->cnt += nr;
+    nlocker_unlock(&q->locker);
+
+    for (int i = 0; i < nr; i++)
+    {
+        sys_sem_notify(q->recv_sem);
+    }
+    return nr;
+}
+
 void* fixq_recv(fixq_t* q, const int32_t timeout_ms)
 {
     if (q == NULL)
@@ -0,0 +1,157 @@
+#include "gro.h"
+#include "dbug.h"
+#include "ether.h"
+#include "ipv4.h"
+#include "udp.h"
+#include "protocol.h"
+#include "tool.h"
+#include "sys_plat.h"
+
+// 合并包总长度上限，受IP总长度字段限制
+#define GRO_IP_LEN_MAX 0xFFFF
+
+// 可合并包的头部：以太网头 + 无选项IPv4头 + UDP头
+#pragma pack(1)
+typedef struct gro_hdr_t
+{
+    ether_header_t ether;
+    ipv4_header_t ip;
+    udp_header_t udp;
+} gro_hdr_t;
+#pragma pack()
+
+static gro_stats_t gro_stats;
+
+void gro_init(gro_t* gro, netif_t* netif, const gro_deliver_t deliver)
+{
+    gro->netif = netif;
+    gro->deliver = deliver;
+    gro->head = NULL;
+    gro->ip_len = 0;
+}
+
+// 检查是否为可合并的UDP包，是则去掉帧尾填充并返回连续的头部，否则返回NULL
+static gro_hdr_t* gro_hdr_get(pktbuf_t* buf)
+{
+    if (buf->segs != 1 || buf->total_size < sizeof(gro_hdr_t))
+    {
+        return NULL;
+    }
+    if (pktbuf_set_cont(buf, sizeof(gro_hdr_t)) != NET_ERR_OK)
+    {
+        return NULL;
+    }
+
+    gro_hdr_t* hdr = (gro_hdr_t*)pktbuf_data(buf);
+    if (x_ntohs(hdr->ether.protocol) != ETHER_TYPE_IPv4)
+    {
+        return NULL;
+    }
+
+    // 只合并无选项、非分片的UDP包
+    if (hdr->ip.version != NET_VERSION_IPV4 || hdr->ip.shdr * 4 != sizeof(ipv4_header_t) ||
+        hdr->ip.protocol != PROTOCOL_TYPE_UDP || (x_ntohs(hdr->ip.frag_all) & 0x3FFF))
+    {
+        return NULL;
+    }
+
+    // UDP长度须与IP负载一致，拆分时依靠它定位数据报边界
+    int ip_len = x_ntohs(hdr->ip.total_len);
+    if (ip_len < sizeof(ipv4_header_t) + sizeof(udp_header_t) || sizeof(ether_header_t) + ip_len > buf->total_size ||
+        x_ntohs(hdr->udp.length) != ip_len - sizeof(ipv4_header_t))
+    {
+        return NULL;
+    }
+
+    // 头部校验和错误的包不合并，交给ipv4_input丢弃
+    if (hdr->ip.header_checksum && !pktbuf_csum_trusted(buf) && checksum16(&hdr->ip, sizeof(ipv4_header_t), 0, true) != 0)
+    {
+        return NULL;
+    }
+
+    if (pktbuf_resize(buf, (int)sizeof(ether_header_t) + ip_len) != NET_ERR_OK)
+    {
+        return NULL;
+    }
+    return (gro_hdr_t*)pktbuf_data(buf);
+}
+
+static bool gro_same_flow(const gro_hdr_t* a, const gro_hdr_t* b)
+{
+    return plat_memcmp(&a->ether, &b->ether, sizeof(ether_header_t)) == 0 &&
+        plat_memcmp(a->ip.src_addr, b->ip.src_addr, IPV4_ADDR_LEN) == 0 &&
+        plat_memcmp(a->ip.dest_addr, b->ip.dest_addr, IPV4_ADDR_LEN) == 0 &&
+        a->ip.tos == b->ip.tos && a->ip.ttl == b->ip.ttl &&
+        a->udp.src_port == b->udp.src_port && a->udp.dest_port == b->udp.dest_port;
+}
+
+static void gro_deliver(gro_t* gro, pktbuf_t* buf)
+{
+    gro_stats.packets_out++;
+    gro->deliver(gro->netif, buf);
+}
+
+void gro_flush(gro_t* gro)
+{
+    pktbuf_t* buf = gro->head;
+    if (buf == NULL)
+    {
+        return;
+    }
+    gro->head = NULL;
+
+    if (buf->segs > 1)
+    {
+        // 合并包的IP总长度覆盖所有数据报，重新计算头部校验和
+        gro_hdr_t* hdr = (gro_hdr_t*)pktbuf_data(buf);
+        hdr->ip.total_len = x_htons(gro->ip_len);
+        hdr->ip.header_checksum = 0;
+        hdr->ip.header_checksum = checksum16(&hdr->ip, sizeof(ipv4_header_t), 0, true);
+    }
+    gro_deliver(gro, buf);
+}
+
+void gro_receive(gro_t* gro, pktbuf_t* buf)
+{
+    gro_stats.packets_in++;
+
+    gro_hdr_t* hdr = gro_hdr_get(buf);
+    if (hdr == NULL)
+    {
+        // 不可合并的包保持顺序：先交付正在合并的包
+        gro_flush(gro);
+        gro_deliver(gro, buf);
+        return;
+    }
+
+    if (gro->head != NULL)
+    {
+        const gro_hdr_t* head_hdr = (const gro_hdr_t*)pktbuf_data(gro->head);
+        int udp_len = x_ntohs(hdr->udp.length);
+        if (gro->head->segs < GRO_MAX_SEGS && gro->ip_len + udp_len <= GRO_IP_LEN_MAX &&
+            gro_same_flow(head_hdr, hdr))
+        {
+            // 去掉以太网头和IP头，保留UDP头用于拆分时定位数据报边界
+            pktbuf_remove_header(buf, sizeof(ether_header_t) + sizeof(ipv4_header_t));
+            join_pktbuf(gro->head, buf);
+            gro->head->segs++;
+            gro->ip_len += udp_len;
+            gro_stats.merged++;
+            return;
+        }
+        gro_flush(gro);
+    }
+
+    gro->head = buf;
+    gro->ip_len = x_ntohs(hdr->ip.total_len);
+}
+
+void gro_count_split(const int cnt)
+{
+    gro_stats.split += cnt;
+}
+
+void gro_get_stats(gro_stats_t* stats)
+{
+    *stats = gro_stats;
+}
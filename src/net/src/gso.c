@@ -0,0 +1,118 @@
+#include "gso.h"
+#include "dbug.h"
+#include "ether.h"
+#include "ipv4.h"
+#include "udp.h"
+#include "protocol.h"
+#include "tool.h"
+#include "sys_plat.h"
+
+// 包头模板最大长度：带802.1Q标签的以太网头 + 带选项的IPv4头 + UDP头
+#define GSO_HDR_MAX (sizeof(ether_vlan_header_t) + 60 + sizeof(udp_header_t))
+
+net_err_t gso_segment(netif_t* netif, pktbuf_t* buf, pktbuf_t** segs, int* cnt)
+{
+    if (buf->gso_type != PKTBUF_GSO_UDP || buf->gso_size == 0)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    // 读出包头模板
+    uint8_t tmpl[GSO_HDR_MAX];
+    int l2_len = 0;
+    net_err_t err;
+    if (netif->type == NETIF_TYPE_ETHERNET)
+    {
+        // VLAN子接口发出的帧已带802.1Q标签，链路层头长度按帧中的类型字段确定
+        if ((err = pktbuf_peek(buf, tmpl, sizeof(ether_header_t), 0)) != NET_ERR_OK)
+        {
+            return err;
+        }
+        const ether_header_t* ether_hdr = (const ether_header_t*)tmpl;
+        l2_len = x_ntohs(ether_hdr->protocol) == PROTOCOL_TYPE_VLAN ? (int)sizeof(ether_vlan_header_t)
+                                                                    : (int)sizeof(ether_header_t);
+    }
+    err = pktbuf_peek(buf, tmpl, l2_len + (int)sizeof(ipv4_header_t), 0);
+    if (err != NET_ERR_OK)
+    {
+        return err;
+    }
+    ipv4_header_t* ip_hdr = (ipv4_header_t*)(tmpl + l2_len);
+    const int ip_len = ip_hdr->shdr * 4;
+    const int hdr_len = l2_len + ip_len + (int)sizeof(udp_header_t);
+    if (ip_len < sizeof(ipv4_header_t) || (err = pktbuf_peek(buf, tmpl, hdr_len, 0)) != NET_ERR_OK)
+    {
+        return NET_ERR_FRAME;
+    }
+    udp_header_t* udp_hdr = (udp_header_t*)(tmpl + l2_len + ip_len);
+
+    const int gso_size = buf->gso_size;
+    const int payload = (int)buf->total_size - hdr_len;
+    if (payload <= 0 || (payload + gso_size - 1) / gso_size > GSO_MAX_SEGS)
+    {
+        dbug_warn(DBG_MOD_NETIF, "gso_segment: bad payload %d for gso_size %d", payload, gso_size);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    ipaddr_t src_ip, dest_ip;
+    ipaddr_from_buf(&src_ip, ip_hdr->src_addr);
+    ipaddr_from_buf(&dest_ip, ip_hdr->dest_addr);
+    const uint16_t id = x_ntohs(ip_hdr->id);
+
+    int nr = 0;
+    for (int offset = 0; offset < payload; offset += gso_size)
+    {
+        const int seg_size = payload - offset > gso_size ? gso_size : payload - offset;
+        pktbuf_t* seg = pktbuf_clone_range(buf, hdr_len + offset, seg_size);
+        if (seg == NULL)
+        {
+            err = NET_ERR_MEM;
+            goto segment_failed;
+        }
+        const uint16_t seg_id = (uint16_t)(id + nr);
+        segs[nr++] = seg;
+
+        // 逐层添加包头，新块位于共享数据之前
+        if ((err = pktbuf_add_header(seg, sizeof(udp_header_t), true)) != NET_ERR_OK)
+        {
+            goto segment_failed;
+        }
+        udp_header_t* udp = (udp_header_t*)pktbuf_data(seg);
+        plat_memcpy(udp, udp_hdr, sizeof(udp_header_t));
+        udp->length = x_htons(sizeof(udp_header_t) + seg_size);
+        udp->checksum = 0;
+        udp->checksum = checksum16_pseudo(seg, &src_ip, &dest_ip, PROTOCOL_TYPE_UDP);
+
+        if ((err = pktbuf_add_header(seg, ip_len, true)) != NET_ERR_OK)
+        {
+            goto segment_failed;
+        }
+        ipv4_header_t* ip = (ipv4_header_t*)pktbuf_data(seg);
+        plat_memcpy(ip, ip_hdr, ip_len);
+        ip->total_len = x_htons(ip_len + sizeof(udp_header_t) + seg_size);
+        ip->id = x_htons(seg_id);
+        ip->header_checksum = 0;
+        ip->header_checksum = checksum16(ip, ip_len, 0, true);
+
+        if (l2_len)
+        {
+            if ((err = pktbuf_add_header(seg, l2_len, true)) != NET_ERR_OK)
+            {
+                goto segment_failed;
+            }
+            plat_memcpy(pktbuf_data(seg), tmpl, l2_len);
+        }
+        pktbuf_reset_access(seg);
+    }
+
+    *cnt = nr;
+    return NET_ERR_OK;
+
+segment_failed:
+    dbug_error(DBG_MOD_NETIF, "gso_segment: segment %d failed, err=%d", nr, err);
+    while (nr > 0)
+    {
+        pktbuf_free(segs[--nr]);
+    }
+    return err;
+}
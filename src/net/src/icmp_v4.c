@@ -7,10 +7,9 @@
 static net_err_t icmp_v4_output(const ipaddr_t* dest_ip, const ipaddr_t* src_ip, pktbuf_t* buf)
 {
     icmp_v4_pkt_t* icmp_pkt = (icmp_v4_pkt_t*)pktbuf_data(buf);
-    // 重置访问位置
-    pktbuf_reset_access(buf);
-    // 计算校验和
-    icmp_pkt->header.checksum = pktbuf_checksum16(buf, (int)buf->total_size, 0, true);
+    // 校验和推迟到发送前由网卡或软件补全
+    icmp_pkt->header.checksum = 0;
+    pktbuf_set_csum_partial(buf, 0, offsetof(icmp_v4_header_t, checksum));
     return ipv4_output(PROTOCOL_TYPE_ICMP_V4, dest_ip, src_ip, buf);
 }
 
@@ -23,6 +22,12 @@ static net_err_t is_icmp_v4_pkt_valid(const icmp_v4_pkt_t* pkt, const uint32_t s
         return NET_ERR_FRAME;
     }
 
+    // 网卡已验证或未离开内存的包无需计算
+    if (pktbuf_csum_trusted(buf))
+    {
+        return NET_ERR_OK;
+    }
+
     // 计算校验和
     uint16_t checksum = pktbuf_checksum16(buf, (int)size, 0, true);
     if (checksum != 0)
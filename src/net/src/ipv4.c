@@ -1,10 +1,13 @@
 #include "ipv4.h"
 #include "dbug.h"
+#include "exmsg.h"
 #include "protocol.h"
 #include "tool.h"
 #include "icmp_v4.h"
 #include "mblock.h"
 #include "raw.h"
+#include "udp.h"
+#include "gro.h"
 
 static uint16_t packet_id = 0;
 
@@ -20,6 +23,11 @@ static route_entry_t route_table[IPV4_ROUTE_TABLE_MAX_NR];
 
 static mblock_t route_table_mblock;
 
+// 路由表代数，增删路由时递增，使套接字的目的地址缓存失效
+static uint32_t route_gen;
+
+static ipv4_stats_t ipv4_stats;
+
 static net_err_t fragment_init()
 {
     nlist_init(&fragment_list);
@@ -274,7 +282,7 @@ err_return:
     return NULL;
 }
 
-static net_err_t ipv4_pkt_is_valid(const ipv4_pkt_t* pkt, const uint32_t size, netif_t* netif)
+static net_err_t ipv4_pkt_is_valid(const ipv4_pkt_t* pkt, const uint32_t size, netif_t* netif, const bool csum_trusted)
 {
     // 检查版本号
     if (pkt->header.version != NET_VERSION_IPV4)
@@ -298,8 +306,8 @@ static net_err_t ipv4_pkt_is_valid(const ipv4_pkt_t* pkt, const uint32_t size, n
     }
 
 
-    // 检查校验和
-    if (pkt->header.header_checksum)
+    // 检查校验和，已验证或未离开内存的包跳过
+    if (pkt->header.header_checksum && !csum_trusted)
     {
         uint16_t checksum = checksum16(&pkt->header, hdr_len, 0, true);
         if (checksum != 0)
@@ -312,6 +320,110 @@ static net_err_t ipv4_pkt_is_valid(const ipv4_pkt_t* pkt, const uint32_t size, n
     return NET_ERR_OK;
 }
 
+// UDP输入，当前只回复端口不可达
+static net_err_t ip_udp_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t* src_ip)
+{
+    ipv4_pkt_t* ipv4_pkt = (ipv4_pkt_t*)pktbuf_data(buf);
+    netif_stats_drop(netif, NETIF_DROP_NO_SOCKET);
+    // 测试端口不可达
+    ipv4_header_ntohs(&ipv4_pkt->header);
+    return icmp_v4_output_unreach(src_ip, &netif->ipaddr, ICMP_V4_CODE_UNREACH_PORT, buf);
+}
+
+// 按上层协议返回的错误记录丢包原因，UDP已在ip_udp_input中计数
+static void ip_input_count_drop(netif_t* netif, const net_err_t err)
+{
+    switch (err)
+    {
+    case NET_ERR_CHECKSUM:
+        netif_stats_drop(netif, NETIF_DROP_CHECKSUM);
+        break;
+    case NET_ERR_TARGET_ADDR_MATCH:
+        netif_stats_drop(netif, NETIF_DROP_NO_SOCKET);
+        break;
+    case NET_ERR_FULL:
+        netif_stats_drop(netif, NETIF_DROP_SOCK_FULL);
+        break;
+    case NET_ERR_MEM:
+        netif_stats_drop(netif, NETIF_DROP_NO_BUF);
+        break;
+    default:
+        break;
+    }
+}
+
+// GRO合并的UDP包按UDP长度拆回单个数据报，每个数据报带上修正后的IP头逐个处理
+static net_err_t ip_udp_gro_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t* src_ip)
+{
+    ipv4_header_t hdr;
+    plat_memcpy(&hdr, pktbuf_data(buf), sizeof(ipv4_header_t));
+
+    net_err_t err = NET_ERR_OK;
+    int offset = sizeof(ipv4_header_t);
+    int cnt = 0;
+    while (offset < (int)buf->total_size)
+    {
+        udp_header_t udp_hdr;
+        if ((err = pktbuf_peek(buf, (uint8_t*)&udp_hdr, sizeof(udp_header_t), offset)) != NET_ERR_OK)
+        {
+            break;
+        }
+
+        int udp_len = x_ntohs(udp_hdr.length);
+        if (udp_len < sizeof(udp_header_t) || offset + udp_len > (int)buf->total_size)
+        {
+            dbug_warn(DBG_MOD_IPV4, "ip_udp_gro_input: invalid udp length %d at offset %d", udp_len, offset);
+            netif_stats_drop(netif, NETIF_DROP_BAD_FRAME);
+            err = NET_ERR_FRAME;
+            break;
+        }
+
+        // 数据报与大包共享数据块，只为IP头分配新块
+        pktbuf_t* seg = pktbuf_clone_range(buf, offset, udp_len);
+        if (seg == NULL)
+        {
+            dbug_error(DBG_MOD_IPV4, "ip_udp_gro_input: no free pktbuf");
+            err = NET_ERR_MEM;
+            break;
+        }
+        if ((err = pktbuf_add_header(seg, sizeof(ipv4_header_t), true)) != NET_ERR_OK)
+        {
+            dbug_error(DBG_MOD_IPV4, "ip_udp_gro_input: add ip header failed");
+            pktbuf_free(seg);
+            break;
+        }
+
+        // 头部字段为主机字节序，校验和需按网络字节序计算
+        hdr.total_len = sizeof(ipv4_header_t) + udp_len;
+        hdr.header_checksum = 0;
+        ipv4_header_htonl(&hdr);
+        hdr.header_checksum = checksum16(&hdr, sizeof(ipv4_header_t), 0, true);
+        ipv4_header_ntohs(&hdr);
+
+        plat_memcpy(pktbuf_data(seg), &hdr, sizeof(ipv4_header_t));
+
+        err = ip_udp_input(netif, seg, src_ip);
+        pktbuf_free(seg);
+        if (err != NET_ERR_OK)
+        {
+            break;
+        }
+        offset += udp_len;
+        cnt++;
+    }
+
+    gro_count_split(cnt);
+
+    // 拆分中途失败时剩余数据报随大包一起丢弃，大包已在此消费，调用者不再释放
+    if (err != NET_ERR_OK)
+    {
+        dbug_warn(DBG_MOD_IPV4, "ip_udp_gro_input: split stopped after %d datagrams, err=%d", cnt, err);
+        ip_input_count_drop(netif, err);
+    }
+    pktbuf_free(buf);
+    return NET_ERR_OK;
+}
+
 static net_err_t ip_normal_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t* src_ip, const ipaddr_t* dest_ip)
 {
     ipv4_pkt_t* ipv4_pkt = (ipv4_pkt_t*)pktbuf_data(buf);
@@ -323,9 +435,15 @@ static net_err_t ip_normal_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t*
         err = icmp_v4_input(src_ip, &netif->ipaddr, buf);
         break;
     case PROTOCOL_TYPE_UDP: // UDP
-        // 测试端口不可达
-        ipv4_header_ntohs(&ipv4_pkt->header);
-        err = icmp_v4_output_unreach(src_ip, &netif->ipaddr, ICMP_V4_CODE_UNREACH_PORT, buf);
+        // UDP按数据报处理，GRO合并的包先拆分
+        if (buf->segs > 1)
+        {
+            err = ip_udp_gro_input(netif, buf, src_ip);
+        }
+        else
+        {
+            err = ip_udp_input(netif, buf, src_ip);
+        }
         break;
     case PROTOCOL_TYPE_TCP: // TCP
         break;
@@ -337,6 +455,7 @@ static net_err_t ip_normal_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t*
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_IPV4, "ip_normal_input: protocol %d input failed, err=%d", ipv4_pkt->header.protocol, err);
+        ip_input_count_drop(netif, err);
     }
     return err;
 }
@@ -385,10 +504,23 @@ static net_err_t ip_fragment_insert(ip_fragment_t* fragment, pktbuf_t* buf, cons
     return NET_ERR_OK;
 }
 
-// 处理分片包输入
+// 处理分片包输入，丢弃的分片在此计数并释放，调用者不再持有buf
 static net_err_t ip_fragment_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t* src_ip, const ipaddr_t* dest_ip)
 {
     ipv4_pkt_t* ipv4_pkt = (ipv4_pkt_t*)pktbuf_data(buf);
+
+    // 单个分片不超过接收接口MTU，重组结果不超过数据报长度上限
+    const int frag_end = get_fragment_start(ipv4_pkt) + get_fragment_data_size(ipv4_pkt);
+    if (ipv4_pkt->header.total_len > netif->mtu ||
+        frag_end + ipv4_hdr_size(ipv4_pkt) > IPV4_REASM_MAX_SIZE)
+    {
+        dbug_warn(DBG_MOD_IPV4, "ip_fragment_input: fragment out of range, len=%d, end=%d, mtu=%d",
+                  ipv4_pkt->header.total_len, frag_end, netif->mtu);
+        netif_stats_drop(netif, NETIF_DROP_BAD_FRAME);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
+    }
+
     ip_fragment_t* frag = fragment_find(src_ip, ipv4_pkt->header.id);
     if (frag == NULL)
     {
@@ -396,26 +528,33 @@ static net_err_t ip_fragment_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t
         if (frag == NULL)
         {
             dbug_error(DBG_MOD_IPV4, "ip_fragment_input: fragment_alloc failed");
-            return NET_ERR_MEM;
+            netif_stats_drop(netif, NETIF_DROP_REASM);
+            pktbuf_free(buf);
+            return NET_ERR_OK;
         }
         fragment_add(frag, src_ip, ipv4_pkt->header.id);
     }
 
+    // 插入失败时buf未挂入分片链表
     net_err_t err = ip_fragment_insert(frag, buf, ipv4_pkt);
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_IPV4, "ip_fragment_input: ip_fragment_insert failed, err=%d", err);
-        return err;
+        netif_stats_drop(netif, NETIF_DROP_REASM);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
     }
 
     // 是否所有分片到达
     if (fragment_is_all_arrived(frag))
     {
+        // 合并失败时所有分片已随分片结构一起释放
         pktbuf_t* joined_buf = fragment_join(frag);
         if (joined_buf == NULL)
         {
             dbug_error(DBG_MOD_IPV4, "ip_fragment_input: fragment_join failed");
-            return NET_ERR_MEM;
+            netif_stats_drop(netif, NETIF_DROP_REASM);
+            return NET_ERR_OK;
         }
         fragment_free(frag);
         err = ip_normal_input(netif, joined_buf, src_ip, dest_ip);
@@ -423,7 +562,7 @@ static net_err_t ip_fragment_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t
         {
             dbug_warn(DBG_MOD_IPV4, "ip_fragment_input: ip_normal_input failed, err=%d", err);
             pktbuf_free(joined_buf);
-            return err;
+            return NET_ERR_OK;
         }
     }
 
@@ -431,6 +570,24 @@ static net_err_t ip_fragment_input(netif_t* netif, pktbuf_t* buf, const ipaddr_t
     return NET_ERR_OK;
 }
 
+void ipv4_get_stats(ipv4_stats_t* stats)
+{
+    *stats = ipv4_stats;
+}
+
+void ipv4_header_csum_complete(ipv4_pkt_t* pkt)
+{
+    if (pkt->header.header_checksum != 0 || ipv4_hdr_size(pkt) != sizeof(ipv4_header_t))
+    {
+        return;
+    }
+
+    // 校验和按网络字节序计算
+    ipv4_header_t hdr = pkt->header;
+    ipv4_header_htonl(&hdr);
+    pkt->header.header_checksum = x_ntohs(checksum16(&hdr, sizeof(ipv4_header_t), 0, true));
+}
+
 int ipv4_hdr_size(const ipv4_pkt_t* pkt)
 {
     return pkt->header.shdr * 4;
@@ -464,13 +621,13 @@ void route_entry_init()
 }
 
 
-void route_entry_add(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop, netif_t* netif)
+route_entry_t* route_entry_add(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop, netif_t* netif)
 {
     route_entry_t* entry = mblock_alloc(&route_table_mblock, -1);
     if (entry == NULL)
     {
         dbug_error(DBG_MOD_IPV4, "route_entry_add: mblock_alloc failed");
-        return;
+        return NULL;
     }
 
     ipaddr_copy(&entry->net, net);
@@ -478,10 +635,14 @@ void route_entry_add(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t*
     ipaddr_copy(&entry->next_hop, next_hop);
     entry->netif = netif;
     entry->mask_1_cnt = ipaddr_1_count(mask);
+    plat_memset(&entry->neigh, 0, sizeof(arp_ref_t));
+    entry->is_static = false;
+    route_gen++;
 
     nlist_node_init(&entry->node);
     nlist_insert_last(&route_list, &entry->node);
     display_ipv4_route_table();
+    return entry;
 }
 
 void route_entry_remove(const ipaddr_t* net, const ipaddr_t* mask)
@@ -494,12 +655,106 @@ void route_entry_remove(const ipaddr_t* net, const ipaddr_t* mask)
         {
             nlist_remove(&route_list, &entry->node);
             mblock_free(&route_table_mblock, entry);
+            route_gen++;
             return;
         }
     }
     display_ipv4_route_table();
 }
 
+net_err_t route_entry_add_static(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop,
+                                 netif_t* netif)
+{
+    nlist_node_t* node;
+    nlist_for_each(node, &route_list)
+    {
+        const route_entry_t* entry = nlist_entry(node, route_entry_t, node);
+        if (ipaddr_is_equal(&entry->net, net) && ipaddr_is_equal(&entry->mask, mask))
+        {
+            dbug_warn(DBG_MOD_IPV4, "route_add_static: route already exists");
+            return NET_ERR_EXIST;
+        }
+    }
+
+    route_entry_t* entry = route_entry_add(net, mask, next_hop, netif);
+    if (entry == NULL)
+    {
+        return NET_ERR_FULL;
+    }
+    entry->is_static = true;
+    return NET_ERR_OK;
+}
+
+// 静态路由的配置请求，由调用线程交给工作线程执行
+typedef struct route_static_req_t
+{
+    const ipaddr_t* net;
+    const ipaddr_t* mask;
+    const ipaddr_t* next_hop;
+    netif_t* netif;
+} route_static_req_t;
+
+static net_err_t route_add_static_req_in(const func_msg_t* msg)
+{
+    const route_static_req_t* req = msg->arg;
+    return route_entry_add_static(req->net, req->mask, req->next_hop, req->netif);
+}
+
+net_err_t route_add_static(const ipaddr_t* net, const ipaddr_t* mask, const ipaddr_t* next_hop, netif_t* netif)
+{
+    route_static_req_t req = {.net = net, .mask = mask, .next_hop = next_hop, .netif = netif};
+    return exmsg_func_exec(route_add_static_req_in, &req);
+}
+
+int route_export(route_record_t* records, const int max)
+{
+    int nr = 0;
+    nlist_node_t* node;
+    nlist_for_each(node, &route_list)
+    {
+        const route_entry_t* entry = nlist_entry(node, route_entry_t, node);
+        if (nr >= max)
+        {
+            break;
+        }
+        if (!entry->is_static)
+        {
+            continue;
+        }
+
+        route_record_t* record = &records[nr++];
+        plat_memset(record, 0, sizeof(route_record_t));
+        plat_strncpy(record->netif_name, entry->netif->name, NETIF_NAME_LEN - 1);
+        ipaddr_to_buf(&entry->net, record->net);
+        ipaddr_to_buf(&entry->mask, record->mask);
+        ipaddr_to_buf(&entry->next_hop, record->next_hop);
+    }
+    return nr;
+}
+
+// 头部已转为主机字节序：检查目的地址后交给分片重组或上层协议
+static net_err_t ipv4_input_dispatch(netif_t* netif, pktbuf_t* buf)
+{
+    ipv4_pkt_t* pkt = (ipv4_pkt_t*)pktbuf_data(buf);
+    ipaddr_t src_ip, dest_ip;
+    ipaddr_from_buf(&src_ip, pkt->header.src_addr);
+    ipaddr_from_buf(&dest_ip, pkt->header.dest_addr);
+
+    if (!ipaddr_is_match(&dest_ip, &netif->ipaddr, &netif->netmask))
+    {
+        dbug_warn(DBG_MOD_IPV4, "ipv4_input: packet not for us,dest ip %s", dest_ip.a_addr);
+        netif_stats_drop(netif, NETIF_DROP_NOT_FOR_US);
+        return NET_ERR_TARGET_ADDR_MATCH;
+    }
+
+    // 是否为分片包
+    if (pkt->header.frag_offset || pkt->header.more_frags)
+    {
+        return ip_fragment_input(netif, buf, &src_ip, &dest_ip);
+    }
+    return ip_normal_input(netif, buf, &src_ip, &dest_ip);
+}
+
 net_err_t ipv4_input(netif_t* netif, pktbuf_t* buf)
 {
     dbug_info(DBG_MOD_IPV4, "ipv4_input");
@@ -510,10 +765,11 @@ net_err_t ipv4_input(netif_t* netif, pktbuf_t* buf)
     ipv4_pkt_t* pkt = (ipv4_pkt_t*)pktbuf_data(buf);
 
     // 验证ipv4包是否合法
-    net_err_t err = ipv4_pkt_is_valid(pkt, buf->total_size, netif);
+    net_err_t err = ipv4_pkt_is_valid(pkt, buf->total_size, netif, pktbuf_csum_trusted(buf));
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_IPV4, "ipv4_input: invalid ipv4 packet, err=%d", err);
+        netif_stats_drop(netif, err == NET_ERR_CHECKSUM ? NETIF_DROP_CHECKSUM : NETIF_DROP_BAD_FRAME);
         return err;
     }
 
@@ -526,55 +782,66 @@ net_err_t ipv4_input(netif_t* netif, pktbuf_t* buf)
         return err;
     }
 
-    ipaddr_t src_ip, dest_ip;
-    ipaddr_from_buf(&src_ip, pkt->header.src_addr);
-    ipaddr_from_buf(&dest_ip, pkt->header.dest_addr);
-
-    if (!ipaddr_is_match(&dest_ip, &netif->ipaddr, &netif->netmask))
-    {
-        dbug_warn(DBG_MOD_IPV4, "ipv4_input: packet not for us,dest ip %s", dest_ip.a_addr);
-        return NET_ERR_TARGET_ADDR_MATCH;
-    }
-
-    // 是否为分片包
-    if (pkt->header.frag_offset || pkt->header.more_frags)
-    {
-        err = ip_fragment_input(netif, buf, &src_ip, &dest_ip);
-    }
-    else
+    // 上层已计数丢包原因，此处释放后按已消费返回，避免调用者再次释放
+    err = ipv4_input_dispatch(netif, buf);
+    if (err != NET_ERR_OK && err != NET_ERR_TARGET_ADDR_MATCH)
     {
-        err = ip_normal_input(netif, buf, &src_ip, &dest_ip);
+        dbug_warn(DBG_MOD_IPV4, "ipv4_input: ip_normal_input failed, err=%d", err);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
     }
+    return err;
+}
 
+net_err_t ipv4_input_local(netif_t* netif, pktbuf_t* buf)
+{
+    // 本机生成的包头部已知合法，只需转换字节序
+    net_err_t err = pktbuf_set_cont(buf, sizeof(ipv4_header_t));
     if (err != NET_ERR_OK)
     {
-        dbug_warn(DBG_MOD_IPV4, "ipv4_input: ip_normal_input failed, err=%d", err);
-        pktbuf_free(buf);
         return err;
     }
-
-    return NET_ERR_OK;
+    ipv4_pkt_t* pkt = (ipv4_pkt_t*)pktbuf_data(buf);
+    ipv4_header_ntohs(&pkt->header);
+    return ipv4_input_dispatch(netif, buf);
 }
 
-// 发送单个IP数据包
-static net_err_t ipv4_send_pkt(netif_t* netif, const ipaddr_t* dest_ip, pktbuf_t* buf)
+// 发送单个IP数据包，neigh不为NULL时通过邻居引用取下一跳MAC地址
+static net_err_t ipv4_send_pkt(netif_t* netif, const ipaddr_t* dest_ip, arp_ref_t* neigh, pktbuf_t* buf)
 {
     ipv4_pkt_t* pkt = (ipv4_pkt_t*)pktbuf_data(buf);
 
     // 转换为网络字节序
     ipv4_header_htonl(&pkt->header);
 
-    // 重置访问位置并计算校验和
+    // 重置访问位置并计算首部校验和；数据不离开内存且未抓包的网卡保留为0，接收方不验证，
+    // 交给原始套接字时再补全
     pktbuf_reset_access(buf);
-    pkt->header.header_checksum = pktbuf_checksum16(buf, ipv4_hdr_size(pkt), 0, true);
+    if (!(netif->features & NETIF_FEATURE_CSUM_SKIP) || netif->capture != NULL)
+    {
+        pkt->header.header_checksum = pktbuf_checksum16(buf, ipv4_hdr_size(pkt), 0, true);
+    }
 
     display_ipv4_header(pkt);
 
+    // 邻居已解析时直接填MAC地址发送，跳过广播判断与ARP查表；未解析时由ARP排队等待
+    if (neigh != NULL && netif->type == NETIF_TYPE_ETHERNET && netif->state == NETIF_STATE_ACTIVE)
+    {
+        const uint8_t* hwaddr = arp_ref_use(neigh);
+        if (hwaddr == NULL)
+        {
+            hwaddr = arp_ref_get(neigh, netif, dest_ip);
+        }
+        if (hwaddr != NULL)
+        {
+            return ether_raw_out(netif, PROTOCOL_TYPE_IPv4, hwaddr, buf);
+        }
+    }
     return netif_out(netif, (ipaddr_t*)dest_ip, buf);
 }
 
 // 分片发送
-static net_err_t ipv4_output_fragment(netif_t* netif, const ipaddr_t* dest_ip, pktbuf_t* buf)
+static net_err_t ipv4_output_fragment(netif_t* netif, const ipaddr_t* dest_ip, arp_ref_t* neigh, pktbuf_t* buf)
 {
     // 保存原始IP头（主机字节序）
     ipv4_header_t orig_hdr;
@@ -635,7 +902,7 @@ static net_err_t ipv4_output_fragment(netif_t* netif, const ipaddr_t* dest_ip, p
         frag_pkt->header.header_checksum = 0;
 
         // 发送分片
-        err = ipv4_send_pkt(netif, dest_ip, frag_buf);
+        err = ipv4_send_pkt(netif, dest_ip, neigh, frag_buf);
         if (err != NET_ERR_OK)
         {
             dbug_error(DBG_MOD_IPV4, "ipv4_output_fragment: send frag failed, offset=%d, err=%d", offset, err);
@@ -653,24 +920,50 @@ static net_err_t ipv4_output_fragment(netif_t* netif, const ipaddr_t* dest_ip, p
 
 net_err_t ipv4_output(const uint8_t protocol, const ipaddr_t* dest_ip, const ipaddr_t* src_ip, pktbuf_t* buf)
 {
-    // 查找路由条目
-    route_entry_t* route = find_route_entry(dest_ip);
+    return ipv4_output_dst(protocol, dest_ip, src_ip, buf, NULL);
+}
+
+net_err_t ipv4_output_dst(const uint8_t protocol, const ipaddr_t* dest_ip, const ipaddr_t* src_ip, pktbuf_t* buf,
+                          ipv4_dst_t* dst)
+{
+    // 目的地址缓存有效时直接使用，否则查找路由条目并更新缓存
+    route_entry_t* route;
+    if (dst != NULL && dst->route != NULL && dst->route_gen == route_gen && ipaddr_is_equal(&dst->dest, dest_ip))
+    {
+        route = dst->route;
+    }
+    else
+    {
+        route = find_route_entry(dest_ip);
+        if (dst != NULL)
+        {
+            plat_memset(dst, 0, sizeof(ipv4_dst_t));
+            ipaddr_copy(&dst->dest, dest_ip);
+            dst->route = route;
+            dst->route_gen = route_gen;
+        }
+    }
     if (route == NULL)
     {
         dbug_error(DBG_MOD_IPV4, "ipv4_output: no route to host %s", dest_ip->a_addr);
+        // 无路由时没有出口网卡，计入IP层统计
+        ipv4_stats.out_no_route++;
         return NET_ERR_NO_ROUTE;
     }
 
     ipaddr_t next_hop_ip;
+    arp_ref_t* neigh;
     if (ipaddr_is_any(&route->next_hop))
     {
-        // 直连网络，下一跳为目的地址
+        // 直连网络，下一跳为目的地址，邻居引用只能由目的地址缓存保存
         ipaddr_copy(&next_hop_ip, dest_ip);
+        neigh = dst != NULL ? &dst->neigh : NULL;
     }
     else
     {
         // 非直连网络，下一跳为路由表中的下一跳地址
         ipaddr_copy(&next_hop_ip, &route->next_hop);
+        neigh = &route->neigh;
     }
 
     netif_t* netif = route->netif;
@@ -700,15 +993,29 @@ net_err_t ipv4_output(const uint8_t protocol, const ipaddr_t* dest_ip, const ipa
     ipaddr_to_buf(src_ip, pkt->header.src_addr);
     ipaddr_to_buf(dest_ip, pkt->header.dest_addr);
 
+    // GSO大包不在IP层分片，由网卡或netif层按gso_size分段
+    if (buf->gso_type != PKTBUF_GSO_NONE)
+    {
+        if (buf->gso_size + (int)(sizeof(ipv4_header_t) + sizeof(udp_header_t)) > netif->mtu)
+        {
+            dbug_error(DBG_MOD_IPV4, "ipv4_output: gso_size %d exceeds mtu %d", buf->gso_size, netif->mtu);
+            return NET_ERR_INVALID_PARAM;
+        }
+        return ipv4_send_pkt(netif, &next_hop_ip, neigh, buf);
+    }
+
     // 不需要分片，直接发送
     if ((int)buf->total_size <= netif->mtu)
     {
-        return ipv4_send_pkt(netif, &next_hop_ip, buf);
+        return ipv4_send_pkt(netif, &next_hop_ip, neigh, buf);
     }
 
+    // 分片会复制数据，上层的部分校验和需先补全
+    pktbuf_csum_complete(buf);
+
     // 需要分片发送
     dbug_info(DBG_MOD_IPV4, "ipv4_output: packet size %d > mtu %d, fragmenting", buf->total_size, netif->mtu);
-    return ipv4_output_fragment(netif, &next_hop_ip, buf);
+    return ipv4_output_fragment(netif, &next_hop_ip, neigh, buf);
 }
 
 route_entry_t* find_route_entry(const ipaddr_t* dest_ip)
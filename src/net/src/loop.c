@@ -3,10 +3,21 @@
 #include "netif.h"
 #include "ipaddr.h"
 #include "exmsg.h"
+#include "ipv4.h"
+#include "gso.h"
+
+static netif_t* loop_netif;
+
+// 回环发送的包，在延迟工作中直接重新进入IPv4输入
+static nlist_t loop_list;
+
+static exmsg_work_t loop_work;
 
 static net_err_t loop_open(netif_t* netif, void* data)
 {
     netif->type = NETIF_TYPE_LOOPBACK;
+    netif->mtu = LOOP_MTU;
+    netif->features |= NETIF_FEATURE_CSUM_SKIP;
     return NET_ERR_OK;
 }
 
@@ -15,38 +26,80 @@ static net_err_t loop_close(netif_t* netif)
     return NET_ERR_OK;
 }
 
-static net_err_t loop_output(netif_t* netif)
+static void loop_work_func(exmsg_work_t* work)
 {
-    // 从输出队列获取数据包
-    pktbuf_t* buf = netif_get_out(netif, -1);
-    if (!buf)
+    nlist_node_t* node;
+    while ((node = nlist_remove_first(&loop_list)) != NULL)
     {
-        dbug_error(DBG_MOD_LOOP, "loop_output: failed to get pktbuf from out_q");
-        return NET_ERR_SYS;
+        pktbuf_t* buf = nlist_entry(node, pktbuf_t, node);
+        const net_err_t err = ipv4_input_local(loop_netif, buf);
+        if (err != NET_ERR_OK)
+        {
+            dbug_warn(DBG_MOD_LOOP, "loop_work_func: ipv4_input_local failed, err=%d", err);
+            pktbuf_free(buf);
+        }
     }
+}
 
-    // 直接放回输入队列
-    const net_err_t err = netif_put_in(netif, buf, -1);
-    if (err != NET_ERR_OK)
+// 单个包挂到回环列表
+static void loop_xmit_one(netif_t* netif, pktbuf_t* buf)
+{
+    // 校验和不逐包补全，抓包与原始套接字需要时再补全
+    if (netif->capture)
     {
-        dbug_error(DBG_MOD_LOOP, "loop_output: failed to put pktbuf to in_q");
-        pktbuf_free(buf);
-        return err;
+        netif_capture_pkt(netif, buf, NETIF_CAPTURE_TX);
+        netif_capture_pkt(netif, buf, NETIF_CAPTURE_RX);
+    }
+
+    // 本机生成的包无需校验，部分校验和保持原状，接收方同样视为可信
+    if (buf->csum_state != PKTBUF_CSUM_PARTIAL)
+    {
+        buf->csum_state = PKTBUF_CSUM_UNNECESSARY;
     }
+    netif_stats_tx(netif, buf->total_size);
+    netif_stats_rx(netif, buf->total_size);
+    nlist_insert_last(&loop_list, &buf->node);
+}
 
-    // 通知有数据包到达
-    // exmsg_netif_in(netif);
+// 快速路径：不经过收发队列和消息，原包挂到回环列表，当前消息处理完后进入IPv4输入
+static net_err_t loop_xmit(netif_t* netif, pktbuf_t* buf)
+{
+    // 回环不经过netif_put_out/netif_put_in，GSO大包在此分段，各段作为独立数据报输入
+    if (buf->gso_type != PKTBUF_GSO_NONE)
+    {
+        pktbuf_t* segs[GSO_MAX_SEGS];
+        int cnt = 0;
+        const net_err_t err = gso_segment(netif, buf, segs, &cnt);
+        if (err != NET_ERR_OK)
+        {
+            dbug_warn(DBG_MOD_LOOP, "loop_xmit: gso_segment failed, err=%d", err);
+            return err;
+        }
+        for (int i = 0; i < cnt; i++)
+        {
+            loop_xmit_one(netif, segs[i]);
+        }
+        pktbuf_free(buf);
+    }
+    else
+    {
+        loop_xmit_one(netif, buf);
+    }
+    exmsg_work_schedule(&loop_work);
     return NET_ERR_OK;
 }
 
 static netif_open_options_t loop_netif_ops = {
     .open = loop_open,
     .close = loop_close,
-    .linkoutput = loop_output,
+    .xmit = loop_xmit,
 };
 
 net_err_t loop_init()
 {
+    nlist_init(&loop_list);
+    exmsg_work_init(&loop_work, loop_work_func);
+
     netif_t* netif = netif_open("loop", &loop_netif_ops, NULL);
     if (!netif)
     {
@@ -65,6 +118,7 @@ net_err_t loop_init()
     netif_set_hwaddr(netif, (uint8_t[]){0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 6);
 
     netif_set_active(netif);
+    loop_netif = netif;
 
     // netif_set_inactive(netif);
     return NET_ERR_OK;
@@ -10,6 +10,10 @@
 #include "arp.h"
 #include "raw.h"
 #include "sock.h"
+#include "vlan.h"
+#include "bond.h"
+#include "acl.h"
+#include "snapshot.h"
 
 net_err_t net_init()
 {
@@ -38,6 +42,18 @@ net_err_t net_init()
     // 以太网模块初始化
     ether_init();
 
+    // VLAN子接口初始化
+    vlan_init();
+
+    // 链路聚合初始化
+    bond_init();
+
+    // 入口分类初始化
+    acl_init();
+
+    // 快速重启快照初始化，工作线程启动后恢复其中的记录
+    snapshot_init();
+
     // Socket模块初始化
     socket_init();
 
@@ -49,6 +65,9 @@ net_err_t net_init()
 net_err_t net_start()
 {
     exmsg_start();
+
+    // 恢复已激活网卡的邻居与静态路由
+    snapshot_restore();
     dbug_info(DBG_MOD_COMMON, "net is started");
     return NET_ERR_OK;
 }
@@ -5,6 +5,11 @@
 #include "ether.h"
 #include "exmsg.h"
 #include "ipv4.h"
+#include "gso.h"
+#include "nlocker.h"
+#include "timer.h"
+#include "bond.h"
+#include "acl.h"
 
 // 网卡接口内存块
 static netif_t netif_buffer[NETIF_DEV_CNT];
@@ -21,6 +26,50 @@ static netif_t* netif_default;
 // 链路层指针数组
 static const link_layer_t* link_layers[NETIF_TYPE_SIZE];
 
+// 统计计数的原子加，用于槽位分配和共用槽位上的计数
+#if defined(_MSC_VER)
+#define STATS_ATOMIC_ADD(p, v) InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v))
+#else
+#define STATS_ATOMIC_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#endif
+
+// 当前线程的统计槽位，首次计数时分配，独占槽位上的计数无需加锁
+static SYS_THREAD_LOCAL int stats_slot = -1;
+
+// 下一个待分配的统计槽位，只通过原子加修改
+static volatile long stats_slot_next;
+
+// 接收调节超时检查节拍，只在工作线程中访问
+static net_timer_t rxmod_timer;
+static bool rxmod_timer_active;
+
+// 独占槽位用完后，新线程都使用共用槽位，其上的计数改为原子加
+int netif_stats_slot()
+{
+    if (stats_slot < 0)
+    {
+        long slot = NETIF_STATS_SLOT_SHARED;
+        if (stats_slot_next < NETIF_STATS_SLOT_SHARED)
+        {
+            slot = STATS_ATOMIC_ADD(&stats_slot_next, 1);
+        }
+        stats_slot = slot < NETIF_STATS_SLOT_SHARED ? (int)slot : NETIF_STATS_SLOT_SHARED;
+    }
+    return stats_slot;
+}
+
+void netif_stats_add(const int slot, uint64_t* counter, const uint64_t val)
+{
+    if (slot == NETIF_STATS_SLOT_SHARED)
+    {
+        STATS_ATOMIC_ADD(counter, val);
+    }
+    else
+    {
+        *counter += val;
+    }
+}
+
 #if DBG_DISPLAY_ENABLE(DBG_MOD_NETIF)
 static void display_netif_list()
 {
@@ -97,6 +146,11 @@ net_err_t netif_init()
 
     // 初始化链路层指针数组
     plat_memset(link_layers, 0, sizeof(link_layers));
+
+    stats_slot_next = 0;
+
+    nlist_node_init(&rxmod_timer.node);
+    rxmod_timer_active = false;
     return NET_ERR_OK;
 }
 
@@ -123,7 +177,23 @@ netif_t* netif_open(const char* dev_name, const netif_open_options_t* opts, void
     ipaddr_set_any(&netif->gateway);
 
     netif->mtu = 0;
+    netif->mtu_max = 0;
+    plat_memset(netif->stats, 0, sizeof(netif->stats));
+    shaper_init(&netif->shaper, netif);
+    netif->drr.enabled = false;
     netif->type = NETIF_TYPE_NONE;
+    netif->vlan_parent = NULL;
+    netif->vlan_id = 0;
+    netif->vlans = NULL;
+    netif->link_up = true;
+    netif->bond_master = NULL;
+    netif->rx_sem = netif->tx_sem = SYS_SEM_INVALID;
+    if (rxmod_init(&netif->rxmod) != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_NETIF, "init netif rxmod failed");
+        mblock_free(&netif_mblock, netif);
+        return NULL;
+    }
 
     plat_strncpy(netif->name, dev_name, NETIF_NAME_LEN);
     netif->name[NETIF_NAME_LEN - 1] = '\0';
@@ -132,22 +202,44 @@ netif_t* netif_open(const char* dev_name, const netif_open_options_t* opts, void
 
     nlist_node_init(&netif->node);
 
-    net_err_t err = fixq_init(&netif->in_q, netif->in_q_buf, NETIF_IN_QUEUE_SIZE, NLOCKER_TYPE_THREAD);
-    if (err != NET_ERR_OK)
+    // 队列全部预先创建，由驱动决定实际使用的数量
+    int queue_inited = 0;
+    net_err_t err = NET_ERR_OK;
+    for (; queue_inited < NETIF_QUEUE_MAX; queue_inited++)
     {
-        dbug_error(DBG_MOD_NETIF, "init netif in_q failed");
-        goto open_failed;
-    }
+        err = fixq_init(&netif->in_q[queue_inited], netif->in_q_buf[queue_inited], NETIF_IN_QUEUE_SIZE,
+                        NLOCKER_TYPE_THREAD);
+        if (err != NET_ERR_OK)
+        {
+            dbug_error(DBG_MOD_NETIF, "init netif in_q failed");
+            goto open_failed;
+        }
 
-    err = fixq_init(&netif->out_q, netif->out_q_buf, NETIF_OUT_QUEUE_SIZE, NLOCKER_TYPE_THREAD);
-    if (err != NET_ERR_OK)
+        err = fixq_init(&netif->out_q[queue_inited], netif->out_q_buf[queue_inited], NETIF_OUT_QUEUE_SIZE,
+                        NLOCKER_TYPE_THREAD);
+        if (err != NET_ERR_OK)
+        {
+            dbug_error(DBG_MOD_NETIF, "init netif out_q failed");
+            fixq_destroy(&netif->in_q[queue_inited]);
+            goto open_failed;
+        }
+    }
+    netif->rx_queue_nr = netif->tx_queue_nr = 1;
+    netif->rx_next = netif->tx_next = 0;
+    rss_init(&netif->rss, 1);
+    netif->rx_sem = sys_sem_create(0);
+    netif->tx_sem = sys_sem_create(0);
+    if (netif->rx_sem == SYS_SEM_INVALID || netif->tx_sem == SYS_SEM_INVALID)
     {
-        dbug_error(DBG_MOD_NETIF, "init netif out_q failed");
+        dbug_error(DBG_MOD_NETIF, "init netif queue sem failed");
         goto open_failed;
     }
 
     netif->opts = (netif_open_options_t*)opts;
     netif->opts_data = opts_data;
+    netif->capture = NULL;
+    netif->capture_data = NULL;
+    netif->features = 0;
 
     err = opts->open(netif, opts_data);
     if (err != NET_ERR_OK)
@@ -181,8 +273,20 @@ open_failed:
     {
         netif->opts->close(netif);
     }
-    fixq_destroy(&netif->in_q);
-    fixq_destroy(&netif->out_q);
+    while (queue_inited-- > 0)
+    {
+        fixq_destroy(&netif->in_q[queue_inited]);
+        fixq_destroy(&netif->out_q[queue_inited]);
+    }
+    if (netif->rx_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(netif->rx_sem);
+    }
+    if (netif->tx_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(netif->tx_sem);
+    }
+    rxmod_destroy(&netif->rxmod);
     mblock_free(&netif_mblock, netif);
     return NULL;
 }
@@ -198,6 +302,18 @@ net_err_t netif_set_hwaddr(netif_t* netif, const uint8_t* hwaddr, uint8_t hwaddr
     return NET_ERR_OK;
 }
 
+net_err_t netif_set_mtu(netif_t* netif, const int mtu)
+{
+    if (mtu < NETIF_MTU_MIN || mtu > netif->mtu_max)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_mtu: %s mtu %d out of range, max=%d", netif->name, mtu,
+                   netif->mtu_max);
+        return NET_ERR_INVALID_PARAM;
+    }
+    netif->mtu = mtu;
+    return NET_ERR_OK;
+}
+
 net_err_t netif_set_addr(netif_t* netif, const ipaddr_t* ipaddr, const ipaddr_t* netmask, const ipaddr_t* gateway)
 {
     ipaddr_copy(&netif->ipaddr, ipaddr ? ipaddr : get_addr_any());
@@ -257,17 +373,27 @@ net_err_t netif_set_inactive(netif_t* netif)
         netif->link_layer->close(netif);
     }
 
-    pktbuf_t* buf;
-    // 清空接收队列
-    while ((buf = fixq_recv(&netif->in_q, -1)) != NULL)
+    // 丢弃整形器与公平队列中积压的包
+    shaper_flush(&netif->shaper);
+    if (netif->drr.enabled)
     {
-        pktbuf_free(buf);
+        drr_flush(&netif->drr);
     }
 
-    // 清空发送队列
-    while ((buf = fixq_recv(&netif->out_q, -1)) != NULL)
+    pktbuf_t* buf;
+    for (int i = 0; i < NETIF_QUEUE_MAX; i++)
     {
-        pktbuf_free(buf);
+        // 清空接收队列
+        while ((buf = fixq_recv(&netif->in_q[i], -1)) != NULL)
+        {
+            pktbuf_free(buf);
+        }
+
+        // 清空发送队列
+        while ((buf = fixq_recv(&netif->out_q[i], -1)) != NULL)
+        {
+            pktbuf_free(buf);
+        }
     }
 
     // 如果是默认网卡，清除默认网卡指针
@@ -296,6 +422,16 @@ net_err_t netif_close(netif_t* netif)
         dbug_error(DBG_MOD_NETIF, "netif_close: netif is active");
         return NET_ERR_INVALID_STATE;
     }
+    if (netif->vlans != NULL)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_close: %s still has vlan sub-interfaces", netif->name);
+        return NET_ERR_INVALID_STATE;
+    }
+    if (netif->bond_master != NULL)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_close: %s is a member of %s", netif->name, netif->bond_master->name);
+        return NET_ERR_INVALID_STATE;
+    }
 
     // 关闭网卡接口
     netif->opts->close(netif);
@@ -304,8 +440,18 @@ net_err_t netif_close(netif_t* netif)
     netif->state = NETIF_STATE_CLOSED;
 
     // 销毁收发队列
-    fixq_destroy(&netif->in_q);
-    fixq_destroy(&netif->out_q);
+    for (int i = 0; i < NETIF_QUEUE_MAX; i++)
+    {
+        fixq_destroy(&netif->in_q[i]);
+        fixq_destroy(&netif->out_q[i]);
+    }
+    sys_sem_free(netif->rx_sem);
+    sys_sem_free(netif->tx_sem);
+    if (netif->drr.enabled)
+    {
+        drr_destroy(&netif->drr);
+    }
+    rxmod_destroy(&netif->rxmod);
 
     // 从网卡链表中移除
     nlist_remove(&netif_list, &netif->node);
@@ -337,45 +483,369 @@ void netif_set_default(netif_t* netif)
     route_entry_add(ipaddr_get_any(), ipaddr_get_any(), &netif->gateway, netif);
 }
 
-net_err_t netif_put_in(netif_t* netif, pktbuf_t* buf, const int tmo)
+net_err_t netif_set_queues(netif_t* netif, const int rx_queue_nr, const int tx_queue_nr)
 {
-    const net_err_t err = fixq_send(&netif->in_q, buf, tmo);
+    if (rx_queue_nr < 1 || rx_queue_nr > NETIF_QUEUE_MAX || tx_queue_nr < 1 || tx_queue_nr > NETIF_QUEUE_MAX)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_queues: invalid queue nr rx=%d tx=%d", rx_queue_nr, tx_queue_nr);
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (netif->drr.enabled && tx_queue_nr > 1)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_queues: drr requires a single tx queue");
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (netif->state == NETIF_STATE_ACTIVE)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_queues: netif is active");
+        return NET_ERR_INVALID_STATE;
+    }
+
+    netif->rx_queue_nr = rx_queue_nr;
+    netif->tx_queue_nr = tx_queue_nr;
+    netif->rx_next = netif->tx_next = 0;
+    for (int i = 0; i < RSS_RETA_SIZE; i++)
+    {
+        netif->rss.reta[i] = (uint8_t)(i % rx_queue_nr);
+    }
+    return NET_ERR_OK;
+}
+
+net_err_t netif_set_rss(netif_t* netif, const uint8_t* key, const int key_len, const uint8_t* reta,
+                        const int reta_size)
+{
+    if (key && rss_set_key(&netif->rss, key, key_len) != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_rss: invalid key");
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (reta && rss_set_reta(&netif->rss, reta, reta_size, netif->rx_queue_nr) != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_rss: invalid reta");
+        return NET_ERR_INVALID_PARAM;
+    }
+    return NET_ERR_OK;
+}
+
+int netif_rx_queue(netif_t* netif, pktbuf_t* buf)
+{
+    if (netif->rx_queue_nr <= 1 || netif->link_layer == NULL)
+    {
+        return 0;
+    }
+    return rss_queue(&netif->rss, rss_hash_pktbuf(&netif->rss, buf));
+}
+
+// 发送方向不经过间接表，哈希直接对队列数取模
+static int netif_tx_queue(netif_t* netif, pktbuf_t* buf)
+{
+    if (netif->tx_queue_nr <= 1 || netif->link_layer == NULL)
+    {
+        return 0;
+    }
+    return (int)(rss_hash_pktbuf(&netif->rss, buf) % netif->tx_queue_nr);
+}
+
+// GSO大包分段后逐段入队，全部入队后释放大包；失败时大包仍由调用者释放
+static net_err_t netif_put_gso(netif_t* netif, pktbuf_t* buf, const int tmo,
+                               net_err_t (*put)(netif_t* netif, pktbuf_t* buf, int tmo))
+{
+    pktbuf_t* segs[GSO_MAX_SEGS];
+    int cnt = 0;
+    net_err_t err = gso_segment(netif, buf, segs, &cnt);
+    if (err != NET_ERR_OK)
+    {
+        dbug_warn(DBG_MOD_NETIF, "netif_put_gso: gso_segment failed, err=%d", err);
+        return err;
+    }
+
+    for (int i = 0; i < cnt; i++)
+    {
+        if ((err = put(netif, segs[i], tmo)) != NET_ERR_OK)
+        {
+            while (i < cnt)
+            {
+                pktbuf_free(segs[i++]);
+            }
+            return err;
+        }
+    }
+    pktbuf_free(buf);
+    return NET_ERR_OK;
+}
+
+// 以太网卡的包入队前先过入口分类，在驱动线程中丢弃不需要的流量；丢弃的包已释放
+static bool netif_acl_drop(netif_t* netif, pktbuf_t* buf)
+{
+    if (netif->type != NETIF_TYPE_ETHERNET || acl_classify(buf) != ACL_ACTION_DROP)
+    {
+        return false;
+    }
+    netif_stats_drop(netif, NETIF_DROP_ACL);
+    pktbuf_free(buf);
+    return true;
+}
+
+// 放入接收队列，入口分类由调用者处理
+static net_err_t netif_put_in_queue(netif_t* netif, pktbuf_t* buf, const int tmo)
+{
+    const uint32_t bytes = buf->total_size;
+    const net_err_t err = fixq_send(&netif->in_q[netif_rx_queue(netif, buf)], buf, tmo);
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_NETIF, "netif_put_in: send to in_q failed");
+        netif_stats_drop(netif, NETIF_DROP_QUEUE_FULL);
         return err;
     }
 
-    exmsg_netif_in(netif);
+    netif_stats_rx(netif, bytes);
+    if (netif->rx_queue_nr > 1)
+    {
+        sys_sem_notify(netif->rx_sem);
+    }
+    if (rxmod_arrive(&netif->rxmod, 1) && exmsg_netif_in(netif) != NET_ERR_OK)
+    {
+        rxmod_notify_failed(&netif->rxmod, 1);
+    }
     return NET_ERR_OK;
 }
 
-pktbuf_t* netif_get_in(netif_t* netif, const int tmo)
+net_err_t netif_put_in(netif_t* netif, pktbuf_t* buf, const int tmo)
+{
+    if (buf->gso_type != PKTBUF_GSO_NONE)
+    {
+        return netif_put_gso(netif, buf, tmo, netif_put_in);
+    }
+    if (netif_acl_drop(netif, buf))
+    {
+        return NET_ERR_OK;
+    }
+    return netif_put_in_queue(netif, buf, tmo);
+}
+
+net_err_t netif_put_in_local(netif_t* netif, pktbuf_t* buf, const int tmo)
+{
+    if (buf->gso_type != PKTBUF_GSO_NONE)
+    {
+        return netif_put_gso(netif, buf, tmo, netif_put_in_local);
+    }
+    return netif_put_in_queue(netif, buf, tmo);
+}
+
+// 多队列批量入队：按队列分组，每组一次入队
+static int netif_put_in_spread(netif_t* netif, pktbuf_t** bufs, const int cnt)
+{
+    pktbuf_t* group[NETIF_QUEUE_MAX][NETIF_BURST_MAX];
+    int queued = 0;
+    int failed = 0;
+
+    for (int start = 0; start < cnt; start += NETIF_BURST_MAX)
+    {
+        const int end = start + NETIF_BURST_MAX < cnt ? start + NETIF_BURST_MAX : cnt;
+        int group_cnt[NETIF_QUEUE_MAX] = {0};
+        for (int i = start; i < end; i++)
+        {
+            const int queue = netif_rx_queue(netif, bufs[i]);
+            group[queue][group_cnt[queue]++] = bufs[i];
+        }
+
+        // 已处理过的位置可以复用，放不下的包暂存到数组前部
+        for (int queue = 0; queue < netif->rx_queue_nr; queue++)
+        {
+            const int nr = fixq_send_burst(&netif->in_q[queue], (void**)group[queue], group_cnt[queue]);
+            for (int i = nr; i < group_cnt[queue]; i++)
+            {
+                bufs[failed++] = group[queue][i];
+            }
+            queued += nr;
+        }
+    }
+
+    // 按约定把未放入的包移到尾部
+    for (int i = failed - 1; i >= 0; i--)
+    {
+        bufs[queued + i] = bufs[i];
+    }
+    return queued;
+}
+
+int netif_put_in_burst(netif_t* netif, pktbuf_t** bufs, const int cnt)
+{
+    // 被入口分类丢弃的包已释放，其余的包前移
+    int kept = 0;
+    for (int i = 0; i < cnt; i++)
+    {
+        if (!netif_acl_drop(netif, bufs[i]))
+        {
+            bufs[kept++] = bufs[i];
+        }
+    }
+
+    // 入队后包可能立即被工作线程取走，先记录整批字节数
+    uint32_t bytes = 0;
+    for (int i = 0; i < kept; i++)
+    {
+        bytes += bufs[i]->total_size;
+    }
+
+    int nr;
+    if (netif->rx_queue_nr <= 1)
+    {
+        nr = fixq_send_burst(&netif->in_q[0], (void**)bufs, kept);
+    }
+    else
+    {
+        nr = netif_put_in_spread(netif, bufs, kept);
+        if (nr > 0)
+        {
+            sys_sem_notify(netif->rx_sem);
+        }
+    }
+
+    if (nr < kept)
+    {
+        dbug_warn(DBG_MOD_NETIF, "netif_put_in_burst: in_q full, %d/%d queued", nr, kept);
+        // 未入队的包仍归调用者所有，从总字节数中扣除并移到数组尾部
+        const int slot = netif_stats_slot();
+        for (int i = kept - 1; i >= nr; i--)
+        {
+            bytes -= bufs[i]->total_size;
+            bufs[cnt - kept + i] = bufs[i];
+        }
+        netif_stats_add(slot, &netif->stats[slot].drops[NETIF_DROP_QUEUE_FULL], kept - nr);
+    }
+    if (nr > 0)
+    {
+        const int slot = netif_stats_slot();
+        netif_stats_add(slot, &netif->stats[slot].rx_packets, nr);
+        netif_stats_add(slot, &netif->stats[slot].rx_bytes, bytes);
+    }
+
+    if (nr > 0 && rxmod_arrive(&netif->rxmod, nr) && exmsg_netif_in(netif) != NET_ERR_OK)
+    {
+        rxmod_notify_failed(&netif->rxmod, nr);
+    }
+    return nr + cnt - kept;
+}
+
+pktbuf_t* netif_get_in_q(netif_t* netif, const int queue, const int tmo)
 {
-    pktbuf_t* buf = fixq_recv(&netif->in_q, tmo);
+    pktbuf_t* buf = fixq_recv(&netif->in_q[queue], tmo);
     if (buf)
     {
         pktbuf_reset_access(buf);
+        if (netif->capture)
+        {
+            netif_capture_pkt(netif, buf, NETIF_CAPTURE_RX);
+        }
         return buf;
     }
     dbug_info(DBG_MOD_NETIF, "netif_get_in: recv from in_q timeout");
     return NULL;
 }
 
+pktbuf_t* netif_get_in(netif_t* netif, const int tmo)
+{
+    if (netif->rx_queue_nr <= 1)
+    {
+        return netif_get_in_q(netif, 0, tmo);
+    }
+
+    for (;;)
+    {
+        // 从上次的下一个队列开始轮询，避免某个队列饿死
+        for (int i = 0; i < netif->rx_queue_nr; i++)
+        {
+            const int queue = (netif->rx_next + i) % netif->rx_queue_nr;
+            if (fixq_count(&netif->in_q[queue]) > 0)
+            {
+                netif->rx_next = (queue + 1) % netif->rx_queue_nr;
+                return netif_get_in_q(netif, queue, -1);
+            }
+        }
+
+        // 所有队列为空时等待入队通知；通知可能来自已被非阻塞取走的包，醒来后重新轮询
+        if (tmo < 0 || sys_sem_wait(netif->rx_sem, (uint32_t)tmo) < 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+int netif_in_count(netif_t* netif)
+{
+    int cnt = 0;
+    for (int i = 0; i < netif->rx_queue_nr; i++)
+    {
+        cnt += fixq_count(&netif->in_q[i]);
+    }
+    return cnt;
+}
+
 net_err_t netif_put_out(netif_t* netif, pktbuf_t* buf, const int tmo)
 {
-    const net_err_t err = fixq_send(&netif->out_q, buf, tmo);
+    if (buf->gso_type == PKTBUF_GSO_UDP && !(netif->features & NETIF_FEATURE_GSO_UDP))
+    {
+        return netif_put_gso(netif, buf, tmo, netif_put_out);
+    }
+
+    if (netif->shaper.rate > 0)
+    {
+        return shaper_output(&netif->shaper, buf);
+    }
+    return netif_put_out_raw(netif, buf, tmo);
+}
+
+void netif_capture_pkt(netif_t* netif, pktbuf_t* buf, const netif_capture_dir_t dir)
+{
+    // 抓到的包校验和必须完整，未挂抓包回调时部分校验和保持原状，交给网卡或接收方
+    pktbuf_csum_complete(buf);
+    netif->capture(netif, buf, dir);
+}
+
+net_err_t netif_put_out_raw(netif_t* netif, pktbuf_t* buf, const int tmo)
+{
+    // 网卡不能补全部分校验和时在入队前由软件补全
+    if (buf->csum_state == PKTBUF_CSUM_PARTIAL &&
+        !(netif->features & (NETIF_FEATURE_CSUM_PARTIAL | NETIF_FEATURE_CSUM_SKIP)))
+    {
+        pktbuf_csum_complete(buf);
+    }
+
+    if (netif->capture)
+    {
+        netif_capture_pkt(netif, buf, NETIF_CAPTURE_TX);
+    }
+
+    const uint32_t bytes = buf->total_size;
+    net_err_t err;
+    if (netif->drr.enabled)
+    {
+        // 公平队列按流哈希分子队列，子队列满时直接丢弃不等待
+        const uint32_t hash = netif->link_layer ? rss_hash_pktbuf(&netif->rss, buf) : 0;
+        err = drr_enqueue(&netif->drr, buf, hash);
+    }
+    else
+    {
+        err = fixq_send(&netif->out_q[netif_tx_queue(netif, buf)], buf, tmo);
+    }
     if (err != NET_ERR_OK)
     {
         dbug_warn(DBG_MOD_NETIF, "netif_put_out: send to out_q failed");
+        netif_stats_drop(netif, NETIF_DROP_QUEUE_FULL);
         return err;
     }
+    if (netif->tx_queue_nr > 1 && !netif->drr.enabled)
+    {
+        sys_sem_notify(netif->tx_sem);
+    }
+    netif_stats_tx(netif, bytes);
     return NET_ERR_OK;
 }
 
-pktbuf_t* netif_get_out(netif_t* netif, const int tmo)
+pktbuf_t* netif_get_out_q(netif_t* netif, const int queue, const int tmo)
 {
-    pktbuf_t* buf = fixq_recv(&netif->out_q, tmo);
+    pktbuf_t* buf = netif->drr.enabled ? drr_dequeue(&netif->drr, tmo) : fixq_recv(&netif->out_q[queue], tmo);
     if (buf)
     {
         pktbuf_reset_access(buf);
@@ -385,6 +855,57 @@ pktbuf_t* netif_get_out(netif_t* netif, const int tmo)
     return NULL;
 }
 
+pktbuf_t* netif_get_out(netif_t* netif, const int tmo)
+{
+    if (netif->tx_queue_nr <= 1 || netif->drr.enabled)
+    {
+        return netif_get_out_q(netif, 0, tmo);
+    }
+
+    for (;;)
+    {
+        for (int i = 0; i < netif->tx_queue_nr; i++)
+        {
+            const int queue = (netif->tx_next + i) % netif->tx_queue_nr;
+            if (fixq_count(&netif->out_q[queue]) > 0)
+            {
+                netif->tx_next = (queue + 1) % netif->tx_queue_nr;
+                return netif_get_out_q(netif, queue, -1);
+            }
+        }
+
+        // 所有队列为空时等待入队通知，醒来后重新轮询
+        if (tmo < 0 || sys_sem_wait(netif->tx_sem, (uint32_t)tmo) < 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+int netif_get_out_burst(netif_t* netif, pktbuf_t** bufs, const int cnt)
+{
+    int nr = 0;
+    if (netif->drr.enabled)
+    {
+        nr = drr_dequeue_burst(&netif->drr, bufs, cnt);
+    }
+    else
+    {
+        pktbuf_t* buf;
+        while (nr < cnt && (buf = netif_get_out(netif, -1)) != NULL)
+        {
+            bufs[nr++] = buf;
+        }
+        return nr;
+    }
+
+    for (int i = 0; i < nr; i++)
+    {
+        pktbuf_reset_access(bufs[i]);
+    }
+    return nr;
+}
+
 net_err_t netif_out(netif_t* netif, ipaddr_t* ipaddr, pktbuf_t* buf)
 {
     if (netif->state != NETIF_STATE_ACTIVE)
@@ -400,6 +921,11 @@ net_err_t netif_out(netif_t* netif, ipaddr_t* ipaddr, pktbuf_t* buf)
         return netif->link_layer->output(netif, ipaddr, buf);
     }
 
+    if (netif->opts->xmit)
+    {
+        return netif->opts->xmit(netif, buf);
+    }
+
     const net_err_t err = netif_put_out(netif, buf, -1);
     if (err != NET_ERR_OK)
     {
@@ -431,3 +957,185 @@ netif_t* netif_get_default()
 {
     return netif_default;
 }
+
+netif_t* netif_find(const char* name)
+{
+    nlist_node_t* node;
+    nlist_for_each(node, &netif_list)
+    {
+        netif_t* netif = nlist_entry(node, netif_t, node);
+        if (plat_strcmp(netif->name, name) == 0)
+        {
+            return netif;
+        }
+    }
+    return NULL;
+}
+
+void netif_stats_rx(netif_t* netif, const uint32_t bytes)
+{
+    const int slot = netif_stats_slot();
+    netif_stats_add(slot, &netif->stats[slot].rx_packets, 1);
+    netif_stats_add(slot, &netif->stats[slot].rx_bytes, bytes);
+}
+
+void netif_stats_tx(netif_t* netif, const uint32_t bytes)
+{
+    const int slot = netif_stats_slot();
+    netif_stats_add(slot, &netif->stats[slot].tx_packets, 1);
+    netif_stats_add(slot, &netif->stats[slot].tx_bytes, bytes);
+}
+
+void netif_stats_drop(netif_t* netif, const netif_drop_t reason)
+{
+    const int slot = netif_stats_slot();
+    netif_stats_add(slot, &netif->stats[slot].drops[reason], 1);
+}
+
+net_err_t netif_get_stats(netif_t* netif, netif_stats_t* stats)
+{
+    if (netif == NULL || stats == NULL)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    // 读取时不加锁，各槽位的值可能相差正在进行中的一次计数
+    plat_memset(stats, 0, sizeof(netif_stats_t));
+    for (int i = 0; i < NETIF_STATS_SLOT_NR; i++)
+    {
+        const netif_stats_t* slot = &netif->stats[i];
+        stats->rx_packets += slot->rx_packets;
+        stats->rx_bytes += slot->rx_bytes;
+        stats->tx_packets += slot->tx_packets;
+        stats->tx_bytes += slot->tx_bytes;
+        for (int reason = 0; reason < NETIF_DROP_NR; reason++)
+        {
+            stats->drops[reason] += slot->drops[reason];
+        }
+    }
+    return NET_ERR_OK;
+}
+
+// 整形配置请求，整形器的定时器只能在工作线程中增删
+typedef struct netif_shaper_req_t
+{
+    netif_t* netif;
+    uint32_t rate;
+    uint32_t burst;
+} netif_shaper_req_t;
+
+static net_err_t netif_set_shaper_req_in(const func_msg_t* msg)
+{
+    const netif_shaper_req_t* req = msg->arg;
+    return shaper_config(&req->netif->shaper, req->rate, req->burst);
+}
+
+net_err_t netif_set_shaper(netif_t* netif, const uint32_t rate, const uint32_t burst)
+{
+    // 桶容量至少容纳一个MTU大小的包
+    if (rate > 0 && burst < (uint32_t)netif->mtu)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_shaper: burst %u less than mtu %d", burst, netif->mtu);
+        return NET_ERR_INVALID_PARAM;
+    }
+    netif_shaper_req_t req = {.netif = netif, .rate = rate, .burst = burst};
+    return exmsg_func_exec(netif_set_shaper_req_in, &req);
+}
+
+net_err_t netif_get_shaper_stats(netif_t* netif, shaper_stats_t* stats)
+{
+    if (netif == NULL || stats == NULL)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    *stats = netif->shaper.stats;
+    return NET_ERR_OK;
+}
+
+net_err_t netif_set_drr(netif_t* netif, const uint32_t quantum, const uint32_t limit)
+{
+    if (netif->state == NETIF_STATE_ACTIVE || netif->drr.enabled)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_drr: netif is active or drr already enabled");
+        return NET_ERR_INVALID_STATE;
+    }
+    if (netif->tx_queue_nr > 1)
+    {
+        dbug_error(DBG_MOD_NETIF, "netif_set_drr: multiple tx queues not supported");
+        return NET_ERR_INVALID_PARAM;
+    }
+    return drr_init(&netif->drr, quantum ? quantum : DRR_QUANTUM_DEFAULT,
+                    limit ? limit : DRR_QUEUE_BYTES_DEFAULT);
+}
+
+net_err_t netif_get_drr_stats(netif_t* netif, drr_stats_t* stats)
+{
+    if (netif == NULL || stats == NULL || !netif->drr.enabled)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    nlocker_lock(&netif->drr.locker);
+    *stats = netif->drr.stats;
+    nlocker_unlock(&netif->drr.locker);
+    return NET_ERR_OK;
+}
+
+static void rxmod_timer_proc(net_timer_t* timer, void* arg)
+{
+    rxmod_timer_active = false;
+
+    // 通知等待超时的网卡，仍有网卡在攒批时继续节拍
+    bool active = false;
+    nlist_node_t* node;
+    nlist_for_each(node, &netif_list)
+    {
+        netif_t* netif = nlist_entry(node, netif_t, node);
+        const int expired = rxmod_expire(&netif->rxmod);
+        if (expired > 0 && exmsg_netif_in(netif) != NET_ERR_OK)
+        {
+            rxmod_notify_failed(&netif->rxmod, expired);
+        }
+        active = active || rxmod_active(&netif->rxmod);
+    }
+
+    if (active)
+    {
+        net_timer_add(&rxmod_timer, "rxmod", rxmod_timer_proc, NULL, RXMOD_TICK_MS, 0);
+        rxmod_timer_active = true;
+    }
+}
+
+void netif_set_link(netif_t* netif, const bool up)
+{
+    if (netif->link_up == up)
+    {
+        return;
+    }
+    netif->link_up = up;
+    dbug_info(DBG_MOD_NETIF, "netif %s link %s", netif->name, up ? "up" : "down");
+
+    if (netif->bond_master != NULL)
+    {
+        bond_link_update(netif->bond_master);
+    }
+}
+
+void netif_rxmod_schedule(netif_t* netif)
+{
+    if (rxmod_timer_active || !rxmod_active(&netif->rxmod))
+    {
+        return;
+    }
+    net_timer_add(&rxmod_timer, "rxmod", rxmod_timer_proc, NULL, RXMOD_TICK_MS, 0);
+    rxmod_timer_active = true;
+}
+
+net_err_t netif_get_rxmod_stats(netif_t* netif, rxmod_stats_t* stats)
+{
+    if (netif == NULL || stats == NULL)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    rxmod_get_stats(&netif->rxmod, stats);
+    return NET_ERR_OK;
+}
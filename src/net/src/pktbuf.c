@@ -18,29 +18,85 @@ static pktbuf_t pktbuf_buffer[PKTBUF_BUF_COUNT];
 
 static mblock_t pktbuf_list;
 
+// 巨帧数据区，由普通块引用，块释放时交还
+static uint8_t jumbo_buffer[PKTBUF_JUMBO_BLK_COUNT][PKTBUF_JUMBO_PAYLOAD_SIZE];
+
+static mblock_t jumbo_list;
+
 static long curr_blk_tail_free(const pktblk_t* curr)
 {
-    return curr->payload + PKTBUF_PAYLOAD_SIZE - (curr->data + curr->size);
+    return curr->end - (curr->data + curr->size);
 }
 
-static void pktblock_free(pktblk_t* block)
+static int pktblock_capacity(const pktblk_t* block)
 {
-    if (block)
+    return (int)(block->end - block->start);
+}
+
+// 块的数据区是否与其他块共享，共享时写入前需先复制
+static bool pktblock_shared(const pktblk_t* block)
+{
+    return block->owner != NULL || block->ref > 1;
+}
+
+// 释放对数据区的一个引用，最后一个引用释放时交还数据区与块，调用者需持有locker
+static void pktblock_put_locked(pktblk_t* block)
+{
+    if (--block->ref > 0)
+    {
+        return;
+    }
+    // 外部数据区交还给其所有者
+    if (block->release)
+    {
+        block->release(block->release_arg, block->start);
+    }
+    mblock_free(&block_list, block);
+}
+
+// 调用者需持有locker
+static void pktblock_free_locked(pktblk_t* block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+    // 克隆块本身不持有数据区，释放后归还对所属块的引用
+    pktblk_t* owner = block->owner;
+    if (owner)
     {
         mblock_free(&block_list, block);
+        pktblock_put_locked(owner);
+        return;
     }
+    pktblock_put_locked(block);
 }
 
-static void pktblock_free_list(pktblk_t* first)
+static void pktblock_free(pktblk_t* block)
+{
+    nlocker_lock(&locker);
+    pktblock_free_locked(block);
+    nlocker_unlock(&locker);
+}
+
+// 调用者需持有locker
+static void pktblock_free_list_locked(pktblk_t* first)
 {
     while (first)
     {
         pktblk_t* next = pktblock_get_next(first);
-        pktblock_free(first);
+        pktblock_free_locked(first);
         first = next;
     }
 }
 
+static void pktblock_free_list(pktblk_t* first)
+{
+    nlocker_lock(&locker);
+    pktblock_free_list_locked(first);
+    nlocker_unlock(&locker);
+}
+
 static pktblk_t* pktbuf_last_blk(const pktbuf_t* pktbuf)
 {
     nlist_node_t* last = nlist_last(&pktbuf->blk_list);
@@ -67,14 +123,14 @@ static void display_check_buf(const pktbuf_t* pktbuf)
     {
         plat_printf("idx:%d,", idx++);
 
-        if ((curr->data < curr->payload) ||
-            (curr->data > (curr->payload + PKTBUF_PAYLOAD_SIZE)))
+        if ((curr->data < curr->start) ||
+            (curr->data > curr->end))
         {
             dbug_error(DBG_MOD_PKTBUF, "pktblk data ptr error,addr=%p", curr->data);
             break;
         }
 
-        const long pre_size = curr->data - curr->payload;
+        const long pre_size = curr->data - curr->start;
         plat_printf("pre: %ld b,", pre_size);
         const uint32_t used_size = curr->size;
         plat_printf("used: %d b,", used_size);
@@ -82,7 +138,7 @@ static void display_check_buf(const pktbuf_t* pktbuf)
         plat_printf("free: %ld b\n", free_size);
 
         const long total = pre_size + used_size + free_size;
-        if (total != PKTBUF_PAYLOAD_SIZE)
+        if (total != pktblock_capacity(curr))
         {
             dbug_error(DBG_MOD_PKTBUF, "pktblk size error,total=%ld", total);
         }
@@ -114,10 +170,62 @@ net_err_t pktbuf_init()
     mblock_init(&pktbuf_list, pktbuf_buffer, sizeof(pktbuf_t), PKTBUF_BUF_COUNT,
                 NLOCKER_TYPE_NONE);
 
+    // 初始化巨帧数据区管理器，分配与释放都在locker下进行
+    mblock_init(&jumbo_list, jumbo_buffer, PKTBUF_JUMBO_PAYLOAD_SIZE, PKTBUF_JUMBO_BLK_COUNT,
+                NLOCKER_TYPE_NONE);
+
     dbug_info(DBG_MOD_PKTBUF, "pktbuf init ok");
     return NET_ERR_OK;
 }
 
+static void pktblock_init(pktblk_t* block)
+{
+    block->size = 0;
+    block->data = 0;
+    block->start = block->payload;
+    block->end = block->payload + PKTBUF_PAYLOAD_SIZE;
+    block->release = NULL;
+    block->release_arg = NULL;
+    block->ref = 1;
+    block->owner = NULL;
+    nlist_node_init(&block->node);
+}
+
+// 初始化新分配的pktbuf：空块链、单一引用、无卸载状态
+static void pktbuf_init_meta(pktbuf_t* buf)
+{
+    buf->total_size = 0;
+    buf->ref_count = 1;
+    buf->segs = 1;
+    buf->gso_type = PKTBUF_GSO_NONE;
+    buf->gso_size = 0;
+    buf->csum_state = PKTBUF_CSUM_NONE;
+    buf->csum_start = 0;
+    buf->csum_offset = 0;
+    nlist_init(&buf->blk_list);
+    nlist_node_init(&buf->node);
+}
+
+// 巨帧数据区交还给巨帧池，在pktblock_put_locked中调用，已持有locker
+static void pktblock_jumbo_release(void* arg, uint8_t* start)
+{
+    (void)arg;
+    mblock_free(&jumbo_list, start);
+}
+
+// 为块挂接巨帧数据区，调用者需持有locker；巨帧池耗尽时保留块内数据区
+static void pktblock_attach_jumbo(pktblk_t* block)
+{
+    uint8_t* data = mblock_alloc(&jumbo_list, -1);
+    if (data == NULL)
+    {
+        return;
+    }
+    block->start = data;
+    block->end = data + PKTBUF_JUMBO_PAYLOAD_SIZE;
+    block->release = pktblock_jumbo_release;
+}
+
 static pktblk_t* pktblock_alloc()
 {
     nlocker_lock(&locker);
@@ -125,9 +233,7 @@ static pktblk_t* pktblock_alloc()
     nlocker_unlock(&locker);
     if (block)
     {
-        block->size = 0;
-        block->data = 0;
-        nlist_node_init(&block->node);
+        pktblock_init(block);
     }
     return block;
 }
@@ -148,14 +254,20 @@ static pktblk_t* pktblock_alloc_list(int size, const bool is_head)
             }
             return NULL;
         }
+        if (size > PKTBUF_JUMBO_THRESHOLD)
+        {
+            nlocker_lock(&locker);
+            pktblock_attach_jumbo(new_blk);
+            nlocker_unlock(&locker);
+        }
 
-        const int curr_size =
-            size > PKTBUF_PAYLOAD_SIZE ? PKTBUF_PAYLOAD_SIZE : size;
+        const int capacity = pktblock_capacity(new_blk);
+        const int curr_size = size > capacity ? capacity : size;
         new_blk->size = curr_size;
 
         if (is_head) // 是否头插法
         {
-            new_blk->data = new_blk->payload + (PKTBUF_PAYLOAD_SIZE - curr_size);
+            new_blk->data = new_blk->end - curr_size;
             if (first_blk)
             {
                 new_blk->node.next = &first_blk->node;
@@ -165,7 +277,7 @@ static pktblk_t* pktblock_alloc_list(int size, const bool is_head)
         }
         else
         {
-            new_blk->data = new_blk->payload;
+            new_blk->data = new_blk->start;
 
             if (first_blk == NULL)
             {
@@ -221,16 +333,15 @@ static void pktbuf_insert_blk_list(pktbuf_t* buf, pktblk_t* block,
 
 pktbuf_t* pktbuf_alloc(const int size)
 {
+    nlocker_lock(&locker);
     pktbuf_t* buf = mblock_alloc(&pktbuf_list, -1);
+    nlocker_unlock(&locker);
     if (buf == NULL)
     {
         dbug_error(DBG_MOD_PKTBUF, "pktbuf alloc failed");
         return NULL;
     }
-    buf->total_size = 0;
-    buf->ref_count = 1;
-    nlist_init(&buf->blk_list);
-    nlist_node_init(&buf->node);
+    pktbuf_init_meta(buf);
 
     /**
     添加包头 即为 发送数据 需要头插法
@@ -246,7 +357,9 @@ pktbuf_t* pktbuf_alloc(const int size)
         if (block == NULL)
         {
             dbug_error(DBG_MOD_PKTBUF, "pktblock alloc list failed");
+            nlocker_lock(&locker);
             mblock_free(&pktbuf_list, buf);
+            nlocker_unlock(&locker);
             return NULL;
         }
         pktbuf_insert_blk_list(buf, block, is_head);
@@ -256,14 +369,112 @@ pktbuf_t* pktbuf_alloc(const int size)
     return buf;
 }
 
-void pktbuf_free(pktbuf_t* pktbuf)
+pktbuf_t* pktbuf_alloc_ext(uint8_t* start, const int capacity, const int offset, const int size,
+                           const pktblk_release_t release, void* arg)
+{
+    if (start == NULL || size <= 0 || offset < 0 || offset + size > capacity)
+    {
+        return NULL;
+    }
+
+    nlocker_lock(&locker);
+    pktbuf_t* buf = mblock_alloc(&pktbuf_list, -1);
+    nlocker_unlock(&locker);
+    if (buf == NULL)
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktbuf alloc failed");
+        return NULL;
+    }
+
+    pktblk_t* block = pktblock_alloc();
+    if (block == NULL)
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktblock alloc failed");
+        nlocker_lock(&locker);
+        mblock_free(&pktbuf_list, buf);
+        nlocker_unlock(&locker);
+        return NULL;
+    }
+
+    // 块直接引用外部数据区，释放时由release交还
+    block->start = start;
+    block->end = start + capacity;
+    block->data = start + offset;
+    block->size = size;
+    block->release = release;
+    block->release_arg = arg;
+
+    pktbuf_init_meta(buf);
+    pktbuf_insert_blk_list(buf, block, false);
+    pktbuf_reset_access(buf);
+    display_check_buf(buf);
+    return buf;
+}
+
+int pktbuf_alloc_burst(pktbuf_t** bufs, const int* sizes, const int cnt)
 {
+    int nr = 0;
+
+    // 整批只加锁一次，块按尾插法排列，适合接收后逐层移除包头
     nlocker_lock(&locker);
+    for (; nr < cnt; nr++)
+    {
+        pktbuf_t* buf = mblock_alloc(&pktbuf_list, -1);
+        if (buf == NULL)
+        {
+            break;
+        }
+        pktbuf_init_meta(buf);
+
+        int size = sizes[nr];
+        while (size > 0)
+        {
+            pktblk_t* block = mblock_alloc(&block_list, -1);
+            if (block == NULL)
+            {
+                break;
+            }
+            pktblock_init(block);
+            if (size > PKTBUF_JUMBO_THRESHOLD)
+            {
+                pktblock_attach_jumbo(block);
+            }
+            const int capacity = pktblock_capacity(block);
+            block->size = size > capacity ? capacity : size;
+            block->data = block->start;
+            nlist_insert_last(&buf->blk_list, &block->node);
+            buf->total_size += block->size;
+            size -= block->size;
+        }
 
+        if (size > 0)
+        {
+            pktblock_free_list_locked(pktbuf_first_blk(buf));
+            mblock_free(&pktbuf_list, buf);
+            break;
+        }
+        bufs[nr] = buf;
+    }
+    nlocker_unlock(&locker);
+
+    if (nr < cnt)
+    {
+        dbug_warn(DBG_MOD_PKTBUF, "pktbuf alloc burst: %d/%d allocated", nr, cnt);
+    }
+    for (int i = 0; i < nr; i++)
+    {
+        pktbuf_reset_access(bufs[i]);
+        display_check_buf(bufs[i]);
+    }
+    return nr;
+}
+
+// 调用者需持有locker
+static void pktbuf_free_locked(pktbuf_t* pktbuf)
+{
     // 引用计数大于1 只减少引用计数
     if (!pktbuf || --pktbuf->ref_count > 0)
     {
-        nlocker_unlock(&locker);
         return;
     }
 
@@ -273,14 +484,87 @@ void pktbuf_free(pktbuf_t* pktbuf)
     while (curr)
     {
         pktblk_t* next = pktblock_get_next(curr);
-        mblock_free(&block_list, curr);
+        pktblock_free_locked(curr);
         curr = next;
     }
 
     // free pktbuf
     mblock_free(&pktbuf_list, pktbuf);
+}
+
+void pktbuf_free(pktbuf_t* pktbuf)
+{
+    nlocker_lock(&locker);
+    pktbuf_free_locked(pktbuf);
+    nlocker_unlock(&locker);
+}
+
+pktbuf_t* pktbuf_clone(pktbuf_t* src)
+{
+    pktbuf_t* buf = pktbuf_clone_range(src, 0, (int)src->total_size);
+    if (buf)
+    {
+        buf->segs = src->segs;
+        buf->gso_type = src->gso_type;
+        buf->gso_size = src->gso_size;
+        buf->csum_state = src->csum_state;
+        buf->csum_start = src->csum_start;
+        buf->csum_offset = src->csum_offset;
+    }
+    return buf;
+}
+
+pktbuf_t* pktbuf_clone_range(pktbuf_t* src, int offset, int size)
+{
+    if (offset < 0 || size < 0 || offset + size > (int)src->total_size)
+    {
+        return NULL;
+    }
+
+    nlocker_lock(&locker);
+    pktbuf_t* buf = mblock_alloc(&pktbuf_list, -1);
+    if (buf == NULL)
+    {
+        nlocker_unlock(&locker);
+        return NULL;
+    }
+    pktbuf_init_meta(buf);
+
+    // 新块只引用源块的有效数据，不复制
+    for (pktblk_t* src_blk = pktbuf_first_blk(src); src_blk && size > 0; src_blk = pktblock_get_next(src_blk))
+    {
+        if (offset >= (int)src_blk->size)
+        {
+            offset -= (int)src_blk->size;
+            continue;
+        }
+
+        pktblk_t* block = mblock_alloc(&block_list, -1);
+        if (block == NULL)
+        {
+            pktblock_free_list_locked(pktbuf_first_blk(buf));
+            mblock_free(&pktbuf_list, buf);
+            nlocker_unlock(&locker);
+            return NULL;
+        }
+        const int curr_size = (int)src_blk->size - offset > size ? size : (int)src_blk->size - offset;
+        pktblock_init(block);
+        block->start = block->data = src_blk->data + offset;
+        block->end = block->data + curr_size;
+        block->size = curr_size;
+        // 克隆块引用数据区的所属块，保证数据区在所有克隆释放前有效
+        block->owner = src_blk->owner ? src_blk->owner : src_blk;
+        block->owner->ref++;
+        nlist_insert_last(&buf->blk_list, &block->node);
+        buf->total_size += block->size;
+        size -= curr_size;
+        offset = 0;
+    }
 
     nlocker_unlock(&locker);
+
+    pktbuf_reset_access(buf);
+    return buf;
 }
 
 net_err_t pktbuf_add_header(pktbuf_t* pktbuf, int size, const bool is_cont)
@@ -292,13 +576,14 @@ net_err_t pktbuf_add_header(pktbuf_t* pktbuf, int size, const bool is_cont)
 
     pktblk_t* block = pktbuf_first_blk(pktbuf);
 
-    // 获取剩余空间
-    const int remain_size = (int)(block->data - block->payload);
+    // 获取剩余空间，共享块的头部空间可能仍被其他包引用，不可使用
+    const int remain_size = pktblock_shared(block) ? 0 : (int)(block->data - block->start);
     if (size <= remain_size) // 当前块有足够空间 直接分配
     {
         block->size += size;
         block->data -= size;
         pktbuf->total_size += size;
+        pktbuf->csum_start += size;
         display_check_buf(pktbuf);
         return NET_ERR_OK;
     }
@@ -316,7 +601,7 @@ net_err_t pktbuf_add_header(pktbuf_t* pktbuf, int size, const bool is_cont)
     }
     else // 非连续空间，分配多块
     {
-        block->data = block->payload;
+        block->data -= remain_size;
         block->size += remain_size;
         pktbuf->total_size += remain_size;
         size -= remain_size;
@@ -332,6 +617,7 @@ net_err_t pktbuf_add_header(pktbuf_t* pktbuf, int size, const bool is_cont)
     }
 
     pktbuf_insert_blk_list(pktbuf, new_blk, true);
+    pktbuf->csum_start += size + (is_cont ? 0 : remain_size);
     display_check_buf(pktbuf);
     return NET_ERR_OK;
 }
@@ -348,6 +634,7 @@ net_err_t pktbuf_remove_header(pktbuf_t* pktbuf, int size)
         dbug_error(DBG_MOD_PKTBUF, "pktbuf remove header failed,buf is empty");
         return NET_ERR_SYS;
     }
+    pktbuf->csum_start = pktbuf->csum_start > size ? pktbuf->csum_start - size : 0;
 
     while (size > 0 && block != NULL)
     {
@@ -403,7 +690,7 @@ net_err_t pktbuf_resize(pktbuf_t* pktbuf, const int new_size)
     {
         pktblk_t* last_blk = pktbuf_last_blk(pktbuf);
         const int inc_size = new_size - (int)pktbuf->total_size;
-        const int remain_size = (int)curr_blk_tail_free(last_blk);
+        const int remain_size = pktblock_shared(last_blk) ? 0 : (int)curr_blk_tail_free(last_blk);
         if (inc_size <= remain_size) // 当前块有足够空间 直接分配
         {
             last_blk->size += inc_size;
@@ -482,19 +769,44 @@ net_err_t join_pktbuf(pktbuf_t* dst, pktbuf_t* src)
     return NET_ERR_OK;
 }
 
-net_err_t pktbuf_set_cont(pktbuf_t* pktbuf, const int size)
+// 首块与其他包共享时，把前size字节复制到新的私有首块
+static net_err_t pktbuf_set_cont_private(pktbuf_t* pktbuf, const int size)
 {
-    if (size > (int)pktbuf->total_size)
-    {
-        dbug_error(DBG_MOD_PKTBUF, "pktbuf set cont size too large,size=%d", size);
-        return NET_ERR_INVALID_PARAM;
-    }
     if (size > PKTBUF_PAYLOAD_SIZE)
     {
         dbug_error(DBG_MOD_PKTBUF, "pktbuf set cont size too large for block,size=%d", size);
         return NET_ERR_INVALID_PARAM;
     }
+    pktblk_t* new_blk = pktblock_alloc();
+    if (new_blk == NULL)
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktblock alloc failed");
+        return NET_ERR_MEM;
+    }
+    // 数据放在块尾，保留头部空间供之后添加包头
+    new_blk->size = size;
+    new_blk->data = new_blk->end - size;
+    pktbuf_reset_access(pktbuf);
+    pktbuf_read(pktbuf, new_blk->data, size);
+
+    // 移除包头会调整部分校验和起点，私有块替换的是相同数据，需保持不变
+    const uint16_t csum_start = pktbuf->csum_start;
+    pktbuf_remove_header(pktbuf, size);
+    pktbuf->csum_start = csum_start;
+    nlist_insert_first(&pktbuf->blk_list, &new_blk->node);
+    pktbuf->total_size += size;
+    pktbuf_reset_access(pktbuf);
+    display_check_buf(pktbuf);
+    return NET_ERR_OK;
+}
 
+net_err_t pktbuf_set_cont(pktbuf_t* pktbuf, const int size)
+{
+    if (size > (int)pktbuf->total_size)
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktbuf set cont size too large,size=%d", size);
+        return NET_ERR_INVALID_PARAM;
+    }
     pktblk_t* first_blk = pktbuf_first_blk(pktbuf);
     if (!first_blk)
     {
@@ -502,6 +814,18 @@ net_err_t pktbuf_set_cont(pktbuf_t* pktbuf, const int size)
         return NET_ERR_SYS;
     }
 
+    // 调用者会直接修改连续的包头，共享的首块需先复制
+    if (pktblock_shared(first_blk))
+    {
+        return size > 0 ? pktbuf_set_cont_private(pktbuf, size) : NET_ERR_OK;
+    }
+
+    if (size > pktblock_capacity(first_blk))
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktbuf set cont size too large for block,size=%d", size);
+        return NET_ERR_INVALID_PARAM;
+    }
+
     // 是否已经是连续的
     if (first_blk->size >= (uint32_t)size)
     {
@@ -509,12 +833,12 @@ net_err_t pktbuf_set_cont(pktbuf_t* pktbuf, const int size)
         return NET_ERR_OK;
     }
 
-    uint8_t* dist = first_blk->payload;
+    uint8_t* dist = first_blk->start;
     for (int i = 0; i < first_blk->size; ++i)
     {
         *dist++ = first_blk->data[i];
     }
-    first_blk->data = first_blk->payload;
+    first_blk->data = first_blk->start;
     int remain_size = size - (int)first_blk->size;
     pktblk_t* curr_blk = pktblock_get_next(first_blk);
     while (remain_size && curr_blk)
@@ -599,6 +923,41 @@ static void move_forward(pktbuf_t* pktbuf, const int size)
     }
 }
 
+// 当前块与其他包共享时，复制为私有块链替换之，保持访问位置不变
+static net_err_t pktbuf_unshare_curr(pktbuf_t* pktbuf)
+{
+    pktblk_t* block = pktbuf->curr_blk;
+    if (block == NULL || !pktblock_shared(block))
+    {
+        return NET_ERR_OK;
+    }
+
+    pktblk_t* copy = pktblock_alloc_list((int)block->size, false);
+    if (copy == NULL)
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktbuf unshare failed,size=%d", block->size);
+        return NET_ERR_MEM;
+    }
+
+    const int pos = pktbuf->pos;
+    const uint8_t* src = block->data;
+    pktblk_t* prev = block;
+    while (copy)
+    {
+        pktblk_t* next = pktblock_get_next(copy);
+        plat_memcpy(copy->data, src, copy->size);
+        src += copy->size;
+        nlist_insert_after(&pktbuf->blk_list, &prev->node, &copy->node);
+        prev = copy;
+        copy = next;
+    }
+    nlist_remove(&pktbuf->blk_list, &block->node);
+    pktblock_free(block);
+
+    pktbuf_reset_access(pktbuf);
+    return pktbuf_seek(pktbuf, pos);
+}
+
 net_err_t pktbuf_write(pktbuf_t* pktbuf, const uint8_t* buf, int size)
 {
     if (buf == NULL || size <= 0 || pktbuf == NULL)
@@ -615,6 +974,11 @@ net_err_t pktbuf_write(pktbuf_t* pktbuf, const uint8_t* buf, int size)
 
     while (size)
     {
+        net_err_t err = pktbuf_unshare_curr(pktbuf);
+        if (err != NET_ERR_OK)
+        {
+            return err;
+        }
         const int blk_size = curr_blk_remain(pktbuf);
 
         int curr_copy = size > blk_size ? blk_size : size;
@@ -653,6 +1017,25 @@ net_err_t pktbuf_read(pktbuf_t* pktbuf, uint8_t* buf, int size)
     return NET_ERR_OK;
 }
 
+int pktbuf_to_iovec(const pktbuf_t* pktbuf, pktbuf_iovec_t* iov, const int cnt)
+{
+    int nr = 0;
+    for (pktblk_t* blk = pktbuf_first_blk(pktbuf); blk; blk = pktblock_get_next(blk))
+    {
+        if (blk->size == 0)
+        {
+            continue;
+        }
+        if (nr >= cnt)
+        {
+            return -1;
+        }
+        iov[nr].base = blk->data;
+        iov[nr++].len = (int)blk->size;
+    }
+    return nr;
+}
+
 net_err_t pktbuf_peek(pktbuf_t* pktbuf, uint8_t* buf, const int size,
                       const int offset)
 {
@@ -747,6 +1130,11 @@ net_err_t pktbuf_copy(pktbuf_t* dst, pktbuf_t* src, int size)
 
     while (size)
     {
+        net_err_t err = pktbuf_unshare_curr(dst);
+        if (err != NET_ERR_OK)
+        {
+            return err;
+        }
         const int dst_remain = curr_blk_remain(dst);
         const int src_remain = curr_blk_remain(src);
         int copy_size = dst_remain < src_remain ? dst_remain : src_remain;
@@ -782,6 +1170,11 @@ net_err_t pktbuf_fill(pktbuf_t* pktbuf, const uint8_t value, int size)
 
     while (size)
     {
+        net_err_t err = pktbuf_unshare_curr(pktbuf);
+        if (err != NET_ERR_OK)
+        {
+            return err;
+        }
         const int blk_size = curr_blk_remain(pktbuf);
 
         int curr_fill = size > blk_size ? blk_size : size;
@@ -830,3 +1223,40 @@ uint16_t pktbuf_checksum16(pktbuf_t* buf, int size, const uint32_t pre_sum, bool
 
     return complement ? (uint16_t)~sum : (uint16_t)sum;
 }
+
+void pktbuf_set_csum_partial(pktbuf_t* pktbuf, const int start, const int offset)
+{
+    pktbuf->csum_state = PKTBUF_CSUM_PARTIAL;
+    pktbuf->csum_start = (uint16_t)start;
+    pktbuf->csum_offset = (uint16_t)offset;
+}
+
+net_err_t pktbuf_csum_complete(pktbuf_t* pktbuf)
+{
+    if (pktbuf->csum_state != PKTBUF_CSUM_PARTIAL)
+    {
+        return NET_ERR_OK;
+    }
+
+    const int start = pktbuf->csum_start;
+    const int offset = pktbuf->csum_offset;
+    if (start + offset + (int)sizeof(uint16_t) > (int)pktbuf->total_size)
+    {
+        dbug_error(DBG_MOD_PKTBUF, "pktbuf csum complete: bad start %d offset %d", start, offset);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    pktbuf_reset_access(pktbuf);
+    pktbuf_seek(pktbuf, start);
+    uint16_t csum = pktbuf_checksum16(pktbuf, (int)pktbuf->total_size - start, 0, true);
+    // 0在UDP中表示未计算校验和，用等价的0xFFFF代替
+    if (csum == 0)
+    {
+        csum = 0xFFFF;
+    }
+    pktbuf_seek(pktbuf, start + offset);
+    pktbuf_write(pktbuf, (uint8_t*)&csum, sizeof(uint16_t));
+    pktbuf_reset_access(pktbuf);
+    pktbuf->csum_state = PKTBUF_CSUM_NONE;
+    return NET_ERR_OK;
+}
@@ -56,7 +56,7 @@ static net_err_t raw_sendto(sock_t* sock, const uint8_t* buf, const size_t len,
         sock->local_ip = netif_get_default()->ipaddr;
     }
 
-    err = ipv4_output(sock->protocol, &dest_ip, &sock->local_ip, pktbuf);
+    err = ipv4_output_dst(sock->protocol, &dest_ip, &sock->local_ip, pktbuf, &sock->dst);
     if (err != NET_ERR_OK)
     {
         dbug_error(DBG_MOD_RAW, "raw_sendto: ipv4_output failed, err=%d", err);
@@ -210,9 +210,13 @@ net_err_t raw_input(pktbuf_t* pktbuf)
     {
         dbug_warn(DBG_MOD_RAW, "raw_input: recv queue full, dropping packet");
         pktbuf_free(pktbuf);
-        return NET_ERR_MEM;
+        return NET_ERR_FULL;
     }
 
+    // 应用读到的校验和必须完整，不离开内存的网卡跳过的首部与上层校验和在此补全
+    ipv4_header_csum_complete((ipv4_pkt_t*)ip_header);
+    pktbuf_csum_complete(pktbuf);
+
     nlist_insert_last(&raw->recv_list, &pktbuf->node);
     sock_wakeup(&raw->base,SOCK_WAIT_READ, NET_ERR_OK);
     return NET_ERR_OK;
@@ -0,0 +1,130 @@
+#include "rss.h"
+#include "sys.h"
+#include "ether.h"
+#include "protocol.h"
+
+// 哈希输入的最大长度：源/目的地址 + 源/目的端口
+#define RSS_INPUT_MAX 12
+
+// 读取的帧头最大长度：以太网头 + 802.1Q标签 + 带选项的IPv4头 + 端口
+#define RSS_FRAME_PEEK (sizeof(ether_header_t) + ETHER_VLAN_TAG_LEN + 60 + 4)
+
+// 常用的默认密钥，与多数网卡一致，便于对照
+static const uint8_t rss_default_key[RSS_KEY_LEN] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67,
+    0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb,
+    0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30,
+    0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+void rss_init(rss_t* rss, const int queue_nr)
+{
+    plat_memcpy(rss->key, rss_default_key, RSS_KEY_LEN);
+    for (int i = 0; i < RSS_RETA_SIZE; i++)
+    {
+        rss->reta[i] = queue_nr > 0 ? (uint8_t)(i % queue_nr) : 0;
+    }
+}
+
+net_err_t rss_set_key(rss_t* rss, const uint8_t* key, const int key_len)
+{
+    if (key == NULL || key_len != RSS_KEY_LEN)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    plat_memcpy(rss->key, key, RSS_KEY_LEN);
+    return NET_ERR_OK;
+}
+
+net_err_t rss_set_reta(rss_t* rss, const uint8_t* reta, const int size, const int queue_nr)
+{
+    if (reta == NULL || size <= 0 || size > RSS_RETA_SIZE)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    for (int i = 0; i < size; i++)
+    {
+        if (reta[i] >= queue_nr)
+        {
+            return NET_ERR_INVALID_PARAM;
+        }
+    }
+    for (int i = 0; i < RSS_RETA_SIZE; i++)
+    {
+        rss->reta[i] = reta[i % size];
+    }
+    return NET_ERR_OK;
+}
+
+uint32_t rss_toeplitz(const uint8_t* key, const uint8_t* data, const int len)
+{
+    uint32_t hash = 0;
+    // 密钥的32位滑动窗口，每处理一位左移一位
+    uint32_t window = (uint32_t)key[0] << 24 | (uint32_t)key[1] << 16 | (uint32_t)key[2] << 8 | key[3];
+
+    for (int i = 0; i < len; i++)
+    {
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            if (data[i] & (1 << bit))
+            {
+                hash ^= window;
+            }
+            window <<= 1;
+            if (i + 4 < RSS_KEY_LEN && (key[i + 4] & (1 << bit)))
+            {
+                window |= 1;
+            }
+        }
+    }
+    return hash;
+}
+
+uint32_t rss_hash_frame(const rss_t* rss, const uint8_t* frame, const int len)
+{
+    int ip_start = sizeof(ether_header_t);
+    if (len < ip_start)
+    {
+        return 0;
+    }
+    uint16_t type = frame[12] << 8 | frame[13];
+    // 802.1Q帧跳过标签，按内层的IPv4头哈希，否则所有VLAN流量落在同一队列
+    if (type == PROTOCOL_TYPE_VLAN && len >= (int)sizeof(ether_vlan_header_t))
+    {
+        type = frame[16] << 8 | frame[17];
+        ip_start += ETHER_VLAN_TAG_LEN;
+    }
+    if (len < ip_start + 20 || type != ETHER_TYPE_IPv4)
+    {
+        return 0;
+    }
+
+    const uint8_t* ip = frame + ip_start;
+    const int ip_hdr_len = (ip[0] & 0x0F) * 4;
+    uint8_t input[RSS_INPUT_MAX];
+    int input_len = 8;
+    plat_memcpy(input, ip + 12, 8);
+
+    // 分片中只有首片带端口，统一只用地址对，保证同一报文的分片落在同一队列
+    const int frag = (ip[6] << 8 | ip[7]) & 0x3FFF;
+    const uint8_t protocol = ip[9];
+    if (frag == 0 && (protocol == PROTOCOL_TYPE_TCP || protocol == PROTOCOL_TYPE_UDP) &&
+        len >= ip_start + ip_hdr_len + 4)
+    {
+        plat_memcpy(input + 8, ip + ip_hdr_len, 4);
+        input_len = RSS_INPUT_MAX;
+    }
+    return rss_toeplitz(rss->key, input, input_len);
+}
+
+uint32_t rss_hash_pktbuf(const rss_t* rss, pktbuf_t* buf)
+{
+    uint8_t frame[RSS_FRAME_PEEK];
+    const int total = pktbuf_total(buf);
+    const int len = total < (int)RSS_FRAME_PEEK ? total : (int)RSS_FRAME_PEEK;
+    if (len <= 0 || pktbuf_peek(buf, frame, len, 0) != NET_ERR_OK)
+    {
+        return 0;
+    }
+    return rss_hash_frame(rss, frame, len);
+}
@@ -0,0 +1,167 @@
+#include "rxmod.h"
+#include "sys.h"
+
+net_err_t rxmod_init(rxmod_t* rxmod)
+{
+    if (nlocker_init(&rxmod->locker, NLOCKER_TYPE_THREAD) != NET_ERR_OK)
+    {
+        return NET_ERR_SYS;
+    }
+
+    plat_memset(&rxmod->stats, 0, sizeof(rxmod_stats_t));
+    rxmod->stats.batch = 1;
+    rxmod->pending = 0;
+    rxmod->pending_since = 0;
+    rxmod->sample_start = sys_time_us();
+    rxmod->sample_pkts = 0;
+    rxmod->enabled = RXMOD_ENABLE;
+    return NET_ERR_OK;
+}
+
+// 按平滑后的速率调整批量与等待时间：等待时间随速率线性增长，批量取等待时间内预计到达的包数
+static void rxmod_tune(rxmod_t* rxmod)
+{
+    rxmod_stats_t* stats = &rxmod->stats;
+    if (stats->rate_pps < RXMOD_LOW_PPS)
+    {
+        stats->batch = 1;
+        stats->tmo_us = 0;
+        return;
+    }
+
+    const uint32_t tmo = stats->rate_pps >= RXMOD_HIGH_PPS
+                             ? RXMOD_TMO_MAX_US
+                             : (uint32_t)((uint64_t)RXMOD_TMO_MAX_US * stats->rate_pps / RXMOD_HIGH_PPS);
+    uint64_t batch = (uint64_t)stats->rate_pps * tmo / 1000000;
+    if (batch > RXMOD_BATCH_MAX)
+    {
+        batch = RXMOD_BATCH_MAX;
+    }
+
+    // 等待时间内攒不到两个包，攒批没有意义
+    if (batch <= 1)
+    {
+        stats->batch = 1;
+        stats->tmo_us = 0;
+        return;
+    }
+    stats->batch = (uint32_t)batch;
+    stats->tmo_us = tmo;
+}
+
+// 采样窗口结束时更新到达速率，调用者需持有locker
+static void rxmod_sample(rxmod_t* rxmod, const uint32_t now)
+{
+    const uint32_t elapsed = now - rxmod->sample_start;
+    if (elapsed < RXMOD_SAMPLE_US)
+    {
+        return;
+    }
+
+    // 空闲较久后直接采用新速率，否则按1/4权重平滑，避免单个窗口的抖动
+    const uint32_t rate = (uint32_t)((uint64_t)rxmod->sample_pkts * 1000000 / elapsed);
+    if (elapsed >= RXMOD_SAMPLE_US * 4)
+    {
+        rxmod->stats.rate_pps = rate;
+    }
+    else
+    {
+        rxmod->stats.rate_pps = (uint32_t)(((uint64_t)rxmod->stats.rate_pps * 3 + rate) / 4);
+    }
+    rxmod->sample_start = now;
+    rxmod->sample_pkts = 0;
+
+    rxmod_tune(rxmod);
+}
+
+bool rxmod_arrive(rxmod_t* rxmod, const int nr)
+{
+    nlocker_lock(&rxmod->locker);
+    rxmod->stats.packets += nr;
+    if (!rxmod->enabled)
+    {
+        rxmod->stats.notifies++;
+        nlocker_unlock(&rxmod->locker);
+        return true;
+    }
+
+    const uint32_t now = sys_time_us();
+    rxmod_sample(rxmod, now);
+    rxmod->sample_pkts += nr;
+
+    if (rxmod->pending == 0)
+    {
+        rxmod->pending_since = now;
+    }
+    rxmod->pending += nr;
+
+    bool notify = false;
+    if (rxmod->pending >= rxmod->stats.batch)
+    {
+        notify = true;
+    }
+    else if (now - rxmod->pending_since >= rxmod->stats.tmo_us)
+    {
+        notify = true;
+        rxmod->stats.timeouts++;
+    }
+
+    if (notify)
+    {
+        rxmod->pending = 0;
+        rxmod->stats.notifies++;
+    }
+    nlocker_unlock(&rxmod->locker);
+    return notify;
+}
+
+int rxmod_expire(rxmod_t* rxmod)
+{
+    nlocker_lock(&rxmod->locker);
+    const uint32_t now = sys_time_us();
+    rxmod_sample(rxmod, now);
+
+    int expired = 0;
+    if (rxmod->pending > 0 && now - rxmod->pending_since >= rxmod->stats.tmo_us)
+    {
+        expired = (int)rxmod->pending;
+        rxmod->pending = 0;
+        rxmod->stats.notifies++;
+        rxmod->stats.timeouts++;
+    }
+    nlocker_unlock(&rxmod->locker);
+    return expired;
+}
+
+void rxmod_notify_failed(rxmod_t* rxmod, const int nr)
+{
+    nlocker_lock(&rxmod->locker);
+    // 按已超时记回未通知，下一个包到达或下一次节拍检查时立即重新通知
+    if (rxmod->pending == 0)
+    {
+        rxmod->pending_since = sys_time_us() - rxmod->stats.tmo_us;
+    }
+    rxmod->pending += nr;
+    rxmod->stats.notifies--;
+    nlocker_unlock(&rxmod->locker);
+}
+
+bool rxmod_active(rxmod_t* rxmod)
+{
+    nlocker_lock(&rxmod->locker);
+    const bool active = rxmod->stats.batch > 1 || rxmod->pending > 0;
+    nlocker_unlock(&rxmod->locker);
+    return active;
+}
+
+void rxmod_get_stats(rxmod_t* rxmod, rxmod_stats_t* stats)
+{
+    nlocker_lock(&rxmod->locker);
+    *stats = rxmod->stats;
+    nlocker_unlock(&rxmod->locker);
+}
+
+void rxmod_destroy(rxmod_t* rxmod)
+{
+    nlocker_destroy(&rxmod->locker);
+}
@@ -0,0 +1,203 @@
+#include "shaper.h"
+#include "dbug.h"
+#include "netif.h"
+
+void shaper_init(shaper_t* shaper, struct netif_t* netif)
+{
+    plat_memset(shaper, 0, sizeof(shaper_t));
+    shaper->netif = netif;
+    nlist_node_init(&shaper->timer.node);
+}
+
+// 按经过的微秒数补充令牌，不超过桶容量；补充时间按微秒累计，不丢失不足1毫秒的零头
+static void shaper_refill(shaper_t* shaper)
+{
+    const uint32_t now = sys_time_us();
+    const uint32_t us = now - shaper->last_us;
+    if (us == 0)
+    {
+        return;
+    }
+    shaper->last_us = now;
+    shaper->clock_us += us;
+
+    // 速率单位为字节/秒，乘以微秒数再除以1000即为1/1000字节
+    shaper->tokens += (int64_t)shaper->rate * us / 1000;
+    const int64_t max = (int64_t)shaper->burst * 1000;
+    if (shaper->tokens > max)
+    {
+        shaper->tokens = max;
+    }
+}
+
+// 放行一个包所需的令牌，超过桶容量的大包(如GSO)只需攒满一桶，欠额由之后的包偿还
+static int64_t shaper_need(const shaper_t* shaper, const pktbuf_t* buf)
+{
+    const uint32_t size = buf->total_size < shaper->burst ? buf->total_size : shaper->burst;
+    return (int64_t)size * 1000;
+}
+
+// 扣除令牌后放入网卡发送队列
+static net_err_t shaper_send(shaper_t* shaper, pktbuf_t* buf)
+{
+    const uint32_t size = buf->total_size;
+    const net_err_t err = netif_put_out_raw(shaper->netif, buf, -1);
+    if (err != NET_ERR_OK)
+    {
+        return err;
+    }
+    shaper->tokens -= (int64_t)size * 1000;
+    shaper->stats.packets++;
+    shaper->stats.bytes += size;
+    return NET_ERR_OK;
+}
+
+// 取出队首的包
+static pktbuf_t* shaper_dequeue(shaper_t* shaper)
+{
+    shaper_entry_t* entry = &shaper->queue[shaper->head];
+    pktbuf_t* buf = entry->buf;
+
+    const uint32_t delay = (uint32_t)((shaper->clock_us - entry->time_us) / 1000);
+    shaper->stats.delay_total_ms += delay;
+    if (delay > shaper->stats.delay_max_ms)
+    {
+        shaper->stats.delay_max_ms = delay;
+    }
+
+    entry->buf = NULL;
+    shaper->head = (shaper->head + 1) % SHAPER_QUEUE_SIZE;
+    shaper->count--;
+    shaper->stats.backlog = shaper->count;
+    shaper->stats.backlog_bytes -= buf->total_size;
+    return buf;
+}
+
+// 排队的包放入发送队列并通知驱动，放不进去的丢弃
+static void shaper_xmit(shaper_t* shaper, pktbuf_t* buf)
+{
+    struct netif_t* netif = shaper->netif;
+    if (shaper_send(shaper, buf) != NET_ERR_OK)
+    {
+        dbug_warn(DBG_MOD_NETIF, "shaper_xmit: %s out_q full", netif->name);
+        pktbuf_free(buf);
+        return;
+    }
+    netif->opts->linkoutput(netif);
+}
+
+static void shaper_timer_proc(net_timer_t* timer, void* arg);
+
+// 按队首包所缺的令牌计算等待时间，启动单次定时器
+static void shaper_schedule(shaper_t* shaper)
+{
+    if (shaper->timer_active || shaper->count == 0)
+    {
+        return;
+    }
+
+    const int64_t lack = shaper_need(shaper, shaper->queue[shaper->head].buf) - shaper->tokens;
+    uint32_t ms = lack > 0 ? (uint32_t)((lack + shaper->rate - 1) / shaper->rate) : 1;
+    if (ms == 0)
+    {
+        ms = 1;
+    }
+    net_timer_add(&shaper->timer, "shaper", shaper_timer_proc, shaper, ms, 0);
+    shaper->timer_active = true;
+}
+
+static void shaper_timer_proc(net_timer_t* timer, void* arg)
+{
+    shaper_t* shaper = arg;
+    shaper->timer_active = false;
+
+    shaper_refill(shaper);
+    while (shaper->count > 0 && shaper->tokens >= shaper_need(shaper, shaper->queue[shaper->head].buf))
+    {
+        shaper_xmit(shaper, shaper_dequeue(shaper));
+    }
+    shaper_schedule(shaper);
+}
+
+// 停止节拍定时器
+static void shaper_timer_stop(shaper_t* shaper)
+{
+    if (shaper->timer_active)
+    {
+        net_timer_remove(&shaper->timer);
+        shaper->timer_active = false;
+    }
+}
+
+net_err_t shaper_config(shaper_t* shaper, const uint32_t rate, const uint32_t burst)
+{
+    if (rate > 0 && burst == 0)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    shaper_timer_stop(shaper);
+    shaper->rate = rate;
+    shaper->burst = burst;
+    shaper->tokens = (int64_t)burst * 1000;
+    shaper->last_us = sys_time_us();
+
+    if (rate == 0)
+    {
+        // 关闭整形，积压的包立即放行
+        while (shaper->count > 0)
+        {
+            shaper_xmit(shaper, shaper_dequeue(shaper));
+        }
+        return NET_ERR_OK;
+    }
+
+    // 新速率下重新计算等待时间
+    shaper_schedule(shaper);
+    return NET_ERR_OK;
+}
+
+net_err_t shaper_output(shaper_t* shaper, pktbuf_t* buf)
+{
+    shaper_refill(shaper);
+
+    // 无积压且令牌足够，直接放行，由调用者通知驱动
+    if (shaper->count == 0 && shaper->tokens >= shaper_need(shaper, buf))
+    {
+        return shaper_send(shaper, buf);
+    }
+
+    if (shaper->count >= SHAPER_QUEUE_SIZE)
+    {
+        dbug_warn(DBG_MOD_NETIF, "shaper_output: %s backlog full", shaper->netif->name);
+        shaper->stats.dropped++;
+        netif_stats_drop(shaper->netif, NETIF_DROP_QUEUE_FULL);
+        return NET_ERR_FULL;
+    }
+
+    shaper_entry_t* entry = &shaper->queue[(shaper->head + shaper->count) % SHAPER_QUEUE_SIZE];
+    entry->buf = buf;
+    entry->time_us = shaper->clock_us;
+    shaper->count++;
+
+    shaper->stats.delayed++;
+    shaper->stats.backlog = shaper->count;
+    shaper->stats.backlog_bytes += buf->total_size;
+    if (shaper->stats.backlog > shaper->stats.backlog_max)
+    {
+        shaper->stats.backlog_max = shaper->stats.backlog;
+    }
+
+    shaper_schedule(shaper);
+    return NET_ERR_OK;
+}
+
+void shaper_flush(shaper_t* shaper)
+{
+    shaper_timer_stop(shaper);
+    while (shaper->count > 0)
+    {
+        shaper->stats.dropped++;
+        pktbuf_free(shaper_dequeue(shaper));
+    }
+}
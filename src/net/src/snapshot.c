@@ -0,0 +1,214 @@
+#include "snapshot.h"
+#include "arp.h"
+#include "dbug.h"
+#include "exmsg.h"
+#include "ipv4.h"
+#include "sys.h"
+#include "timer.h"
+
+// 文件标识"TNSS"与格式版本，不匹配的文件整体忽略
+#define SNAPSHOT_MAGIC 0x53534E54
+#define SNAPSHOT_VERSION 1
+
+// 文件内容：头部之后依次为邻居记录与路由记录，按本机字节序保存
+typedef struct snapshot_header_t
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t arp_nr;
+    uint16_t route_nr;
+    uint16_t reserved;
+} snapshot_header_t;
+
+typedef struct snapshot_file_t
+{
+    snapshot_header_t header;
+    arp_record_t arp[ARP_CACHE_SIZE];
+    route_record_t route[IPV4_ROUTE_TABLE_MAX_NR];
+} snapshot_file_t;
+
+// 启动时加载的记录，恢复后清空网卡名称
+static arp_record_t arp_records[ARP_CACHE_SIZE];
+
+static int arp_record_nr;
+
+static route_record_t route_records[IPV4_ROUTE_TABLE_MAX_NR];
+
+static int route_record_nr;
+
+// 读写文件的缓冲区，只在初始化与工作线程中使用
+static snapshot_file_t snapshot_file;
+
+static net_timer_t snapshot_timer;
+
+static net_err_t snapshot_load()
+{
+    const int size = sys_file_load(SNAPSHOT_PATH, &snapshot_file, sizeof(snapshot_file_t));
+    if (size < 0)
+    {
+        dbug_info(DBG_MOD_COMMON, "snapshot_load: no snapshot file %s", SNAPSHOT_PATH);
+        return NET_ERR_OK;
+    }
+
+    const snapshot_header_t* header = &snapshot_file.header;
+    if (size < (int)sizeof(snapshot_header_t) || header->magic != SNAPSHOT_MAGIC ||
+        header->version != SNAPSHOT_VERSION || header->arp_nr > ARP_CACHE_SIZE ||
+        header->route_nr > IPV4_ROUTE_TABLE_MAX_NR || size != (int)sizeof(snapshot_file_t))
+    {
+        dbug_warn(DBG_MOD_COMMON, "snapshot_load: invalid snapshot file %s, ignored", SNAPSHOT_PATH);
+        return NET_ERR_FRAME;
+    }
+
+    arp_record_nr = header->arp_nr;
+    plat_memcpy(arp_records, snapshot_file.arp, sizeof(arp_record_t) * arp_record_nr);
+    for (int i = 0; i < arp_record_nr; i++)
+    {
+        arp_records[i].netif_name[NETIF_NAME_LEN - 1] = '\0';
+    }
+
+    route_record_nr = header->route_nr;
+    plat_memcpy(route_records, snapshot_file.route, sizeof(route_record_t) * route_record_nr);
+    for (int i = 0; i < route_record_nr; i++)
+    {
+        route_records[i].netif_name[NETIF_NAME_LEN - 1] = '\0';
+    }
+
+    dbug_info(DBG_MOD_COMMON, "snapshot_load: %d neighbours, %d routes", arp_record_nr, route_record_nr);
+    return NET_ERR_OK;
+}
+
+// 导出当前的邻居与静态路由写入文件，只在工作线程中调用
+static net_err_t snapshot_write()
+{
+    plat_memset(&snapshot_file, 0, sizeof(snapshot_file_t));
+    snapshot_header_t* header = &snapshot_file.header;
+    header->magic = SNAPSHOT_MAGIC;
+    header->version = SNAPSHOT_VERSION;
+    header->arp_nr = (uint16_t)arp_export(snapshot_file.arp, ARP_CACHE_SIZE);
+    header->route_nr = (uint16_t)route_export(snapshot_file.route, IPV4_ROUTE_TABLE_MAX_NR);
+
+    if (sys_file_save(SNAPSHOT_PATH, &snapshot_file, sizeof(snapshot_file_t)) < 0)
+    {
+        dbug_error(DBG_MOD_COMMON, "snapshot_write: save %s failed", SNAPSHOT_PATH);
+        return NET_ERR_IO;
+    }
+    return NET_ERR_OK;
+}
+
+static void snapshot_timer_proc(net_timer_t* timer, void* arg)
+{
+    snapshot_write();
+}
+
+net_err_t snapshot_init()
+{
+    arp_record_nr = 0;
+    route_record_nr = 0;
+    if (!SNAPSHOT_ENABLE)
+    {
+        return NET_ERR_OK;
+    }
+
+    snapshot_load();
+
+    if (SNAPSHOT_SAVE_PERIOD > 0)
+    {
+        net_err_t err = net_timer_add(&snapshot_timer, "snapshot", snapshot_timer_proc, NULL,
+                                      SNAPSHOT_SAVE_PERIOD * 1000, TIMER_FLAG_PERIODIC);
+        if (err != NET_ERR_OK)
+        {
+            dbug_error(DBG_MOD_COMMON, "snapshot_init: net_timer_add failed, err=%d", err);
+            return err;
+        }
+    }
+    return NET_ERR_OK;
+}
+
+// 恢复属于该网卡的邻居与静态路由，只在工作线程中调用
+static void snapshot_netif_up(netif_t* netif)
+{
+    ipaddr_t addr;
+    for (int i = 0; i < arp_record_nr; i++)
+    {
+        arp_record_t* record = &arp_records[i];
+        if (record->netif_name[0] == '\0' || plat_strcmp(record->netif_name, netif->name) != 0)
+        {
+            continue;
+        }
+        record->netif_name[0] = '\0';
+
+        // 只有以太网卡有邻居；预加载的非静态项标记为STALE，首次使用后在后台确认
+        if (netif->type != NETIF_TYPE_ETHERNET)
+        {
+            continue;
+        }
+        ipaddr_from_buf(&addr, record->p_addr);
+        if (record->permanent)
+        {
+            arp_entry_add_static(netif, &addr, record->hwaddr);
+        }
+        else
+        {
+            arp_preload(netif, &addr, record->hwaddr);
+        }
+    }
+
+    ipaddr_t net, mask, next_hop;
+    for (int i = 0; i < route_record_nr; i++)
+    {
+        route_record_t* record = &route_records[i];
+        if (record->netif_name[0] == '\0' || plat_strcmp(record->netif_name, netif->name) != 0)
+        {
+            continue;
+        }
+        record->netif_name[0] = '\0';
+
+        ipaddr_from_buf(&net, record->net);
+        ipaddr_from_buf(&mask, record->mask);
+        ipaddr_from_buf(&next_hop, record->next_hop);
+        route_entry_add_static(&net, &mask, &next_hop, netif);
+    }
+}
+
+// 逐条查找记录所属的网卡，已激活的网卡一次恢复其全部记录
+static net_err_t snapshot_restore_req_in(const func_msg_t* msg)
+{
+    for (int i = 0; i < arp_record_nr + route_record_nr; i++)
+    {
+        const char* name = i < arp_record_nr ? arp_records[i].netif_name : route_records[i - arp_record_nr].netif_name;
+        if (name[0] == '\0')
+        {
+            continue;
+        }
+
+        netif_t* netif = netif_find(name);
+        if (netif != NULL && netif->state == NETIF_STATE_ACTIVE)
+        {
+            snapshot_netif_up(netif);
+        }
+    }
+    return NET_ERR_OK;
+}
+
+net_err_t snapshot_restore()
+{
+    if (!SNAPSHOT_ENABLE)
+    {
+        return NET_ERR_OK;
+    }
+    return exmsg_func_exec(snapshot_restore_req_in, NULL);
+}
+
+static net_err_t snapshot_save_req_in(const func_msg_t* msg)
+{
+    return snapshot_write();
+}
+
+net_err_t snapshot_save()
+{
+    if (!SNAPSHOT_ENABLE)
+    {
+        return NET_ERR_OK;
+    }
+    return exmsg_func_exec(snapshot_save_req_in, NULL);
+}
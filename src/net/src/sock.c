@@ -208,6 +208,7 @@ net_err_t sock_init(sock_t* sock, const int family, const int protocol, const so
     sock->send_wait = NULL;
     sock->recv_wait = NULL;
     sock->conn_wait = NULL;
+    plat_memset(&sock->dst, 0, sizeof(ipv4_dst_t));
     return NET_ERR_OK;
 }
 
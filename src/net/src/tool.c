@@ -25,28 +25,32 @@ uint16_t checksum16(const void* data, uint16_t size, const uint32_t pre_sum, boo
     return complement ? (uint16_t)~checksum : (uint16_t)checksum;
 }
 
-uint16_t checksum16_pseudo(pktbuf_t* buf, const ipaddr_t* src_ip, const ipaddr_t* dst_ip, const uint8_t protocol)
+uint16_t checksum16_pseudo_hdr(const uint8_t* src_ip, const uint8_t* dst_ip, const uint8_t protocol, const uint16_t len)
 {
     uint8_t pseudo_hdr[12];
 
-    pseudo_hdr[0] = src_ip->a_addr[0];
-    pseudo_hdr[1] = src_ip->a_addr[1];
-    pseudo_hdr[2] = src_ip->a_addr[2];
-    pseudo_hdr[3] = src_ip->a_addr[3];
+    pseudo_hdr[0] = src_ip[0];
+    pseudo_hdr[1] = src_ip[1];
+    pseudo_hdr[2] = src_ip[2];
+    pseudo_hdr[3] = src_ip[3];
 
-    pseudo_hdr[4] = dst_ip->a_addr[0];
-    pseudo_hdr[5] = dst_ip->a_addr[1];
-    pseudo_hdr[6] = dst_ip->a_addr[2];
-    pseudo_hdr[7] = dst_ip->a_addr[3];
+    pseudo_hdr[4] = dst_ip[0];
+    pseudo_hdr[5] = dst_ip[1];
+    pseudo_hdr[6] = dst_ip[2];
+    pseudo_hdr[7] = dst_ip[3];
 
     pseudo_hdr[8] = 0;
     pseudo_hdr[9] = protocol;
 
-    uint16_t total = (uint16_t)buf->total_size;
-    pseudo_hdr[10] = (uint8_t)(total >> 8);
-    pseudo_hdr[11] = (uint8_t)(total & 0xFF);
+    pseudo_hdr[10] = (uint8_t)(len >> 8);
+    pseudo_hdr[11] = (uint8_t)(len & 0xFF);
+
+    return checksum16(pseudo_hdr, sizeof(pseudo_hdr), 0, false);
+}
 
-    uint16_t pre_sum = checksum16(pseudo_hdr, sizeof(pseudo_hdr), 0, false);
+uint16_t checksum16_pseudo(pktbuf_t* buf, const ipaddr_t* src_ip, const ipaddr_t* dst_ip, const uint8_t protocol)
+{
+    uint16_t pre_sum = checksum16_pseudo_hdr(src_ip->a_addr, dst_ip->a_addr, protocol, (uint16_t)buf->total_size);
     pktbuf_reset_access(buf);
     return pktbuf_checksum16(buf, (int)buf->total_size, pre_sum, true);
 }
@@ -82,12 +82,27 @@ static net_err_t udp_sendto(sock_t* sock, const uint8_t* buf, const size_t len,
         return NET_ERR_INVALID_PARAM;
     }
 
+    // 开启UDP_SEGMENT时超长数据一次构造大包，由网卡或netif层按gso_size分段
+    const udp_t* udp = (udp_t*)sock;
+    const bool gso = udp->gso_size && len > udp->gso_size;
+    if (gso && (len + sizeof(udp_header_t) + sizeof(ipv4_header_t) > 0xFFFF ||
+        (len + udp->gso_size - 1) / udp->gso_size > GSO_MAX_SEGS))
+    {
+        dbug_error(DBG_MOD_UDP, "raw_sendto: too many segments, len=%d, gso_size=%d", (int)len, udp->gso_size);
+        return NET_ERR_INVALID_PARAM;
+    }
+
     pktbuf_t* pktbuf = pktbuf_alloc((int)len);
     if (pktbuf == NULL)
     {
         dbug_error(DBG_MOD_UDP, "raw_sendto: pktbuf_alloc failed");
         return NET_ERR_MEM;
     }
+    if (gso)
+    {
+        pktbuf->gso_type = PKTBUF_GSO_UDP;
+        pktbuf->gso_size = udp->gso_size;
+    }
 
     net_err_t err = pktbuf_write(pktbuf, buf, (int)len);
     if (err != NET_ERR_OK)
@@ -102,7 +117,7 @@ static net_err_t udp_sendto(sock_t* sock, const uint8_t* buf, const size_t len,
         sock->local_ip = netif_get_default()->ipaddr;
     }
 
-    err = upd_output(&dest_ip, dest_port, &sock->local_ip, sock->local_port, pktbuf);
+    err = upd_output(&dest_ip, dest_port, &sock->local_ip, sock->local_port, pktbuf, &sock->dst);
     if (err != NET_ERR_OK)
     {
         dbug_error(DBG_MOD_UDP, "raw_sendto: ipv4_output failed, err=%d", err);
@@ -119,6 +134,34 @@ static net_err_t udp_recvfrom(sock_t* sock, uint8_t* buf, const size_t len, int
     return NET_ERR_OK;
 }
 
+static net_err_t udp_setopt(sock_t* sock, const int level, const int opt_name, const void* opt_val, const int opt_len)
+{
+    if (level != SOL_UDP)
+    {
+        return sock_setopt(sock, level, opt_name, opt_val, opt_len);
+    }
+
+    udp_t* udp = (udp_t*)sock;
+    switch (opt_name)
+    {
+    case UDP_SEGMENT:
+        if (opt_len != sizeof(int))
+        {
+            return NET_ERR_INVALID_PARAM;
+        }
+        int gso_size = *(const int*)opt_val;
+        if (gso_size < 0 || gso_size > 0xFFFF - sizeof(udp_header_t) - sizeof(ipv4_header_t))
+        {
+            return NET_ERR_INVALID_PARAM;
+        }
+        udp->gso_size = (uint16_t)gso_size;
+        break;
+    default:
+        return NET_ERR_OPTION;
+    }
+    return NET_ERR_OK;
+}
+
 static net_err_t udp_close(sock_t* sock)
 {
     udp_t* udp = (udp_t*)sock;
@@ -147,7 +190,7 @@ sock_t* udp_create(const int family, const int protocol)
     static const sock_ops_t udp_ops = {
         .sendto = udp_sendto,
         .recvfrom = udp_recvfrom,
-        .setopt = sock_setopt,
+        .setopt = udp_setopt,
         .close = udp_close,
     };
     udp_t* udp = mblock_alloc(&udp_mblock, -1);
@@ -173,6 +216,7 @@ sock_t* udp_create(const int family, const int protocol)
 
     nlist_insert_last(&udp_list, &udp->base.node);
     nlist_init(&udp->recv_list);
+    udp->gso_size = 0;
 
     return &udp->base;
 
@@ -183,7 +227,7 @@ create_fail:
 }
 
 net_err_t upd_output(const ipaddr_t* dest_ip, const uint16_t dest_port, const ipaddr_t* src_ip, const uint16_t src_port,
-                     pktbuf_t* buf)
+                     pktbuf_t* buf, ipv4_dst_t* dst)
 {
     net_err_t err = pktbuf_add_header(buf, sizeof(udp_header_t), true);
     if (err != NET_ERR_OK)
@@ -196,9 +240,15 @@ net_err_t upd_output(const ipaddr_t* dest_ip, const uint16_t dest_port, const ip
     udp_hdr->dest_port = x_htons(dest_port);
     udp_hdr->length = x_htons(buf->total_size);
     udp_hdr->checksum = 0;
-    udp_hdr->checksum = checksum16_pseudo(buf, src_ip, dest_ip, IPPROTO_UDP);
+    // GSO大包的校验和在分段时逐段计算；普通包只填伪首部和，由网卡或发送前补全
+    if (buf->gso_type == PKTBUF_GSO_NONE)
+    {
+        udp_hdr->checksum = checksum16_pseudo_hdr(src_ip->a_addr, dest_ip->a_addr, IPPROTO_UDP,
+                                                  (uint16_t)buf->total_size);
+        pktbuf_set_csum_partial(buf, 0, offsetof(udp_header_t, checksum));
+    }
 
-    err = ipv4_output(IPPROTO_UDP, dest_ip, src_ip, buf);
+    err = ipv4_output_dst(IPPROTO_UDP, dest_ip, src_ip, buf, dst);
     if (err != NET_ERR_OK)
     {
         dbug_error(DBG_MOD_UDP, "upd_output: ipv4_output failed, err=%d", err);
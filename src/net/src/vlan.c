@@ -0,0 +1,165 @@
+#include "vlan.h"
+#include "dbug.h"
+#include "ether.h"
+#include "mblock.h"
+#include "tool.h"
+
+static vlan_table_t vlan_table_buffer[VLAN_PARENT_MAX];
+
+static mblock_t vlan_table_mblock;
+
+// 创建子接口时传给打开函数的参数
+typedef struct vlan_cfg_t
+{
+    netif_t* parent;
+    uint16_t vlan_id;
+} vlan_cfg_t;
+
+net_err_t vlan_init()
+{
+    return mblock_init(&vlan_table_mblock, vlan_table_buffer, sizeof(vlan_table_t), VLAN_PARENT_MAX,
+                       NLOCKER_TYPE_THREAD);
+}
+
+static net_err_t vlan_netif_open(netif_t* netif, void* data)
+{
+    const vlan_cfg_t* cfg = data;
+    netif_t* parent = cfg->parent;
+    if (parent->type != NETIF_TYPE_ETHERNET || parent->vlan_parent != NULL || parent->bond_master != NULL)
+    {
+        dbug_error(DBG_MOD_ETHER, "vlan_open: parent %s is not an ethernet port", parent->name);
+        return NET_ERR_INVALID_PARAM;
+    }
+    // 0与4095为保留值
+    if (cfg->vlan_id == 0 || cfg->vlan_id >= VLAN_ID_NR - 1)
+    {
+        dbug_error(DBG_MOD_ETHER, "vlan_open: invalid vlan id %d", cfg->vlan_id);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    if (parent->vlans == NULL)
+    {
+        vlan_table_t* table = mblock_alloc(&vlan_table_mblock, -1);
+        if (table == NULL)
+        {
+            dbug_error(DBG_MOD_ETHER, "vlan_open: no free vlan table for %s", parent->name);
+            return NET_ERR_MEM;
+        }
+        plat_memset(table, 0, sizeof(vlan_table_t));
+        parent->vlans = table;
+    }
+    else if (parent->vlans->netif[cfg->vlan_id] != NULL)
+    {
+        dbug_error(DBG_MOD_ETHER, "vlan_open: vlan %d already exists on %s", cfg->vlan_id, parent->name);
+        return NET_ERR_EXIST;
+    }
+    parent->vlans->netif[cfg->vlan_id] = netif;
+    parent->vlans->count++;
+
+    // 标签不计入MTU，子接口MTU不超过父接口；只继承不改变帧结构的校验和卸载
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->vlan_parent = parent;
+    netif->vlan_id = cfg->vlan_id;
+    netif->mtu = parent->mtu;
+    netif->mtu_max = parent->mtu;
+    netif->features = parent->features & NETIF_FEATURE_CSUM_PARTIAL;
+    netif_set_hwaddr(netif, parent->hwaddr.addr, parent->hwaddr.len);
+    return NET_ERR_OK;
+}
+
+static net_err_t vlan_netif_close(netif_t* netif)
+{
+    netif_t* parent = netif->vlan_parent;
+    if (parent == NULL || parent->vlans == NULL)
+    {
+        return NET_ERR_OK;
+    }
+
+    parent->vlans->netif[netif->vlan_id] = NULL;
+    if (--parent->vlans->count == 0)
+    {
+        mblock_free(&vlan_table_mblock, parent->vlans);
+        parent->vlans = NULL;
+    }
+    netif->vlan_parent = NULL;
+    return NET_ERR_OK;
+}
+
+// 已加标签的帧转入父接口发送队列，由父接口的发送线程发出
+static net_err_t vlan_netif_output(netif_t* netif)
+{
+    netif_t* parent = netif->vlan_parent;
+    pktbuf_t* buf;
+    while ((buf = netif_get_out(netif, -1)) != NULL)
+    {
+        const net_err_t err = netif_put_out(parent, buf, -1);
+        if (err != NET_ERR_OK)
+        {
+            dbug_warn(DBG_MOD_ETHER, "vlan_output: %s put to parent %s failed, err=%d", netif->name, parent->name,
+                      err);
+            pktbuf_free(buf);
+        }
+    }
+    return parent->opts->linkoutput(parent);
+}
+
+static netif_open_options_t vlan_netif_ops = {
+    .open = vlan_netif_open,
+    .close = vlan_netif_close,
+    .linkoutput = vlan_netif_output,
+};
+
+netif_t* vlan_open(netif_t* parent, const uint16_t vlan_id, const char* name)
+{
+    vlan_cfg_t cfg = {.parent = parent, .vlan_id = vlan_id};
+    netif_t* netif = netif_open(name, &vlan_netif_ops, &cfg);
+    if (netif != NULL)
+    {
+        // 参数只在打开时使用
+        netif->opts_data = NULL;
+    }
+    return netif;
+}
+
+net_err_t vlan_input(netif_t* netif, pktbuf_t* buf)
+{
+    net_err_t err = pktbuf_set_cont(buf, sizeof(ether_vlan_header_t));
+    if (err != NET_ERR_OK)
+    {
+        dbug_warn(DBG_MOD_ETHER, "vlan_input: short tagged frame, err=%d", err);
+        netif_stats_drop(netif, NETIF_DROP_BAD_FRAME);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
+    }
+
+    ether_vlan_header_t* hdr = (ether_vlan_header_t*)pktbuf_data(buf);
+    const uint16_t vlan_id = x_ntohs(hdr->tci) & (VLAN_ID_NR - 1);
+    netif_t* vlan = netif->vlans != NULL ? netif->vlans->netif[vlan_id] : NULL;
+    if (vlan == NULL || vlan->state != NETIF_STATE_ACTIVE)
+    {
+        dbug_info(DBG_MOD_ETHER, "vlan_input: no sub-interface for vlan %d on %s", vlan_id, netif->name);
+        netif_stats_drop(netif, NETIF_DROP_NOT_FOR_US);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
+    }
+
+    // MAC地址后移覆盖标签，得到普通以太网帧；区域重叠，从后往前复制
+    uint8_t* mac = (uint8_t*)hdr;
+    for (int i = 2 * ETHER_HWADDR_LEN - 1; i >= 0; i--)
+    {
+        mac[i + ETHER_VLAN_TAG_LEN] = mac[i];
+    }
+    if ((err = pktbuf_remove_header(buf, ETHER_VLAN_TAG_LEN)) != NET_ERR_OK)
+    {
+        dbug_warn(DBG_MOD_ETHER, "vlan_input: pktbuf_remove_header failed, err=%d", err);
+        pktbuf_free(buf);
+        return NET_ERR_OK;
+    }
+
+    netif_stats_rx(vlan, buf->total_size);
+    if (vlan->capture)
+    {
+        netif_capture_pkt(vlan, buf, NETIF_CAPTURE_RX);
+    }
+    return vlan->link_layer->input(vlan, buf);
+}
@@ -0,0 +1,480 @@
+#include "netif_capture.h"
+#include "sys_plat.h"
+#include "exmsg.h"
+#include "dbug.h"
+#include "mblock.h"
+#include <stdio.h>
+
+// 抓包环的内存屏障，保证条目写完后再更新索引
+#if defined(_MSC_VER)
+#define CAPTURE_BARRIER() MemoryBarrier()
+#else
+#define CAPTURE_BARRIER() __sync_synchronize()
+#endif
+
+// pcapng块类型
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+// pcapng选项
+#define PCAPNG_OPT_END 0
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_EPB_FLAGS 2
+
+// epb_flags中的方向
+#define PCAPNG_EPB_INBOUND 1
+#define PCAPNG_EPB_OUTBOUND 2
+
+#define PCAPNG_LINKTYPE_ETHERNET 1
+
+#define PCAPNG_PAD4(len) (((len) + 3) & ~3)
+
+typedef struct capture_entry_t
+{
+    // 包的原始长度与保存的长度
+    int len;
+    int caplen;
+    net_time_t ts;
+    netif_capture_dir_t dir;
+    // 包数据的私有副本在数据区中的起点，以及写完后数据区可释放到的位置
+    uint32_t data_start;
+    uint32_t data_end;
+} capture_entry_t;
+
+typedef struct capture_t
+{
+    netif_t* netif;
+    // 单生产者单消费者环：工作线程写head与data_head，写文件线程写tail与data_tail
+    capture_entry_t ring[CAPTURE_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    // 包数据连续存放，放不下时跳到数据区开头；位置只增不减，取模得到偏移
+    uint8_t data[CAPTURE_DATA_SIZE];
+    volatile uint32_t data_head;
+    volatile uint32_t data_tail;
+    // 写文件线程等待新包时置位，工作线程入环后据此唤醒
+    volatile bool waiting;
+    sys_sem_t wake_sem;
+
+    char file[CAPTURE_PATH_LEN];
+    int snaplen;
+    int file_size;
+    int file_count;
+    bool has_filter;
+    struct bpf_program prog;
+
+    FILE* fp;
+    int file_bytes;
+
+    volatile bool running;
+    sys_sem_t exit_sem;
+    capture_stats_t stats;
+} capture_t;
+
+static capture_t capture_tbl[CAPTURE_NR];
+
+static mblock_t capture_mblock;
+
+static bool capture_inited = false;
+
+// 工作线程中调用，只复制snaplen以内的数据并入环，环满时丢弃抓包
+static void capture_hook(netif_t* netif, pktbuf_t* buf, const netif_capture_dir_t dir)
+{
+    capture_t* cap = netif->capture_data;
+    const uint32_t head = cap->head;
+    if (head - cap->tail >= CAPTURE_RING_SIZE)
+    {
+        cap->stats.dropped++;
+        return;
+    }
+
+    const int len = (int)buf->total_size;
+    const int caplen = len < cap->snaplen ? len : cap->snaplen;
+
+    // 数据不跨越数据区末尾，剩余部分不够时从开头放起
+    uint32_t start = cap->data_head;
+    const uint32_t offset = start & (CAPTURE_DATA_SIZE - 1);
+    if (offset + caplen > CAPTURE_DATA_SIZE)
+    {
+        start += CAPTURE_DATA_SIZE - offset;
+    }
+    if (start + caplen - cap->data_tail > CAPTURE_DATA_SIZE)
+    {
+        cap->stats.dropped++;
+        return;
+    }
+
+    capture_entry_t* entry = &cap->ring[head & (CAPTURE_RING_SIZE - 1)];
+    entry->len = len;
+    entry->caplen = caplen;
+    entry->data_start = start;
+    entry->data_end = start + caplen;
+    if (caplen > 0 &&
+        pktbuf_peek(buf, cap->data + (start & (CAPTURE_DATA_SIZE - 1)), caplen, 0) != NET_ERR_OK)
+    {
+        cap->stats.dropped++;
+        return;
+    }
+    entry->dir = dir;
+    sys_time_curr(&entry->ts);
+    CAPTURE_BARRIER();
+    cap->data_head = entry->data_end;
+    cap->head = head + 1;
+    cap->stats.captured++;
+
+    // 写文件线程在等待时才唤醒，忙时不产生额外的通知
+    CAPTURE_BARRIER();
+    if (cap->waiting)
+    {
+        cap->waiting = false;
+        sys_sem_notify(cap->wake_sem);
+    }
+}
+
+static uint64_t capture_time_us(const net_time_t* ts)
+{
+#if defined(SYS_PLAT_LINUX)
+    return (uint64_t)ts->tv_sec * 1000000 + ts->tv_usec;
+#else
+    return (uint64_t)(*ts) * 1000;
+#endif
+}
+
+static void capture_put16(capture_t* cap, const uint16_t v)
+{
+    fwrite(&v, sizeof(v), 1, cap->fp);
+}
+
+static void capture_put32(capture_t* cap, const uint32_t v)
+{
+    fwrite(&v, sizeof(v), 1, cap->fp);
+}
+
+static void capture_put_pad(capture_t* cap, const int len)
+{
+    static const uint8_t zero[4] = {0};
+    fwrite(zero, 1, PCAPNG_PAD4(len) - len, cap->fp);
+}
+
+// 写入节头块与接口描述块
+static void capture_write_header(capture_t* cap)
+{
+    // SHB: 类型 长度 字节序 版本(1.0) 节长度(-1) 长度
+    capture_put32(cap, PCAPNG_BLOCK_SHB);
+    capture_put32(cap, 28);
+    capture_put32(cap, PCAPNG_BYTE_ORDER_MAGIC);
+    capture_put16(cap, 1);
+    capture_put16(cap, 0);
+    capture_put32(cap, 0xFFFFFFFF);
+    capture_put32(cap, 0xFFFFFFFF);
+    capture_put32(cap, 28);
+
+    // IDB: 链路类型 保留 snaplen if_name选项 结束选项
+    const int name_len = (int)plat_strlen(cap->netif->name);
+    const int idb_len = 20 + 4 + PCAPNG_PAD4(name_len) + 4;
+    capture_put32(cap, PCAPNG_BLOCK_IDB);
+    capture_put32(cap, idb_len);
+    capture_put16(cap, PCAPNG_LINKTYPE_ETHERNET);
+    capture_put16(cap, 0);
+    capture_put32(cap, cap->snaplen);
+    capture_put16(cap, PCAPNG_OPT_IF_NAME);
+    capture_put16(cap, name_len);
+    fwrite(cap->netif->name, 1, name_len, cap->fp);
+    capture_put_pad(cap, name_len);
+    capture_put32(cap, PCAPNG_OPT_END);
+    capture_put32(cap, idb_len);
+
+    cap->file_bytes = 28 + idb_len;
+}
+
+// 打开新文件或在超过大小时轮转到下一个文件
+static net_err_t capture_rotate(capture_t* cap)
+{
+    if (cap->fp && (cap->file_size <= 0 || cap->file_bytes < cap->file_size))
+    {
+        return NET_ERR_OK;
+    }
+
+    char path[CAPTURE_PATH_LEN + 16];
+    if (cap->fp)
+    {
+        fclose(cap->fp);
+        cap->fp = NULL;
+        cap->stats.file_index++;
+    }
+    if (cap->file_size > 0)
+    {
+        const int index = cap->file_count > 0 ? cap->stats.file_index % cap->file_count : cap->stats.file_index;
+        plat_sprintf(path, "%s.%d", cap->file, index);
+    }
+    else
+    {
+        plat_strcpy(path, cap->file);
+    }
+
+    cap->fp = fopen(path, "wb");
+    if (cap->fp == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "capture: open %s failed", path);
+        return NET_ERR_IO;
+    }
+    capture_write_header(cap);
+    return NET_ERR_OK;
+}
+
+static const uint8_t* capture_entry_data(const capture_t* cap, const capture_entry_t* entry)
+{
+    return cap->data + (entry->data_start & (CAPTURE_DATA_SIZE - 1));
+}
+
+static void capture_write(capture_t* cap, const capture_entry_t* entry)
+{
+    const int len = entry->len;
+    const int caplen = entry->caplen;
+
+    if (cap->has_filter)
+    {
+        struct pcap_pkthdr hdr;
+        plat_memset(&hdr, 0, sizeof(hdr));
+        hdr.caplen = caplen;
+        hdr.len = len;
+        if (pcap_offline_filter(&cap->prog, &hdr, capture_entry_data(cap, entry)) == 0)
+        {
+            cap->stats.filtered++;
+            return;
+        }
+    }
+
+    if (capture_rotate(cap) != NET_ERR_OK)
+    {
+        cap->stats.write_errors++;
+        return;
+    }
+
+    // EPB: 接口 时间戳(高/低) 抓取长度 原始长度 数据 epb_flags选项 结束选项
+    const int epb_len = 32 + PCAPNG_PAD4(caplen) + 8 + 4;
+    const uint64_t ts = capture_time_us(&entry->ts);
+    capture_put32(cap, PCAPNG_BLOCK_EPB);
+    capture_put32(cap, epb_len);
+    capture_put32(cap, 0);
+    capture_put32(cap, (uint32_t)(ts >> 32));
+    capture_put32(cap, (uint32_t)ts);
+    capture_put32(cap, caplen);
+    capture_put32(cap, len);
+    fwrite(capture_entry_data(cap, entry), 1, caplen, cap->fp);
+    capture_put_pad(cap, caplen);
+    capture_put16(cap, PCAPNG_OPT_EPB_FLAGS);
+    capture_put16(cap, 4);
+    capture_put32(cap, entry->dir == NETIF_CAPTURE_RX ? PCAPNG_EPB_INBOUND : PCAPNG_EPB_OUTBOUND);
+    capture_put32(cap, PCAPNG_OPT_END);
+    capture_put32(cap, epb_len);
+
+    cap->file_bytes += epb_len;
+    cap->stats.written++;
+}
+
+static void capture_thread(void* arg)
+{
+    capture_t* cap = arg;
+    plat_printf("capture thread started\n");
+
+    // 停止后写完环中剩余的包再退出
+    for (;;)
+    {
+        const uint32_t tail = cap->tail;
+        if (tail == cap->head)
+        {
+            if (!cap->running)
+            {
+                break;
+            }
+            if (cap->fp)
+            {
+                fflush(cap->fp);
+            }
+
+            // 置位后再检查一次，避免错过置位前入环的包
+            cap->waiting = true;
+            CAPTURE_BARRIER();
+            if (cap->tail == cap->head && cap->running)
+            {
+                sys_sem_wait(cap->wake_sem, 0);
+            }
+            cap->waiting = false;
+            continue;
+        }
+        CAPTURE_BARRIER();
+
+        capture_entry_t* entry = &cap->ring[tail & (CAPTURE_RING_SIZE - 1)];
+        capture_write(cap, entry);
+        CAPTURE_BARRIER();
+        cap->data_tail = entry->data_end;
+        cap->tail = tail + 1;
+    }
+
+    if (cap->fp)
+    {
+        fclose(cap->fp);
+        cap->fp = NULL;
+    }
+    sys_sem_notify(cap->exit_sem);
+}
+
+// 在工作线程中挂载与卸载回调，避免与收发路径竞争
+static net_err_t capture_attach(const func_msg_t* msg)
+{
+    capture_t* cap = msg->arg;
+    cap->netif->capture_data = cap;
+    cap->netif->capture = capture_hook;
+    return NET_ERR_OK;
+}
+
+static net_err_t capture_detach(const func_msg_t* msg)
+{
+    netif_t* netif = msg->arg;
+    netif->capture = NULL;
+    netif->capture_data = NULL;
+    return NET_ERR_OK;
+}
+
+static void capture_free(capture_t* cap)
+{
+    if (cap->has_filter)
+    {
+        pcap_freecode(&cap->prog);
+    }
+    if (cap->exit_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(cap->exit_sem);
+    }
+    if (cap->wake_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(cap->wake_sem);
+    }
+    mblock_free(&capture_mblock, cap);
+}
+
+net_err_t netif_capture_start(netif_t* netif, const capture_cfg_t* cfg)
+{
+    if (netif->capture)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_capture_start: %s already capturing", netif->name);
+        return NET_ERR_EXIST;
+    }
+    if (cfg->file == NULL || plat_strlen(cfg->file) >= CAPTURE_PATH_LEN)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    if (!capture_inited)
+    {
+        mblock_init(&capture_mblock, capture_tbl, sizeof(capture_t), CAPTURE_NR, NLOCKER_TYPE_THREAD);
+        capture_inited = true;
+    }
+
+    capture_t* cap = mblock_alloc(&capture_mblock, -1);
+    if (cap == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_capture_start: no free capture");
+        return NET_ERR_MEM;
+    }
+    cap->netif = netif;
+    cap->head = cap->tail = 0;
+    cap->data_head = cap->data_tail = 0;
+    cap->waiting = false;
+    plat_strcpy(cap->file, cfg->file);
+    // 默认只保存协议头，减少工作线程中的复制量
+    cap->snaplen = cfg->snaplen > 0 ? cfg->snaplen : CAPTURE_SNAPLEN_DEFAULT;
+    cap->snaplen = cap->snaplen < CAPTURE_SLOT_SIZE ? cap->snaplen : CAPTURE_SLOT_SIZE;
+    cap->file_size = cfg->file_size;
+    cap->file_count = cfg->file_count;
+    cap->has_filter = false;
+    cap->fp = NULL;
+    cap->file_bytes = 0;
+    cap->exit_sem = SYS_SEM_INVALID;
+    cap->wake_sem = SYS_SEM_INVALID;
+    plat_memset(&cap->stats, 0, sizeof(capture_stats_t));
+
+    // 过滤表达式在写文件线程中执行，不占用收发路径
+    if (cfg->filter)
+    {
+        pcap_t* pcap = pcap_open_dead(DLT_EN10MB, CAPTURE_SNAPLEN_MAX);
+        if (pcap == NULL)
+        {
+            goto start_failed;
+        }
+        if (pcap_compile(pcap, &cap->prog, cfg->filter, 1, PCAP_NETMASK_UNKNOWN) == -1)
+        {
+            dbug_error(DBG_MOD_PLATFORM, "netif_capture_start: bad filter %s: %s", cfg->filter, pcap_geterr(pcap));
+            pcap_close(pcap);
+            goto start_failed;
+        }
+        pcap_close(pcap);
+        cap->has_filter = true;
+    }
+
+    cap->exit_sem = sys_sem_create(0);
+    cap->wake_sem = sys_sem_create(0);
+    if (cap->exit_sem == SYS_SEM_INVALID || cap->wake_sem == SYS_SEM_INVALID)
+    {
+        goto start_failed;
+    }
+
+    cap->running = true;
+    if (sys_thread_create(capture_thread, cap) == SYS_THREAD_INVALID)
+    {
+        goto start_failed;
+    }
+
+    net_err_t err = exmsg_func_exec(capture_attach, cap);
+    if (err != NET_ERR_OK)
+    {
+        cap->running = false;
+        sys_sem_notify(cap->wake_sem);
+        sys_sem_wait(cap->exit_sem, 0);
+        capture_free(cap);
+        return err;
+    }
+    return NET_ERR_OK;
+
+start_failed:
+    capture_free(cap);
+    return NET_ERR_SYS;
+}
+
+net_err_t netif_capture_stop(netif_t* netif)
+{
+    capture_t* cap = netif->capture_data;
+    if (cap == NULL)
+    {
+        return NET_ERR_INVALID_STATE;
+    }
+
+    // 先卸载回调，此后不再有新包入环
+    net_err_t err = exmsg_func_exec(capture_detach, netif);
+    if (err != NET_ERR_OK)
+    {
+        return err;
+    }
+
+    cap->running = false;
+    sys_sem_notify(cap->wake_sem);
+    sys_sem_wait(cap->exit_sem, 0);
+    dbug_info(DBG_MOD_PLATFORM, "capture %s: captured=%d written=%d dropped=%d", netif->name,
+              (int)cap->stats.captured, (int)cap->stats.written, (int)cap->stats.dropped);
+    capture_free(cap);
+    return NET_ERR_OK;
+}
+
+net_err_t netif_capture_get_stats(netif_t* netif, capture_stats_t* stats)
+{
+    const capture_t* cap = netif->capture_data;
+    if (cap == NULL)
+    {
+        return NET_ERR_INVALID_STATE;
+    }
+    *stats = cap->stats;
+    return NET_ERR_OK;
+}
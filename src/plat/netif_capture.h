@@ -0,0 +1,67 @@
+#ifndef TINY_NET_NETIF_CAPTURE_H
+#define TINY_NET_NETIF_CAPTURE_H
+
+#include "net_err.h"
+#include "netif.h"
+
+// 同时抓包的网卡数量
+#define CAPTURE_NR 2
+
+// 抓包环条目数，必须为2的幂，按线速突发预留
+#define CAPTURE_RING_SIZE 1024
+
+// 抓包环数据区大小，必须为2的幂；各条目按实际保存长度占用，不占用pktbuf
+#define CAPTURE_DATA_SIZE (1 << 20)
+
+// 最大抓包长度
+#define CAPTURE_SNAPLEN_MAX 65535
+
+// 未指定时每个包保存的字节数，足够容纳常见协议头
+#define CAPTURE_SNAPLEN_DEFAULT 128
+
+// 每个包最多保存的字节数，容纳最大MTU的帧，更长的包被截断
+#define CAPTURE_SLOT_SIZE (NETIF_MTU_MAX + 64)
+
+// 输出文件路径最大长度
+#define CAPTURE_PATH_LEN 256
+
+typedef struct capture_cfg_t
+{
+    // 输出的pcapng文件路径，轮转时追加 .序号
+    const char* file;
+    // tcpdump语法的过滤表达式，为NULL时不过滤
+    const char* filter;
+    // 每个包保存的最大字节数，0表示使用CAPTURE_SNAPLEN_DEFAULT，最大为CAPTURE_SLOT_SIZE
+    int snaplen;
+    // 单个文件的最大字节数，0表示不轮转
+    int file_size;
+    // 轮转的文件个数，超过后覆盖最早的文件，0表示不覆盖
+    int file_count;
+} capture_cfg_t;
+
+typedef struct capture_stats_t
+{
+    // 放入抓包环的包数
+    uint64_t captured;
+    // 写入文件的包数
+    uint64_t written;
+    // 被过滤表达式丢弃的包数
+    uint64_t filtered;
+    // 抓包环已满而丢弃的包数
+    uint64_t dropped;
+    // 写文件失败的包数
+    uint64_t write_errors;
+    // 当前写入的文件序号
+    int file_index;
+} capture_stats_t;
+
+// 在网卡上开始抓包，收发的包被复制到抓包环后异步写入文件
+net_err_t netif_capture_start(netif_t* netif, const capture_cfg_t* cfg);
+
+// 停止抓包，写完环中剩余的包后关闭文件
+net_err_t netif_capture_stop(netif_t* netif);
+
+// 获取抓包统计信息
+net_err_t netif_capture_get_stats(netif_t* netif, capture_stats_t* stats);
+
+#endif //TINY_NET_NETIF_CAPTURE_H
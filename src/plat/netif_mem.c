@@ -0,0 +1,416 @@
+#include "netif_mem.h"
+#include "sys_plat.h"
+#include "dbug.h"
+#include "mblock.h"
+#include "timer.h"
+#include "tool.h"
+#include "protocol.h"
+#include "ether.h"
+#include "arp.h"
+#include "ipv4.h"
+#include "icmp_v4.h"
+#include "udp.h"
+
+typedef struct mem_delay_t
+{
+    pktbuf_t* buf;
+    // 交付时间，相对网卡打开时刻，单位：毫秒
+    int due;
+} mem_delay_t;
+
+typedef struct mem_dev_t
+{
+    netif_t* netif;
+    netif_t* peer;
+    bool zero_copy;
+    int queue_depth;
+    int latency_ms;
+
+    bool echo;
+    ipaddr_t echo_ip;
+    uint8_t echo_hwaddr[ETHER_HWADDR_LEN];
+
+    // 延迟队列，所有包延迟相同，按交付时间先后排列
+    mem_delay_t delay_q[MEM_DELAY_QUEUE_SIZE];
+    int delay_out;
+    int delay_cnt;
+    net_timer_t delay_timer;
+    bool timer_active;
+    net_time_t start;
+
+    mem_stats_t stats;
+} mem_dev_t;
+
+static mem_dev_t mem_dev_tbl[MEM_DEV_NR];
+
+static mblock_t mem_dev_mblock;
+
+static bool mem_dev_inited = false;
+
+static int mem_now(const mem_dev_t* dev)
+{
+    net_time_t time = dev->start;
+    return sys_time_goes(&time);
+}
+
+// 增量更新校验和，RFC 1624
+static uint16_t mem_csum_adjust(const uint16_t csum, const uint16_t old_word, const uint16_t new_word)
+{
+    uint32_t sum = (uint16_t)~csum + (uint16_t)~old_word + new_word;
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+static void mem_swap(uint8_t* a, uint8_t* b, const int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        const uint8_t t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+    }
+}
+
+static bool mem_echo_arp(mem_dev_t* dev, pktbuf_t* buf)
+{
+    if (pktbuf_set_cont(buf, sizeof(ether_header_t) + sizeof(arp_pkt_t)) != NET_ERR_OK)
+    {
+        return false;
+    }
+    arp_pkt_t* arp = (arp_pkt_t*)(pktbuf_data(buf) + sizeof(ether_header_t));
+    if (x_ntohs(arp->opcode) != ARP_REQUEST ||
+        plat_memcmp(arp->target_addr, dev->echo_ip.a_addr, IPV4_ADDR_LEN) != 0)
+    {
+        return false;
+    }
+
+    arp->opcode = x_htons(ARP_REPLY);
+    plat_memcpy(arp->target_hwaddr, arp->sender_hwaddr, ETHER_HWADDR_LEN);
+    plat_memcpy(arp->target_addr, arp->sender_addr, IPV4_ADDR_LEN);
+    plat_memcpy(arp->sender_hwaddr, dev->echo_hwaddr, ETHER_HWADDR_LEN);
+    plat_memcpy(arp->sender_addr, dev->echo_ip.a_addr, IPV4_ADDR_LEN);
+    return true;
+}
+
+// 交换地址与端口后原样发回，交换不改变IP与UDP校验和
+static bool mem_echo_ipv4(mem_dev_t* dev, pktbuf_t* buf)
+{
+    if (pktbuf_set_cont(buf, sizeof(ether_header_t) + sizeof(ipv4_header_t)) != NET_ERR_OK)
+    {
+        return false;
+    }
+    ipv4_header_t* ip = (ipv4_header_t*)(pktbuf_data(buf) + sizeof(ether_header_t));
+    if (plat_memcmp(ip->dest_addr, dev->echo_ip.a_addr, IPV4_ADDR_LEN) != 0)
+    {
+        return false;
+    }
+    if (ip->protocol != PROTOCOL_TYPE_ICMP_V4 && ip->protocol != PROTOCOL_TYPE_UDP)
+    {
+        return false;
+    }
+
+    // 只有首个分片带有上层协议头
+    const int hdr_len = sizeof(ether_header_t) + ip->shdr * 4;
+    if ((x_ntohs(ip->frag_all) & 0x1FFF) == 0)
+    {
+        const int l4_size = ip->protocol == PROTOCOL_TYPE_UDP ? sizeof(udp_header_t) : sizeof(icmp_v4_header_t);
+        if (pktbuf_set_cont(buf, hdr_len + l4_size) != NET_ERR_OK)
+        {
+            return false;
+        }
+        ip = (ipv4_header_t*)(pktbuf_data(buf) + sizeof(ether_header_t));
+
+        if (ip->protocol == PROTOCOL_TYPE_UDP)
+        {
+            udp_header_t* udp = (udp_header_t*)(pktbuf_data(buf) + hdr_len);
+            const uint16_t port = udp->src_port;
+            udp->src_port = udp->dest_port;
+            udp->dest_port = port;
+        }
+        else
+        {
+            icmp_v4_header_t* icmp = (icmp_v4_header_t*)(pktbuf_data(buf) + hdr_len);
+            if (icmp->type != ICMP_V4_TYPE_ECHO_REQUEST)
+            {
+                return false;
+            }
+            const uint16_t old_word = *(uint16_t*)&icmp->type;
+            icmp->type = ICMP_V4_TYPE_ECHO_REPLY;
+            icmp->checksum = mem_csum_adjust(icmp->checksum, old_word, *(uint16_t*)&icmp->type);
+        }
+    }
+
+    mem_swap(ip->src_addr, ip->dest_addr, IPV4_ADDR_LEN);
+    return true;
+}
+
+// 内置回显应答器，原地把请求改写为应答
+static bool mem_echo(mem_dev_t* dev, pktbuf_t* buf)
+{
+    if (pktbuf_set_cont(buf, sizeof(ether_header_t)) != NET_ERR_OK)
+    {
+        return false;
+    }
+
+    bool reply = false;
+    switch (x_ntohs(((ether_header_t*)pktbuf_data(buf))->protocol))
+    {
+    case PROTOCOL_TYPE_ARP:
+        reply = mem_echo_arp(dev, buf);
+        break;
+    case PROTOCOL_TYPE_IPv4:
+        reply = mem_echo_ipv4(dev, buf);
+        break;
+    default:
+        break;
+    }
+    if (!reply)
+    {
+        return false;
+    }
+
+    ether_header_t* eth = (ether_header_t*)pktbuf_data(buf);
+    plat_memcpy(eth->dest_mac, eth->src_mac, ETHER_HWADDR_LEN);
+    plat_memcpy(eth->src_mac, dev->echo_hwaddr, ETHER_HWADDR_LEN);
+    pktbuf_reset_access(buf);
+    return true;
+}
+
+// 发送方跳过的IP首部校验和，接收接口挂了抓包回调时补全
+static void mem_ip_csum_complete(pktbuf_t* buf)
+{
+    if (pktbuf_set_cont(buf, sizeof(ether_header_t) + sizeof(ipv4_header_t)) != NET_ERR_OK ||
+        x_ntohs(((ether_header_t*)pktbuf_data(buf))->protocol) != PROTOCOL_TYPE_IPv4)
+    {
+        return;
+    }
+    ipv4_header_t* ip = (ipv4_header_t*)(pktbuf_data(buf) + sizeof(ether_header_t));
+    if (ip->header_checksum == 0 && ip->shdr * 4 == sizeof(ipv4_header_t))
+    {
+        ip->header_checksum = checksum16(ip, sizeof(ipv4_header_t), 0, true);
+    }
+    pktbuf_reset_access(buf);
+}
+
+static void mem_deliver(mem_dev_t* dev, pktbuf_t* buf)
+{
+    netif_t* target = dev->peer;
+    if (target == NULL && dev->echo && mem_echo(dev, buf))
+    {
+        target = dev->netif;
+        dev->stats.echo_replies++;
+    }
+    if (target != NULL && target->capture != NULL)
+    {
+        mem_ip_csum_complete(buf);
+    }
+
+    if (target == NULL || netif_in_count(target) >= dev->queue_depth ||
+        netif_put_in(target, buf, -1) != NET_ERR_OK)
+    {
+        dev->stats.tx_dropped++;
+        pktbuf_free(buf);
+        return;
+    }
+    ((mem_dev_t*)target->opts_data)->stats.rx_packets++;
+}
+
+static void mem_delay_timer(net_timer_t* timer, void* arg)
+{
+    mem_dev_t* dev = arg;
+    const int now = mem_now(dev);
+
+    while (dev->delay_cnt > 0 && dev->delay_q[dev->delay_out].due <= now)
+    {
+        pktbuf_t* buf = dev->delay_q[dev->delay_out].buf;
+        dev->delay_out = (dev->delay_out + 1) % MEM_DELAY_QUEUE_SIZE;
+        dev->delay_cnt--;
+        mem_deliver(dev, buf);
+    }
+
+    // 为下一个待交付的包重新定时
+    if (dev->delay_cnt > 0)
+    {
+        net_timer_add(&dev->delay_timer, "mem delay", mem_delay_timer, dev,
+                      dev->delay_q[dev->delay_out].due - now, 0);
+    }
+    else
+    {
+        dev->timer_active = false;
+    }
+}
+
+static void mem_delay_push(mem_dev_t* dev, pktbuf_t* buf)
+{
+    if (dev->delay_cnt >= MEM_DELAY_QUEUE_SIZE)
+    {
+        dev->stats.tx_dropped++;
+        pktbuf_free(buf);
+        return;
+    }
+
+    mem_delay_t* delay = &dev->delay_q[(dev->delay_out + dev->delay_cnt) % MEM_DELAY_QUEUE_SIZE];
+    delay->buf = buf;
+    delay->due = mem_now(dev) + dev->latency_ms;
+    dev->delay_cnt++;
+
+    if (!dev->timer_active)
+    {
+        net_timer_add(&dev->delay_timer, "mem delay", mem_delay_timer, dev, dev->latency_ms, 0);
+        dev->timer_active = true;
+    }
+}
+
+static net_err_t netif_mem_open(netif_t* netif, void* data)
+{
+    const mem_data_t* mem_data = data;
+    const int mtu = mem_data->mtu > 0 ? mem_data->mtu : ETHER_PAYLOAD_MAX_LEN;
+    if (mtu < NETIF_MTU_MIN || mtu > NETIF_MTU_MAX)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_mem_open: invalid mtu %d", mtu);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    if (!mem_dev_inited)
+    {
+        mblock_init(&mem_dev_mblock, mem_dev_tbl, sizeof(mem_dev_t), MEM_DEV_NR, NLOCKER_TYPE_NONE);
+        mem_dev_inited = true;
+    }
+
+    if (mem_data->rx_queues > 1 && netif_set_queues(netif, mem_data->rx_queues, 1) != NET_ERR_OK)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    netif_t* peer = mem_data->peer;
+    if (peer && (peer->opts != &netdev_mem_ops || ((mem_dev_t*)peer->opts_data)->peer != NULL))
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_mem_open: peer %s is not a free mem netif", peer->name);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    mem_dev_t* dev = mblock_alloc(&mem_dev_mblock, -1);
+    if (dev == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_mem_open: no free mem dev");
+        return NET_ERR_MEM;
+    }
+    plat_memset(dev, 0, sizeof(mem_dev_t));
+    dev->netif = netif;
+    dev->zero_copy = mem_data->zero_copy;
+    dev->queue_depth = mem_data->queue_depth > 0 ? mem_data->queue_depth : NETIF_IN_QUEUE_SIZE;
+    dev->latency_ms = mem_data->latency_ms;
+    sys_time_curr(&dev->start);
+
+    if (mem_data->echo_ip)
+    {
+        dev->echo = true;
+        ipaddr4_form_str(&dev->echo_ip, mem_data->echo_ip);
+        plat_memcpy(dev->echo_hwaddr, mem_data->echo_hwaddr, ETHER_HWADDR_LEN);
+    }
+
+    // 两端互相关联
+    if (peer)
+    {
+        dev->peer = peer;
+        ((mem_dev_t*)peer->opts_data)->peer = netif;
+    }
+
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = mtu;
+    netif->mtu_max = NETIF_MTU_MAX;
+    netif->features |= NETIF_FEATURE_CSUM_SKIP;
+    netif->opts_data = dev;
+    netif_set_hwaddr(netif, mem_data->hwaddr, ETHER_HWADDR_LEN);
+    return NET_ERR_OK;
+}
+
+static net_err_t netif_mem_close(netif_t* netif)
+{
+    mem_dev_t* dev = netif->opts_data;
+
+    if (dev->timer_active)
+    {
+        net_timer_remove(&dev->delay_timer);
+    }
+    while (dev->delay_cnt > 0)
+    {
+        pktbuf_free(dev->delay_q[dev->delay_out].buf);
+        dev->delay_out = (dev->delay_out + 1) % MEM_DELAY_QUEUE_SIZE;
+        dev->delay_cnt--;
+    }
+
+    if (dev->peer)
+    {
+        ((mem_dev_t*)dev->peer->opts_data)->peer = NULL;
+    }
+    mblock_free(&mem_dev_mblock, dev);
+    return NET_ERR_OK;
+}
+
+// 在工作线程中调用，包直接交给对端的输入队列
+static net_err_t netif_mem_output(netif_t* netif)
+{
+    mem_dev_t* dev = netif->opts_data;
+    pktbuf_t* buf = netif_get_out(netif, -1);
+    if (buf == NULL)
+    {
+        return NET_ERR_OK;
+    }
+    dev->stats.tx_packets++;
+    dev->stats.tx_bytes += buf->total_size;
+
+    // 部分校验和不在此补全，由对端的抓包与原始套接字在需要时补全
+    if (!dev->zero_copy)
+    {
+        const int total_size = (int)buf->total_size;
+        pktbuf_t* copy = pktbuf_alloc(total_size);
+        if (copy == NULL)
+        {
+            dev->stats.tx_dropped++;
+            pktbuf_free(buf);
+            return NET_ERR_MEM;
+        }
+        pktbuf_copy(copy, buf, total_size);
+        pktbuf_reset_access(copy);
+        copy->csum_state = buf->csum_state;
+        copy->csum_start = buf->csum_start;
+        copy->csum_offset = buf->csum_offset;
+        pktbuf_free(buf);
+        buf = copy;
+    }
+
+    // 帧只在内存中传递，对端无需校验和；部分校验和保持原状，对端同样视为可信
+    if (buf->csum_state != PKTBUF_CSUM_PARTIAL)
+    {
+        buf->csum_state = PKTBUF_CSUM_UNNECESSARY;
+    }
+
+    if (dev->latency_ms > 0)
+    {
+        mem_delay_push(dev, buf);
+    }
+    else
+    {
+        mem_deliver(dev, buf);
+    }
+    return NET_ERR_OK;
+}
+
+net_err_t netif_mem_get_stats(netif_t* netif, mem_stats_t* stats)
+{
+    if (netif->opts != &netdev_mem_ops)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    const mem_dev_t* dev = netif->opts_data;
+    *stats = dev->stats;
+    return NET_ERR_OK;
+}
+
+const netif_open_options_t netdev_mem_ops = {
+    .open = netif_mem_open,
+    .close = netif_mem_close,
+    .linkoutput = netif_mem_output,
+};
@@ -0,0 +1,52 @@
+#ifndef TINY_NET_NETIF_MEM_H
+#define TINY_NET_NETIF_MEM_H
+
+#include "net_err.h"
+#include "netif.h"
+
+// 同时打开的内存网卡数量
+#define MEM_DEV_NR 4
+
+// 延迟队列大小，超出时丢包
+#define MEM_DELAY_QUEUE_SIZE 128
+
+typedef struct mem_data_t
+{
+    // 网卡硬件地址
+    const uint8_t* hwaddr;
+    // 对端网卡，须已用netdev_mem_ops打开且尚未配对；为NULL时等待另一端配对
+    netif_t* peer;
+    // 为true时把pktbuf直接交给对端，否则复制一份，模拟真实链路
+    bool zero_copy;
+    // 对端输入队列中允许积压的最大包数，0表示不限制
+    int queue_depth;
+    // 每个包的传输延迟，单位：毫秒，0表示立即交付
+    int latency_ms;
+    // 接收队列数量，按流哈希分散到各队列，0表示单队列
+    int rx_queues;
+    // 接口MTU，0表示使用1500，最大为NETIF_MTU_MAX
+    int mtu;
+    // 没有对端时启用内置回显应答器的IP与硬件地址：应答ARP请求、ICMP回显与UDP回显
+    const char* echo_ip;
+    const uint8_t* echo_hwaddr;
+} mem_data_t;
+
+typedef struct mem_stats_t
+{
+    // 发出的包数与字节数
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    // 交付给本网卡的包数
+    uint64_t rx_packets;
+    // 因无对端、队列已满或pktbuf不足而丢弃的包数
+    uint64_t tx_dropped;
+    // 回显应答器发回的包数
+    uint64_t echo_replies;
+} mem_stats_t;
+
+// 获取内存网卡的统计信息
+net_err_t netif_mem_get_stats(netif_t* netif, mem_stats_t* stats);
+
+extern const netif_open_options_t netdev_mem_ops;
+
+#endif //TINY_NET_NETIF_MEM_H
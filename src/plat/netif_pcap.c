@@ -2,98 +2,295 @@
 #include "sys_plat.h"
 #include "exmsg.h"
 #include "dbug.h"
+#include "mblock.h"
+
+#if defined(SYS_PLAT_LINUX)
+#include <poll.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+// 最多同时打开的pcap网卡数量
+#define PCAP_DEV_NR 4
 
 static bool is_running = true;
 
+// 一次pcap_dispatch使用的pktbuf：调用前批量分配好空包，回调中按帧长扩展后直接写入
+typedef struct pcap_rx_vec_t
+{
+    netif_t* netif;
+    // 已写入数据的包数
+    int cnt;
+    // 已分配的空包数，未用完的留给下一批
+    int ready;
+    pktbuf_t* bufs[PCAP_RX_BURST_MAX];
+} pcap_rx_vec_t;
+
+typedef struct pcap_dev_t
+{
+    pcap_t* pcap;
+    // 网卡设备名，用于查询载波状态
+    char name[256];
+    // 单次批量接收的包数
+    int rx_burst;
+    // 接收用的pktbuf，只由本网卡的接收线程访问
+    pcap_rx_vec_t rx_vec;
+    // 发送时复制分散数据的缓冲区，只由本网卡的发送线程访问
+    uint8_t tx_buffer[PCAP_FRAME_MAX];
+} pcap_dev_t;
+
+static pcap_dev_t pcap_dev_tbl[PCAP_DEV_NR];
+
+static mblock_t pcap_dev_mblock;
+
+static bool pcap_dev_inited = false;
+
 void stop_pcap_netif()
 {
     is_running = false;
 }
 
+// 从pcap的缓冲区直接写入预先分配的pktbuf，每个包只复制一次
+static void pcap_rx_handler(u_char* user, const struct pcap_pkthdr* header, const u_char* data)
+{
+    pcap_rx_vec_t* vec = (pcap_rx_vec_t*)user;
+    if (header->caplen > PCAP_FRAME_MAX)
+    {
+        dbug_warn(DBG_MOD_PLATFORM, "pcap recv_thread: frame too large, len=%d", header->caplen);
+        return;
+    }
+    if (vec->cnt >= vec->ready)
+    {
+        netif_stats_drop(vec->netif, NETIF_DROP_NO_BUF);
+        return;
+    }
+
+    pktbuf_t* buf = vec->bufs[vec->cnt];
+    if (pktbuf_resize(buf, (int)header->caplen) != NET_ERR_OK)
+    {
+        netif_stats_drop(vec->netif, NETIF_DROP_NO_BUF);
+        return;
+    }
+    pktbuf_reset_access(buf);
+    pktbuf_write(buf, data, (int)header->caplen);
+    pktbuf_reset_access(buf);
+    vec->cnt++;
+}
+
+// 等待网卡可读，不支持时直接返回由pcap_dispatch自身的超时阻塞
+static void pcap_rx_wait(pcap_t* pcap)
+{
+#if defined(SYS_PLAT_LINUX)
+    const int fd = pcap_get_selectable_fd(pcap);
+    if (fd >= 0)
+    {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        poll(&pfd, 1, PCAP_POLL_TMO);
+    }
+#endif
+}
+
 void recv_thread(void* arg)
 {
     plat_printf("pcap recv_thread started\n");
     netif_t* netif = (netif_t*)arg;
-    pcap_t* pcap = (pcap_t*)netif->opts_data;
+    pcap_dev_t* dev = (pcap_dev_t*)netif->opts_data;
+    pcap_t* pcap = dev->pcap;
+
+    pcap_rx_vec_t* rx_vec = &dev->rx_vec;
+    rx_vec->netif = netif;
+    rx_vec->ready = 0;
+    static const int empty_sizes[PCAP_RX_BURST_MAX] = {0};
 
     while (is_running)
     {
-        // 从pcap读取数据包
-        struct pcap_pkthdr* header;
-        const u_char* data;
-        if (pcap_next_ex(pcap, &header, &data) != 1)
+        pcap_rx_wait(pcap);
+
+        // 补足一批空包，整批只加锁一次；数据块在回调中按帧长分配
+        if (rx_vec->ready < dev->rx_burst)
         {
-            continue;
+            rx_vec->ready += pktbuf_alloc_burst(rx_vec->bufs + rx_vec->ready, empty_sizes,
+                                                dev->rx_burst - rx_vec->ready);
         }
-        // 分配pktbuf并写入数据
-        pktbuf_t* buf = pktbuf_alloc((int)header->len);
-        if (!buf)
+
+        // 没有空包时仍取一个包丢弃，避免计数为0时pcap一次取完缓冲区
+        rx_vec->cnt = 0;
+        const int burst = rx_vec->ready > 0 ? rx_vec->ready : 1;
+        if (pcap_dispatch(pcap, burst, pcap_rx_handler, (u_char*)rx_vec) <= 0 || rx_vec->cnt == 0)
         {
-            dbug_warn(DBG_MOD_PLATFORM, "pcap recv_thread: pktbuf_alloc failed");
             continue;
         }
-        pktbuf_write(buf, data, (int)header->len);
 
-        // 发送到输入队列
-        net_err_t err = netif_put_in(netif, buf, 0);
-        if (err != NET_ERR_OK)
+        // 整批放入输入队列，放不下的丢弃
+        const int nr = rx_vec->cnt;
+        const int queued = netif_put_in_burst(netif, rx_vec->bufs, nr);
+        for (int i = queued; i < nr; i++)
         {
-            dbug_warn(DBG_MOD_PLATFORM, "pcap recv_thread: netif_put_in failed");
-            pktbuf_free(buf);
-            continue;
+            pktbuf_free(rx_vec->bufs[i]);
+        }
+
+        // 未用到的空包移到前面留给下一批
+        for (int i = nr; i < rx_vec->ready; i++)
+        {
+            rx_vec->bufs[i - nr] = rx_vec->bufs[i];
+        }
+        rx_vec->ready -= nr;
+    }
+
+    for (int i = 0; i < rx_vec->ready; i++)
+    {
+        pktbuf_free(rx_vec->bufs[i]);
+    }
+}
+
+// 发送一帧：数据连续时原地发送；分散在多个块时Linux下对抓包套接字writev聚合发送，
+// 其他平台或块数过多时复制到网卡的发送缓冲区。帧长已由以太网层补齐，无需清零缓冲区
+// 失败时在这里按出错的接口记录原因
+static int pcap_send_frame(pcap_dev_t* dev, pktbuf_t* buf)
+{
+    pcap_t* pcap = dev->pcap;
+    int err;
+
+    pktbuf_iovec_t iov[PCAP_IOV_MAX];
+    const int iov_cnt = pktbuf_to_iovec(buf, iov, PCAP_IOV_MAX);
+    if (iov_cnt == 1)
+    {
+        err = pcap_inject(pcap, iov[0].base, iov[0].len);
+        if (err < 0)
+        {
+            dbug_error(DBG_MOD_PLATFORM, "pcap send_thread: inject failed, err:%s", pcap_geterr(pcap));
         }
+        return err;
     }
+
+#if defined(SYS_PLAT_LINUX)
+    const int fd = pcap_get_selectable_fd(pcap);
+    if (iov_cnt > 1 && fd >= 0)
+    {
+        struct iovec vec[PCAP_IOV_MAX];
+        for (int i = 0; i < iov_cnt; i++)
+        {
+            vec[i].iov_base = iov[i].base;
+            vec[i].iov_len = iov[i].len;
+        }
+        // writev直接操作套接字，出错原因在errno中而不在pcap里
+        err = (int)writev(fd, vec, iov_cnt);
+        if (err < 0)
+        {
+            dbug_error(DBG_MOD_PLATFORM, "pcap send_thread: writev failed, err:%s", strerror(errno));
+        }
+        return err;
+    }
+#endif
+
+    const int total_size = (int)buf->total_size;
+    pktbuf_read(buf, dev->tx_buffer, total_size);
+    err = pcap_inject(pcap, dev->tx_buffer, total_size);
+    if (err < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "pcap send_thread: inject failed, err:%s", pcap_geterr(pcap));
+    }
+    return err;
 }
 
 void send_thread(void* arg)
 {
     plat_printf("pcap send_thread started\n");
     netif_t* netif = (netif_t*)arg;
-    pcap_t* pcap = (pcap_t*)netif->opts_data;
-
+    pcap_dev_t* dev = (pcap_dev_t*)netif->opts_data;
 
-    // 以太网帧最大长度
-    // MTU(1500) + 目的MAC(6) + 源MAC(6) + 类型(2) = 1514字节 (不含FCS)
-    static uint8_t rw_buffer[1500 + 6 + 6 + 2];
+    pktbuf_t* bufs[PCAP_TX_BURST_MAX];
     while (is_running)
     {
-        pktbuf_t* buf = netif_get_out(netif, 0);
-        if (buf == NULL)
+        // 等到一个包后把已积压的包一次取出
+        bufs[0] = netif_get_out(netif, 0);
+        if (bufs[0] == NULL)
         {
             dbug_error(DBG_MOD_PLATFORM, "pcap send_thread: netif_get_out timeout");
             continue;
         }
+        const int cnt = 1 + netif_get_out_burst(netif, bufs + 1, PCAP_TX_BURST_MAX - 1);
 
-        int total_size = (int)buf->total_size;
-        plat_memset(rw_buffer, 0, sizeof(rw_buffer));
-        pktbuf_read(buf, rw_buffer, total_size);
-        if (pcap_inject(pcap, rw_buffer, total_size) == -1)
-        {
-            dbug_error(DBG_MOD_PLATFORM, "pcap send_thread: pcap_inject failed, err:%s", pcap_geterr(pcap));
-        }
-        else
+        for (int i = 0; i < cnt; i++)
         {
-            dbug_info(DBG_MOD_PLATFORM, "发送一个数据包完成 size=%d", total_size);
+            pktbuf_t* buf = bufs[i];
+            int total_size = (int)buf->total_size;
+            if (total_size > PCAP_FRAME_MAX)
+            {
+                dbug_warn(DBG_MOD_PLATFORM, "pcap send_thread: frame too large, len=%d", total_size);
+                pktbuf_free(buf);
+                continue;
+            }
+            if (pcap_send_frame(dev, buf) >= 0)
+            {
+                dbug_info(DBG_MOD_PLATFORM, "发送一个数据包完成 size=%d", total_size);
+            }
+            pktbuf_free(buf);
         }
-        pktbuf_free(buf);
     }
 }
 
 net_err_t netif_pcap_open(netif_t* netif, void* data)
 {
     pcap_data_t* pcap_data = data;
+    const int mtu = pcap_data->mtu > 0 ? pcap_data->mtu : 1500;
+    if (mtu < NETIF_MTU_MIN || mtu > NETIF_MTU_MAX)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_pcap_open: invalid mtu %d", mtu);
+        return NET_ERR_INVALID_PARAM;
+    }
+    if (pcap_data->rx_queues > 1 && netif_set_queues(netif, pcap_data->rx_queues, 1) != NET_ERR_OK)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    if (!pcap_dev_inited)
+    {
+        mblock_init(&pcap_dev_mblock, pcap_dev_tbl, sizeof(pcap_dev_t), PCAP_DEV_NR, NLOCKER_TYPE_THREAD);
+        pcap_dev_inited = true;
+    }
+
+    pcap_dev_t* dev = mblock_alloc(&pcap_dev_mblock, -1);
+    if (dev == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_pcap_open: no free pcap dev");
+        return NET_ERR_MEM;
+    }
+
     pcap_t* pcap = pcap_device_open(pcap_data->ipaddr, pcap_data->hwaddr);
     if (!pcap)
     {
         dbug_error(DBG_MOD_PLATFORM, "netif_pcap_open: failed to open pcap device");
+        mblock_free(&pcap_dev_mblock, dev);
         return NET_ERR_IO;
     }
     netif->type = NETIF_TYPE_ETHERNET;
-    netif->mtu = 1500;
+    netif->mtu = mtu;
+    netif->mtu_max = NETIF_MTU_MAX;
 
-    netif->opts_data = pcap;
+    dev->pcap = pcap;
+    dev->rx_burst = PCAP_RX_BURST_DEFAULT;
+    if (pcap_data->rx_burst > 0)
+    {
+        dev->rx_burst = pcap_data->rx_burst > PCAP_RX_BURST_MAX ? PCAP_RX_BURST_MAX : pcap_data->rx_burst;
+    }
+    if (pcap_find_device(pcap_data->ipaddr, dev->name) < 0)
+    {
+        dev->name[0] = '\0';
+    }
+    netif->opts_data = dev;
     netif_set_hwaddr(netif, pcap_data->hwaddr, 6);
 
+#if defined(SYS_PLAT_LINUX)
+    // 由poll等待数据，读取时不阻塞
+    char err_buf[PCAP_ERRBUF_SIZE];
+    if (pcap_get_selectable_fd(pcap) >= 0 && pcap_setnonblock(pcap, 1, err_buf) != 0)
+    {
+        dbug_warn(DBG_MOD_PLATFORM, "netif_pcap_open: set nonblock failed: %s", err_buf);
+    }
+#endif
+
     const sys_thread_t recv_th = sys_thread_create(recv_thread, netif);
     if (recv_th == SYS_THREAD_INVALID)
     {
@@ -109,7 +306,9 @@ net_err_t netif_pcap_open(netif_t* netif, void* data)
 
 net_err_t netif_pcap_close(netif_t* netif)
 {
-    pcap_close(netif->opts_data);
+    pcap_dev_t* dev = netif->opts_data;
+    pcap_close(dev->pcap);
+    mblock_free(&pcap_dev_mblock, dev);
     return NET_ERR_OK;
 }
 
@@ -118,8 +317,22 @@ net_err_t netif_pcap_output(netif_t* netif)
     return NET_ERR_OK;
 }
 
+static net_err_t netif_pcap_set_rx_addr(netif_t* netif, const uint8_t* addr)
+{
+    pcap_dev_t* dev = netif->opts_data;
+    return pcap_set_rx_filter(dev->pcap, addr) < 0 ? NET_ERR_IO : NET_ERR_OK;
+}
+
+static int netif_pcap_carrier(netif_t* netif)
+{
+    pcap_dev_t* dev = netif->opts_data;
+    return dev->name[0] != '\0' ? pcap_device_carrier(dev->name) : -1;
+}
+
 const netif_open_options_t netdev_ops = {
     .open = netif_pcap_open,
     .close = netif_pcap_close,
     .linkoutput = netif_pcap_output,
+    .set_rx_addr = netif_pcap_set_rx_addr,
+    .carrier = netif_pcap_carrier,
 };
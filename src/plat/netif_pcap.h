@@ -4,12 +4,36 @@
 #include "net_err.h"
 #include "netif.h"
 
+// 以太网帧最大长度（不含FCS），按最大MTU预留以支持巨帧，另留一个802.1Q标签
+#define PCAP_FRAME_MAX (NETIF_MTU_MAX + 6 + 6 + 4 + 2)
+
+// 单次批量接收的最大包数
+#define PCAP_RX_BURST_MAX 64
+
+// 默认批量接收包数
+#define PCAP_RX_BURST_DEFAULT 16
+
+// 发送线程单次最多取出的包数
+#define PCAP_TX_BURST_MAX 32
+
+// 聚合发送时单帧最多的数据段数，超过时复制到发送缓冲区
+#define PCAP_IOV_MAX 16
+
+// 接收线程等待数据的超时时间，单位：毫秒
+#define PCAP_POLL_TMO 100
+
 typedef struct pcap_data_t
 {
     // 设备ip地址
     const char* ipaddr;
     // 设备硬件地址
     const uint8_t* hwaddr;
+    // 单次批量接收的包数，0表示使用默认值
+    int rx_burst;
+    // 接收队列数量，按流哈希分散到各队列，0表示单队列
+    int rx_queues;
+    // 接口MTU，0表示使用1500，最大为NETIF_MTU_MAX
+    int mtu;
 } pcap_data_t;
 
 net_err_t netif_pcap_open(netif_t* netif, void* data);
@@ -0,0 +1,384 @@
+#include "netif_replay.h"
+#include "sys_plat.h"
+#include "dbug.h"
+#include "mblock.h"
+#include <stdlib.h>
+
+// 抓包文件中的一帧，data紧随其后
+typedef struct replay_frame_t
+{
+    // 相对第一帧的时间偏移，单位：毫秒
+    uint32_t offset_ms;
+    int len;
+    uint8_t data[];
+} replay_frame_t;
+
+typedef struct replay_dev_t
+{
+    netif_t* netif;
+    // 预先读入内存的全部帧
+    replay_frame_t** frames;
+    bool pace;
+    int loop;
+    int burst;
+    volatile bool running;
+    // 驱动线程退出通知
+    sys_sem_t exit_sem;
+    int thread_cnt;
+    // 回放结束通知
+    sys_sem_t done_sem;
+    replay_stats_t stats;
+} replay_dev_t;
+
+static replay_dev_t replay_dev_tbl[REPLAY_DEV_NR];
+
+static mblock_t replay_dev_mblock;
+
+static bool replay_dev_inited = false;
+
+static void replay_frames_free(replay_dev_t* dev)
+{
+    if (dev->frames == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < dev->stats.frame_cnt; i++)
+    {
+        free(dev->frames[i]);
+    }
+    free(dev->frames);
+    dev->frames = NULL;
+    dev->stats.frame_cnt = 0;
+}
+
+// 一次性读入抓包文件，回放过程中不再访问文件
+static net_err_t replay_frames_load(replay_dev_t* dev, const char* file)
+{
+    char err_buf[PCAP_ERRBUF_SIZE];
+    pcap_t* pcap = pcap_open_offline(file, err_buf);
+    if (pcap == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "replay: open %s failed: %s", file, err_buf);
+        return NET_ERR_IO;
+    }
+
+    int capacity = 0;
+    struct timeval first_ts;
+    struct pcap_pkthdr* header;
+    const u_char* data;
+    int ret;
+    while ((ret = pcap_next_ex(pcap, &header, &data)) == 1)
+    {
+        // 永远无法注入的帧在读入时跳过，避免回放时反复重试
+        if (header->caplen == 0 || header->caplen > REPLAY_FRAME_MAX)
+        {
+            dbug_warn(DBG_MOD_PLATFORM, "replay: skip frame of %d bytes", (int)header->caplen);
+            dev->stats.frame_rejected++;
+            continue;
+        }
+
+        if (dev->stats.frame_cnt == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 256;
+            replay_frame_t** frames = realloc(dev->frames, capacity * sizeof(replay_frame_t*));
+            if (frames == NULL)
+            {
+                goto load_failed;
+            }
+            dev->frames = frames;
+        }
+
+        replay_frame_t* frame = malloc(sizeof(replay_frame_t) + header->caplen);
+        if (frame == NULL)
+        {
+            goto load_failed;
+        }
+        if (dev->stats.frame_cnt == 0)
+        {
+            first_ts = header->ts;
+        }
+        frame->offset_ms = (uint32_t)((header->ts.tv_sec - first_ts.tv_sec) * 1000 +
+                                      (header->ts.tv_usec - first_ts.tv_usec) / 1000);
+        frame->len = (int)header->caplen;
+        plat_memcpy(frame->data, data, header->caplen);
+        dev->frames[dev->stats.frame_cnt++] = frame;
+    }
+
+    if (ret == -1)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "replay: read %s failed: %s", file, pcap_geterr(pcap));
+        goto load_failed;
+    }
+    pcap_close(pcap);
+
+    if (dev->stats.frame_cnt == 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "replay: %s has no packets", file);
+        return NET_ERR_IO;
+    }
+    return NET_ERR_OK;
+
+load_failed:
+    pcap_close(pcap);
+    replay_frames_free(dev);
+    return NET_ERR_IO;
+}
+
+// 从start开始经过的毫秒数
+static int replay_elapsed(const net_time_t* start)
+{
+    net_time_t time = *start;
+    return sys_time_goes(&time);
+}
+
+static void replay_thread(void* arg)
+{
+    replay_dev_t* dev = arg;
+    netif_t* netif = dev->netif;
+    plat_printf("replay thread started\n");
+
+    // 等待网卡激活后再注入
+    while (dev->running && netif->state != NETIF_STATE_ACTIVE)
+    {
+        sys_sleep(10);
+    }
+
+    pktbuf_t* bufs[REPLAY_BURST_MAX];
+    int sizes[REPLAY_BURST_MAX];
+    net_time_t start;
+    sys_time_curr(&start);
+    int retry = 0;
+
+    for (int loop = 0; dev->running && loop < dev->loop; loop++)
+    {
+        const int loop_start = replay_elapsed(&start);
+        int i = 0;
+        while (dev->running && i < dev->stats.frame_cnt)
+        {
+            // 按原始间隔注入时，等到下一帧的时间点
+            const int now = replay_elapsed(&start) - loop_start;
+            if (dev->pace && (int)dev->frames[i]->offset_ms > now)
+            {
+                const int wait = (int)dev->frames[i]->offset_ms - now;
+                sys_sleep(wait < REPLAY_POLL_TMO ? wait : REPLAY_POLL_TMO);
+                continue;
+            }
+
+            // 收集一批已到时间的帧
+            int cnt = 0;
+            while (cnt < dev->burst && i + cnt < dev->stats.frame_cnt &&
+                (!dev->pace || (int)dev->frames[i + cnt]->offset_ms <= now))
+            {
+                sizes[cnt] = dev->frames[i + cnt]->len;
+                cnt++;
+            }
+
+            const int nr = pktbuf_alloc_burst(bufs, sizes, cnt);
+            if (nr == 0)
+            {
+                // pktbuf长时间不足时丢弃该帧，避免回放卡在同一帧上
+                if (++retry >= REPLAY_ALLOC_RETRY)
+                {
+                    dbug_warn(DBG_MOD_PLATFORM, "replay: drop frame %d, no pktbuf", i);
+                    dev->stats.rx_dropped++;
+                    netif_stats_drop(netif, NETIF_DROP_NO_BUF);
+                    retry = 0;
+                    i++;
+                    continue;
+                }
+                // pktbuf不足，等待协议栈释放
+                sys_sleep(1);
+                continue;
+            }
+            retry = 0;
+            for (int k = 0; k < nr; k++)
+            {
+                pktbuf_write(bufs[k], dev->frames[i + k]->data, sizes[k]);
+                pktbuf_reset_access(bufs[k]);
+                dev->stats.rx_bytes += sizes[k];
+            }
+
+            // 输入队列放不下时阻塞等待，保证回放不丢包
+            const int queued = netif_put_in_burst(netif, bufs, nr);
+            for (int k = queued; k < nr; k++)
+            {
+                if (netif_put_in(netif, bufs[k], 0) != NET_ERR_OK)
+                {
+                    pktbuf_free(bufs[k]);
+                }
+            }
+            dev->stats.rx_packets += nr;
+            i += nr;
+        }
+
+        if (i == dev->stats.frame_cnt)
+        {
+            dev->stats.loop_done++;
+        }
+    }
+
+    dev->stats.elapsed_ms = replay_elapsed(&start);
+    dev->stats.done = true;
+    sys_sem_notify(dev->done_sem);
+    sys_sem_notify(dev->exit_sem);
+}
+
+static void replay_send_thread(void* arg)
+{
+    replay_dev_t* dev = arg;
+    netif_t* netif = dev->netif;
+    plat_printf("replay send_thread started\n");
+
+    // 只统计协议栈的输出，不真正发送
+    while (dev->running)
+    {
+        pktbuf_t* buf = netif_get_out(netif, REPLAY_POLL_TMO);
+        if (buf == NULL)
+        {
+            continue;
+        }
+        dev->stats.tx_packets++;
+        dev->stats.tx_bytes += buf->total_size;
+        pktbuf_free(buf);
+    }
+
+    sys_sem_notify(dev->exit_sem);
+}
+
+static void replay_dev_free(replay_dev_t* dev)
+{
+    replay_frames_free(dev);
+    if (dev->exit_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(dev->exit_sem);
+    }
+    if (dev->done_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(dev->done_sem);
+    }
+    mblock_free(&replay_dev_mblock, dev);
+}
+
+net_err_t netif_replay_open(netif_t* netif, void* data)
+{
+    const replay_data_t* replay_data = data;
+
+    if (!replay_dev_inited)
+    {
+        mblock_init(&replay_dev_mblock, replay_dev_tbl, sizeof(replay_dev_t), REPLAY_DEV_NR, NLOCKER_TYPE_NONE);
+        replay_dev_inited = true;
+    }
+
+    replay_dev_t* dev = mblock_alloc(&replay_dev_mblock, -1);
+    if (dev == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_replay_open: no free replay dev");
+        return NET_ERR_MEM;
+    }
+    plat_memset(dev, 0, sizeof(replay_dev_t));
+    dev->netif = netif;
+    dev->pace = replay_data->pace;
+    dev->loop = replay_data->loop > 0 ? replay_data->loop : 1;
+    dev->burst = replay_data->burst > 0 ? replay_data->burst : REPLAY_BURST_DEFAULT;
+    if (dev->burst > REPLAY_BURST_MAX)
+    {
+        dev->burst = REPLAY_BURST_MAX;
+    }
+    dev->exit_sem = SYS_SEM_INVALID;
+    dev->done_sem = SYS_SEM_INVALID;
+
+    if (replay_frames_load(dev, replay_data->file) != NET_ERR_OK)
+    {
+        goto open_failed;
+    }
+    dbug_info(DBG_MOD_PLATFORM, "replay: %d packets loaded from %s", dev->stats.frame_cnt, replay_data->file);
+
+    dev->exit_sem = sys_sem_create(0);
+    dev->done_sem = sys_sem_create(0);
+    if (dev->exit_sem == SYS_SEM_INVALID || dev->done_sem == SYS_SEM_INVALID)
+    {
+        goto open_failed;
+    }
+
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = 1500;
+    netif->mtu_max = 1500;
+    netif->opts_data = dev;
+    netif_set_hwaddr(netif, replay_data->hwaddr, 6);
+
+    dev->running = true;
+    if (sys_thread_create(replay_send_thread, dev) == SYS_THREAD_INVALID)
+    {
+        goto thread_failed;
+    }
+    dev->thread_cnt++;
+    if (sys_thread_create(replay_thread, dev) == SYS_THREAD_INVALID)
+    {
+        goto thread_failed;
+    }
+    dev->thread_cnt++;
+    return NET_ERR_OK;
+
+thread_failed:
+    dev->running = false;
+    while (dev->thread_cnt-- > 0)
+    {
+        sys_sem_wait(dev->exit_sem, 0);
+    }
+open_failed:
+    replay_dev_free(dev);
+    return NET_ERR_IO;
+}
+
+net_err_t netif_replay_close(netif_t* netif)
+{
+    replay_dev_t* dev = netif->opts_data;
+
+    dev->running = false;
+    while (dev->thread_cnt-- > 0)
+    {
+        sys_sem_wait(dev->exit_sem, 0);
+    }
+    replay_dev_free(dev);
+    return NET_ERR_OK;
+}
+
+net_err_t netif_replay_output(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_replay_get_stats(netif_t* netif, replay_stats_t* stats)
+{
+    if (netif->opts != &netdev_replay_ops)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    const replay_dev_t* dev = netif->opts_data;
+    *stats = dev->stats;
+    return NET_ERR_OK;
+}
+
+net_err_t netif_replay_wait(netif_t* netif, const int tmo)
+{
+    if (netif->opts != &netdev_replay_ops)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    replay_dev_t* dev = netif->opts_data;
+    if (dev->stats.done)
+    {
+        return NET_ERR_OK;
+    }
+    if (sys_sem_wait(dev->done_sem, tmo) < 0)
+    {
+        return NET_ERR_TIMEOUT;
+    }
+    return NET_ERR_OK;
+}
+
+const netif_open_options_t netdev_replay_ops = {
+    .open = netif_replay_open,
+    .close = netif_replay_close,
+    .linkoutput = netif_replay_output,
+};
@@ -0,0 +1,69 @@
+#ifndef TINY_NET_NETIF_REPLAY_H
+#define TINY_NET_NETIF_REPLAY_H
+
+#include "net_err.h"
+#include "netif.h"
+
+// 同时打开的回放网卡数量
+#define REPLAY_DEV_NR 2
+
+// 单次批量注入的最大包数
+#define REPLAY_BURST_MAX 64
+
+// 默认批量注入包数
+#define REPLAY_BURST_DEFAULT 16
+
+// 等待资源或发送队列的超时时间，单位：毫秒
+#define REPLAY_POLL_TMO 100
+
+// 单帧最大长度，超过的帧在读入文件时跳过：最大MTU加以太网头与一个802.1Q标签
+#define REPLAY_FRAME_MAX (NETIF_MTU_MAX + 18)
+
+// 为同一帧分配pktbuf连续失败的次数上限，超过后丢弃该帧，每次失败等待1毫秒
+#define REPLAY_ALLOC_RETRY 100
+
+typedef struct replay_data_t
+{
+    // 回放的抓包文件，支持 .pcap 与 .pcapng
+    const char* file;
+    // 协议栈使用的硬件地址
+    const uint8_t* hwaddr;
+    // 为true时按抓包中的原始时间间隔注入，否则尽快注入
+    bool pace;
+    // 回放次数，0表示回放一次
+    int loop;
+    // 单次批量注入的包数，0表示使用默认值
+    int burst;
+} replay_data_t;
+
+typedef struct replay_stats_t
+{
+    // 文件中的包数
+    int frame_cnt;
+    // 文件中超长或为空而跳过的包数
+    int frame_rejected;
+    // 已完成的回放次数
+    int loop_done;
+    // 注入协议栈的包数与字节数
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    // 多次分配pktbuf失败而丢弃的包数
+    uint64_t rx_dropped;
+    // 协议栈发出的包数与字节数，只计数不发送
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    // 从开始注入到全部注入完成的耗时，单位：毫秒
+    int elapsed_ms;
+    // 是否已全部注入
+    bool done;
+} replay_stats_t;
+
+// 获取回放网卡的统计信息
+net_err_t netif_replay_get_stats(netif_t* netif, replay_stats_t* stats);
+
+// 等待回放结束，tmo为0时一直等待
+net_err_t netif_replay_wait(netif_t* netif, int tmo);
+
+extern const netif_open_options_t netdev_replay_ops;
+
+#endif //TINY_NET_NETIF_REPLAY_H
@@ -0,0 +1,530 @@
+#include "netif_tap.h"
+#include "sys_plat.h"
+#include "dbug.h"
+#include "mblock.h"
+
+#if defined(SYS_PLAT_LINUX) && defined(__linux__)
+
+#include <fcntl.h>
+#include <poll.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/if_tun.h>
+#include <linux/virtio_net.h>
+#include "ether.h"
+#include "ipv4.h"
+#include "udp.h"
+#include "gso.h"
+#include "protocol.h"
+#include "tool.h"
+
+// 旧内核头文件中没有UDP GSO类型
+#ifndef VIRTIO_NET_HDR_GSO_UDP_L4
+#define VIRTIO_NET_HDR_GSO_UDP_L4 5
+#endif
+
+// 最多同时打开的TAP网卡数量
+#define TAP_DEV_NR 4
+
+// UDP头中校验和字段偏移
+#define TAP_UDP_CSUM_OFFSET 6
+
+typedef struct tap_dev_t
+{
+    netif_t* netif;
+    int fd;
+    volatile bool running;
+    // 驱动线程退出通知
+    sys_sem_t exit_sem;
+    int thread_cnt;
+    // 超出预分配pktbuf部分的接收缓冲区
+    uint8_t rx_overflow[TAP_FRAME_MAX];
+    // 块数过多无法聚合时的发送缓冲区
+    uint8_t tx_linear[TAP_FRAME_MAX];
+    tap_stats_t stats;
+} tap_dev_t;
+
+static tap_dev_t tap_dev_tbl[TAP_DEV_NR];
+
+static mblock_t tap_dev_mblock;
+
+static bool tap_dev_inited = false;
+
+static void tap_recv_thread(void* arg)
+{
+    tap_dev_t* dev = arg;
+    netif_t* netif = dev->netif;
+    plat_printf("tap recv_thread started\n");
+
+    // 预分配的接收包大小：一个带802.1Q标签的以太网MTU帧
+    const int prealloc_size = netif->mtu + 18;
+    struct pollfd pfd = {.fd = dev->fd, .events = POLLIN};
+    pktbuf_t* buf = NULL;
+
+    while (dev->running)
+    {
+        if (buf == NULL && (buf = pktbuf_alloc(prealloc_size)) == NULL)
+        {
+            sys_sleep(1);
+            continue;
+        }
+
+        if (poll(&pfd, 1, TAP_POLL_TMO) <= 0)
+        {
+            continue;
+        }
+
+        // vnet头 + pktbuf各块 + 溢出缓冲区，直接读入pktbuf链
+        // 块数超过TAP_IOV_MAX时只映射前面的块，其余部分与超长部分一起落入溢出缓冲区
+        struct virtio_net_hdr vnet_hdr;
+        struct iovec iov[TAP_IOV_MAX + 2];
+        int iov_cnt = 0;
+        int mapped_size = 0;
+        iov[iov_cnt].iov_base = &vnet_hdr;
+        iov[iov_cnt++].iov_len = sizeof(vnet_hdr);
+        for (pktblk_t* blk = pktbuf_first_blk(buf); blk && iov_cnt <= TAP_IOV_MAX; blk = pktblock_get_next(blk))
+        {
+            iov[iov_cnt].iov_base = blk->data;
+            iov[iov_cnt++].iov_len = blk->size;
+            mapped_size += (int)blk->size;
+        }
+        iov[iov_cnt].iov_base = dev->rx_overflow;
+        iov[iov_cnt++].iov_len = sizeof(dev->rx_overflow);
+
+        const ssize_t n = readv(dev->fd, iov, iov_cnt);
+        if (n < (ssize_t)sizeof(vnet_hdr))
+        {
+            continue;
+        }
+        const int frame_len = (int)n - (int)sizeof(vnet_hdr);
+
+        // 按实际长度调整，未直接读入块链的部分从溢出缓冲区补写
+        if (pktbuf_resize(buf, frame_len) != NET_ERR_OK)
+        {
+            dbug_warn(DBG_MOD_PLATFORM, "tap recv_thread: pktbuf_resize(%d) failed", frame_len);
+            dev->stats.rx_dropped++;
+            netif_stats_drop(netif, NETIF_DROP_NO_BUF);
+            pktbuf_free(buf);
+            buf = NULL;
+            continue;
+        }
+        if (frame_len > mapped_size)
+        {
+            pktbuf_seek(buf, mapped_size);
+            pktbuf_write(buf, dev->rx_overflow, frame_len - mapped_size);
+        }
+        pktbuf_reset_access(buf);
+
+        // 内核的校验和状态随包传递，协议栈据此跳过验证
+        if (vnet_hdr.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)
+        {
+            // 主机本地发出的包校验和未填写，在驱动线程中补全后视为无需校验
+            pktbuf_set_csum_partial(buf, vnet_hdr.csum_start, vnet_hdr.csum_offset);
+            pktbuf_csum_complete(buf);
+            buf->csum_state = PKTBUF_CSUM_UNNECESSARY;
+            dev->stats.rx_csum_partial++;
+        }
+        else if (vnet_hdr.flags & VIRTIO_NET_HDR_F_DATA_VALID)
+        {
+            buf->csum_state = PKTBUF_CSUM_VERIFIED;
+            dev->stats.rx_csum_valid++;
+        }
+
+        if (netif_put_in(netif, buf, -1) != NET_ERR_OK)
+        {
+            dbug_warn(DBG_MOD_PLATFORM, "tap recv_thread: netif_put_in failed");
+            dev->stats.rx_dropped++;
+            pktbuf_free(buf);
+        }
+        else
+        {
+            dev->stats.rx_packets++;
+            dev->stats.rx_bytes += frame_len;
+        }
+        buf = NULL;
+    }
+
+    pktbuf_free(buf);
+    sys_sem_notify(dev->exit_sem);
+}
+
+// 填写UDP GSO大包的vnet头：内核按gso_size分段并补全各段校验和
+// UDP校验和字段需预先填入伪首部和（不取反），长度取大包的UDP长度
+static void tap_gso_prepare(pktbuf_t* buf, struct virtio_net_hdr* vnet_hdr)
+{
+    uint8_t hdr[sizeof(ether_header_t) + sizeof(ipv4_header_t)];
+    pktbuf_peek(buf, hdr, sizeof(hdr), 0);
+    const ipv4_header_t* ip_hdr = (const ipv4_header_t*)(hdr + sizeof(ether_header_t));
+    const int l4_start = (int)sizeof(ether_header_t) + ip_hdr->shdr * 4;
+    const uint16_t udp_len = (uint16_t)((int)buf->total_size - l4_start);
+
+    uint16_t csum = checksum16_pseudo_hdr(ip_hdr->src_addr, ip_hdr->dest_addr, PROTOCOL_TYPE_UDP, udp_len);
+    pktbuf_seek(buf, l4_start + TAP_UDP_CSUM_OFFSET);
+    pktbuf_write(buf, (uint8_t*)&csum, sizeof(uint16_t));
+    pktbuf_reset_access(buf);
+
+    vnet_hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+    vnet_hdr->gso_type = VIRTIO_NET_HDR_GSO_UDP_L4;
+    vnet_hdr->gso_size = buf->gso_size;
+    vnet_hdr->hdr_len = (uint16_t)(l4_start + sizeof(udp_header_t));
+    vnet_hdr->csum_start = (uint16_t)l4_start;
+    vnet_hdr->csum_offset = TAP_UDP_CSUM_OFFSET;
+}
+
+// 发送单个包，vnet头之后直接从pktbuf块链聚合发送，块过多时退化为复制
+static ssize_t tap_write(tap_dev_t* dev, pktbuf_t* buf, struct virtio_net_hdr* vnet_hdr)
+{
+    struct iovec iov[TAP_IOV_MAX + 1];
+    iov[0].iov_base = vnet_hdr;
+    iov[0].iov_len = sizeof(*vnet_hdr);
+
+    pktbuf_iovec_t seg[TAP_IOV_MAX];
+    int seg_cnt = pktbuf_to_iovec(buf, seg, TAP_IOV_MAX);
+    if (seg_cnt < 0)
+    {
+        pktbuf_read(buf, dev->tx_linear, (int)buf->total_size);
+        seg[0].base = dev->tx_linear;
+        seg[0].len = (int)buf->total_size;
+        seg_cnt = 1;
+    }
+    for (int i = 0; i < seg_cnt; i++)
+    {
+        iov[i + 1].iov_base = seg[i].base;
+        iov[i + 1].iov_len = seg[i].len;
+    }
+    return writev(dev->fd, iov, seg_cnt + 1);
+}
+
+// 内核不接受GSO大包时关闭该能力，在驱动内分段发送
+static ssize_t tap_write_segments(tap_dev_t* dev, pktbuf_t* buf, struct virtio_net_hdr* vnet_hdr)
+{
+    dev->netif->features &= ~NETIF_FEATURE_GSO_UDP;
+
+    pktbuf_t* segs[GSO_MAX_SEGS];
+    int cnt = 0;
+    if (gso_segment(dev->netif, buf, segs, &cnt) != NET_ERR_OK)
+    {
+        return -1;
+    }
+
+    ssize_t n = 0;
+    plat_memset(vnet_hdr, 0, sizeof(*vnet_hdr));
+    vnet_hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
+    for (int i = 0; i < cnt; i++)
+    {
+        if (n >= 0 && tap_write(dev, segs[i], vnet_hdr) < 0)
+        {
+            n = -1;
+        }
+        pktbuf_free(segs[i]);
+    }
+    return n;
+}
+
+// 发送一个包，完成后释放
+static void tap_send_one(tap_dev_t* dev, pktbuf_t* buf)
+{
+    struct virtio_net_hdr vnet_hdr;
+
+    // 部分校验和交给内核补全，其余包的校验和已由协议栈算好
+    plat_memset(&vnet_hdr, 0, sizeof(vnet_hdr));
+    vnet_hdr.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+    if (buf->gso_type == PKTBUF_GSO_UDP)
+    {
+        tap_gso_prepare(buf, &vnet_hdr);
+        dev->stats.tx_gso++;
+    }
+    else if (buf->csum_state == PKTBUF_CSUM_PARTIAL)
+    {
+        vnet_hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        vnet_hdr.csum_start = buf->csum_start;
+        vnet_hdr.csum_offset = buf->csum_offset;
+        dev->stats.tx_csum_partial++;
+    }
+
+    const int total_size = (int)buf->total_size;
+    ssize_t n = tap_write(dev, buf, &vnet_hdr);
+    if (n < 0 && errno == EINVAL && buf->gso_type == PKTBUF_GSO_UDP)
+    {
+        dbug_warn(DBG_MOD_PLATFORM, "tap send_thread: kernel rejected udp gso, segmenting in driver");
+        n = tap_write_segments(dev, buf, &vnet_hdr);
+    }
+
+    if (n < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "tap send_thread: writev failed, errno=%d", errno);
+        dev->stats.tx_dropped++;
+    }
+    else
+    {
+        dev->stats.tx_packets++;
+        dev->stats.tx_bytes += total_size;
+    }
+    pktbuf_free(buf);
+}
+
+static void tap_send_thread(void* arg)
+{
+    tap_dev_t* dev = arg;
+    netif_t* netif = dev->netif;
+    plat_printf("tap send_thread started\n");
+
+    pktbuf_t* bufs[TAP_TX_BURST_MAX];
+    while (dev->running)
+    {
+        // 等到一个包后把已积压的包一次取出
+        bufs[0] = netif_get_out(netif, TAP_POLL_TMO);
+        if (bufs[0] == NULL)
+        {
+            continue;
+        }
+        const int cnt = 1 + netif_get_out_burst(netif, bufs + 1, TAP_TX_BURST_MAX - 1);
+        for (int i = 0; i < cnt; i++)
+        {
+            tap_send_one(dev, bufs[i]);
+        }
+    }
+
+    sys_sem_notify(dev->exit_sem);
+}
+
+// 配置内核侧接口：MTU、地址并启用
+static net_err_t tap_host_config(const char* ifname, const tap_data_t* tap_data, const int mtu)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        return NET_ERR_SYS;
+    }
+
+    struct ifreq ifr;
+    plat_memset(&ifr, 0, sizeof(ifr));
+    plat_strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+
+    net_err_t err = NET_ERR_OK;
+    ifr.ifr_mtu = mtu;
+    if (ioctl(sock, SIOCSIFMTU, &ifr) < 0)
+    {
+        dbug_warn(DBG_MOD_PLATFORM, "tap_host_config: set mtu %d failed, errno=%d", mtu, errno);
+    }
+
+    if (tap_data->host_ip)
+    {
+        struct sockaddr_in* addr = (struct sockaddr_in*)&ifr.ifr_addr;
+        plat_memset(addr, 0, sizeof(*addr));
+        addr->sin_family = AF_INET;
+        inet_pton(AF_INET, tap_data->host_ip, &addr->sin_addr);
+        if (ioctl(sock, SIOCSIFADDR, &ifr) < 0)
+        {
+            dbug_error(DBG_MOD_PLATFORM, "tap_host_config: set addr %s failed, errno=%d", tap_data->host_ip, errno);
+            err = NET_ERR_SYS;
+        }
+
+        inet_pton(AF_INET, tap_data->host_mask ? tap_data->host_mask : "255.255.255.0", &addr->sin_addr);
+        if (ioctl(sock, SIOCSIFNETMASK, &ifr) < 0)
+        {
+            dbug_error(DBG_MOD_PLATFORM, "tap_host_config: set netmask failed, errno=%d", errno);
+            err = NET_ERR_SYS;
+        }
+    }
+
+    if (ioctl(sock, SIOCGIFFLAGS, &ifr) == 0)
+    {
+        ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
+        if (ioctl(sock, SIOCSIFFLAGS, &ifr) < 0)
+        {
+            err = NET_ERR_SYS;
+        }
+    }
+    close(sock);
+    return err;
+}
+
+static void tap_dev_free(tap_dev_t* dev)
+{
+    if (dev->fd >= 0)
+    {
+        close(dev->fd);
+    }
+    if (dev->exit_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(dev->exit_sem);
+    }
+    mblock_free(&tap_dev_mblock, dev);
+}
+
+net_err_t netif_tap_open(netif_t* netif, void* data)
+{
+    const tap_data_t* tap_data = data;
+
+    if (tap_data->rx_queues > 1 && netif_set_queues(netif, tap_data->rx_queues, 1) != NET_ERR_OK)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    if (!tap_dev_inited)
+    {
+        mblock_init(&tap_dev_mblock, tap_dev_tbl, sizeof(tap_dev_t), TAP_DEV_NR, NLOCKER_TYPE_NONE);
+        tap_dev_inited = true;
+    }
+
+    tap_dev_t* dev = mblock_alloc(&tap_dev_mblock, -1);
+    if (dev == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_tap_open: no free tap dev");
+        return NET_ERR_MEM;
+    }
+    dev->netif = netif;
+    dev->running = false;
+    dev->thread_cnt = 0;
+    dev->exit_sem = SYS_SEM_INVALID;
+    plat_memset(&dev->stats, 0, sizeof(tap_stats_t));
+
+    dev->fd = open("/dev/net/tun", O_RDWR);
+    if (dev->fd < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_tap_open: open /dev/net/tun failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    // TAP模式，带virtio-net头
+    struct ifreq ifr;
+    plat_memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI | IFF_VNET_HDR;
+    plat_strncpy(ifr.ifr_name, tap_data->ifname, IFNAMSIZ - 1);
+    if (ioctl(dev->fd, TUNSETIFF, &ifr) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_tap_open: TUNSETIFF %s failed, errno=%d", tap_data->ifname, errno);
+        goto open_failed;
+    }
+
+    int hdr_size = sizeof(struct virtio_net_hdr);
+    if (ioctl(dev->fd, TUNSETVNETHDRSZ, &hdr_size) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_tap_open: TUNSETVNETHDRSZ failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    // 允许内核交付未计算校验和的包，由vnet头中的NEEDS_CSUM标记
+    if (ioctl(dev->fd, TUNSETOFFLOAD, TUN_F_CSUM) < 0)
+    {
+        dbug_warn(DBG_MOD_PLATFORM, "netif_tap_open: TUNSETOFFLOAD failed, errno=%d", errno);
+    }
+
+    const int mtu = tap_data->mtu > 0 ? tap_data->mtu : 1500;
+    if (mtu < NETIF_MTU_MIN || mtu > NETIF_MTU_MAX)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_tap_open: invalid mtu %d", mtu);
+        goto open_failed;
+    }
+    tap_host_config(ifr.ifr_name, tap_data, mtu);
+
+    dev->exit_sem = sys_sem_create(0);
+    if (dev->exit_sem == SYS_SEM_INVALID)
+    {
+        goto open_failed;
+    }
+
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = mtu;
+    // 内核侧MTU在打开时设定，运行中只允许调小
+    netif->mtu_max = mtu;
+    // UDP GSO大包与部分校验和直接交给内核处理
+    netif->features |= NETIF_FEATURE_GSO_UDP | NETIF_FEATURE_CSUM_PARTIAL;
+    netif->opts_data = dev;
+    if (tap_data->hwaddr)
+    {
+        netif_set_hwaddr(netif, tap_data->hwaddr, 6);
+    }
+    else
+    {
+        // 未指定时使用本地管理地址
+        static const uint8_t default_hwaddr[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+        netif_set_hwaddr(netif, default_hwaddr, 6);
+    }
+
+    dev->running = true;
+    if (sys_thread_create(tap_recv_thread, dev) == SYS_THREAD_INVALID)
+    {
+        goto thread_failed;
+    }
+    dev->thread_cnt++;
+    if (sys_thread_create(tap_send_thread, dev) == SYS_THREAD_INVALID)
+    {
+        goto thread_failed;
+    }
+    dev->thread_cnt++;
+    return NET_ERR_OK;
+
+thread_failed:
+    dev->running = false;
+    while (dev->thread_cnt-- > 0)
+    {
+        sys_sem_wait(dev->exit_sem, 0);
+    }
+open_failed:
+    tap_dev_free(dev);
+    return NET_ERR_IO;
+}
+
+net_err_t netif_tap_close(netif_t* netif)
+{
+    tap_dev_t* dev = netif->opts_data;
+
+    dev->running = false;
+    while (dev->thread_cnt-- > 0)
+    {
+        sys_sem_wait(dev->exit_sem, 0);
+    }
+    tap_dev_free(dev);
+    return NET_ERR_OK;
+}
+
+net_err_t netif_tap_output(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_tap_get_stats(netif_t* netif, tap_stats_t* stats)
+{
+    if (netif->opts != &netdev_tap_ops)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+    const tap_dev_t* dev = netif->opts_data;
+    *stats = dev->stats;
+    return NET_ERR_OK;
+}
+
+#else
+
+net_err_t netif_tap_open(netif_t* netif, void* data)
+{
+    dbug_error(DBG_MOD_PLATFORM, "netif_tap_open: tun/tap is only supported on linux");
+    return NET_ERR_SYS;
+}
+
+net_err_t netif_tap_close(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_tap_output(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_tap_get_stats(netif_t* netif, tap_stats_t* stats)
+{
+    return NET_ERR_SYS;
+}
+
+#endif
+
+const netif_open_options_t netdev_tap_ops = {
+    .open = netif_tap_open,
+    .close = netif_tap_close,
+    .linkoutput = netif_tap_output,
+};
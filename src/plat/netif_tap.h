@@ -0,0 +1,57 @@
+#ifndef TINY_NET_NETIF_TAP_H
+#define TINY_NET_NETIF_TAP_H
+
+#include "net_err.h"
+#include "netif.h"
+
+// 单帧最大长度，能容纳内核交付的GSO大帧
+#define TAP_FRAME_MAX 65550
+
+// writev单次最多聚合的iovec数量，超过时退化为复制发送
+#define TAP_IOV_MAX 64
+
+// 发送线程单次最多取出的包数
+#define TAP_TX_BURST_MAX 32
+
+// 驱动线程轮询超时时间，单位：毫秒
+#define TAP_POLL_TMO 100
+
+typedef struct tap_data_t
+{
+    // TAP设备名称，如 tap0，不存在时自动创建
+    const char* ifname;
+    // 协议栈使用的硬件地址
+    const uint8_t* hwaddr;
+    // 接口MTU，0表示使用1500，最大为NETIF_MTU_MAX
+    int mtu;
+    // 接收队列数量，按流哈希分散到各队列，0表示单队列
+    int rx_queues;
+    // 内核侧TAP接口的IP地址与掩码，为NULL时不配置
+    const char* host_ip;
+    const char* host_mask;
+} tap_data_t;
+
+typedef struct tap_stats_t
+{
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t rx_dropped;
+    // 内核标记为校验和已验证(DATA_VALID)的包数
+    uint64_t rx_csum_valid;
+    // 内核交付的部分校验和(NEEDS_CSUM)包数，由驱动补全校验和
+    uint64_t rx_csum_partial;
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t tx_dropped;
+    // 未分段直接交给内核的UDP GSO大包数
+    uint64_t tx_gso;
+    // 交给内核补全校验和的包数
+    uint64_t tx_csum_partial;
+} tap_stats_t;
+
+// 获取TAP网卡的统计信息
+net_err_t netif_tap_get_stats(netif_t* netif, tap_stats_t* stats);
+
+extern const netif_open_options_t netdev_tap_ops;
+
+#endif //TINY_NET_NETIF_TAP_H
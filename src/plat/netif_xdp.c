@@ -0,0 +1,892 @@
+#include "netif_xdp.h"
+#include "sys_plat.h"
+#include "dbug.h"
+#include "mblock.h"
+
+#if defined(SYS_PLAT_LINUX) && defined(__linux__)
+
+#include <poll.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+// 最多同时打开的XDP网卡数量
+#define XDP_DEV_NR 2
+
+// XSKMAP表项数量，需大于使用的最大队列号
+#define XDP_XSKMAP_SIZE 64
+
+/*
+ * pcap.h中的经典BPF定义(struct bpf_insn等)与linux/bpf.h冲突，
+ * 这里只定义加载内置XDP程序所需的最小eBPF系统调用接口
+ */
+#define XDP_BPF_MAP_CREATE          0
+#define XDP_BPF_MAP_UPDATE_ELEM     2
+#define XDP_BPF_PROG_LOAD           5
+#define XDP_BPF_MAP_TYPE_XSKMAP     17
+#define XDP_BPF_PROG_TYPE_XDP       6
+#define XDP_BPF_FUNC_REDIRECT_MAP   51
+#define XDP_BPF_PSEUDO_MAP_FD       1
+#define XDP_ACT_PASS                2
+
+// eBPF指令操作码
+#define XDP_BPF_OP_LDX_MEM_W        0x61
+#define XDP_BPF_OP_LD_IMM64         0x18
+#define XDP_BPF_OP_MOV64_IMM        0xb7
+#define XDP_BPF_OP_CALL             0x85
+#define XDP_BPF_OP_EXIT             0x95
+
+// struct xdp_md 中 rx_queue_index 字段偏移
+#define XDP_MD_RX_QUEUE_INDEX_OFF   16
+
+typedef struct xdp_bpf_insn_t
+{
+    uint8_t code;
+    uint8_t dst_reg : 4;
+    uint8_t src_reg : 4;
+    int16_t off;
+    int32_t imm;
+} xdp_bpf_insn_t;
+
+typedef struct xdp_bpf_map_create_t
+{
+    uint32_t map_type;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t max_entries;
+    uint32_t map_flags;
+} xdp_bpf_map_create_t;
+
+typedef struct xdp_bpf_map_elem_t
+{
+    uint32_t map_fd;
+    uint64_t key __attribute__((aligned(8)));
+    uint64_t value;
+    uint64_t flags;
+} xdp_bpf_map_elem_t;
+
+typedef struct xdp_bpf_prog_load_t
+{
+    uint32_t prog_type;
+    uint32_t insn_cnt;
+    uint64_t insns;
+    uint64_t license;
+    uint32_t log_level;
+    uint32_t log_size;
+    uint64_t log_buf;
+    uint32_t kern_version;
+} xdp_bpf_prog_load_t;
+
+// 前半部分帧用于接收（经fill环交给内核），后半部分用于发送
+#define XDP_RX_FRAME_NR (XDP_FRAME_NR / 2)
+#define XDP_TX_FRAME_NR (XDP_FRAME_NR - XDP_RX_FRAME_NR)
+
+typedef struct xdp_ring_t
+{
+    uint32_t* producer;
+    uint32_t* consumer;
+    void* ring;
+    uint32_t mask;
+    // 本地缓存的生产者/消费者位置
+    uint32_t cached_prod;
+    uint32_t cached_cons;
+    void* map;
+    size_t map_len;
+} xdp_ring_t;
+
+struct xdp_dev_t;
+
+typedef struct xdp_queue_t
+{
+    struct xdp_dev_t* dev;
+    int fd;
+    int queue_id;
+    uint8_t* umem;
+    size_t umem_len;
+    xdp_ring_t fill;
+    xdp_ring_t comp;
+    xdp_ring_t rx;
+    xdp_ring_t tx;
+    // 接收帧空闲栈，由pktbuf释放回调与收包线程共享
+    uint32_t rx_free[XDP_RX_FRAME_NR];
+    int rx_free_cnt;
+    nlocker_t rx_locker;
+    // 发送帧空闲栈，只由发包线程访问
+    uint32_t tx_free[XDP_TX_FRAME_NR];
+    int tx_free_cnt;
+    xdp_queue_stats_t stats;
+} xdp_queue_t;
+
+typedef struct xdp_dev_t
+{
+    netif_t* netif;
+    int ifindex;
+    int map_fd;
+    int prog_fd;
+    int queue_nr;
+    xdp_queue_t queues[XDP_QUEUE_MAX_NR];
+    volatile bool running;
+    // 驱动线程退出通知
+    sys_sem_t exit_sem;
+    int thread_cnt;
+    // 引用计数：网卡打开时持有一个，交给协议栈的每个UMEM帧各持有一个，归零时才释放UMEM
+    int ref;
+} xdp_dev_t;
+
+static xdp_dev_t xdp_dev_tbl[XDP_DEV_NR];
+
+static mblock_t xdp_dev_mblock;
+
+static bool xdp_dev_inited = false;
+
+static int sys_bpf(const int cmd, void* attr, const size_t size)
+{
+    return (int)syscall(__NR_bpf, cmd, attr, size);
+}
+
+static uint32_t ring_load_acquire(const uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void ring_store_release(uint32_t* p, const uint32_t val)
+{
+    __atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+// 生产者侧可用空间
+static uint32_t ring_prod_free(xdp_ring_t* r, const uint32_t size)
+{
+    r->cached_cons = ring_load_acquire(r->consumer);
+    return size - (r->cached_prod - r->cached_cons);
+}
+
+// 消费者侧可读数量
+static uint32_t ring_cons_avail(xdp_ring_t* r)
+{
+    r->cached_prod = ring_load_acquire(r->producer);
+    return r->cached_prod - r->cached_cons;
+}
+
+static net_err_t ring_map(xdp_ring_t* r, const int fd, const struct xdp_ring_offset* off, const size_t entry_size,
+                          const off_t pgoff)
+{
+    r->map_len = off->desc + XDP_RING_SIZE * entry_size;
+    r->map = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pgoff);
+    if (r->map == MAP_FAILED)
+    {
+        r->map = NULL;
+        return NET_ERR_SYS;
+    }
+    r->producer = (uint32_t*)((uint8_t*)r->map + off->producer);
+    r->consumer = (uint32_t*)((uint8_t*)r->map + off->consumer);
+    r->ring = (uint8_t*)r->map + off->desc;
+    r->mask = XDP_RING_SIZE - 1;
+    r->cached_prod = *r->producer;
+    r->cached_cons = *r->consumer;
+    return NET_ERR_OK;
+}
+
+static void ring_unmap(xdp_ring_t* r)
+{
+    if (r->map)
+    {
+        munmap(r->map, r->map_len);
+        r->map = NULL;
+    }
+}
+
+static void xdp_dev_free(xdp_dev_t* dev);
+
+// 释放对设备的一个引用，最后一个引用释放时交还UMEM与设备
+static void xdp_dev_put(xdp_dev_t* dev)
+{
+    if (__atomic_sub_fetch(&dev->ref, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        xdp_dev_free(dev);
+    }
+}
+
+// pktbuf释放时将UMEM帧交还给接收空闲栈，并释放帧对设备的引用
+static void xdp_frame_release(void* arg, uint8_t* start)
+{
+    xdp_queue_t* q = arg;
+    const uint32_t frame = (uint32_t)((start - q->umem) / XDP_FRAME_SIZE);
+
+    nlocker_lock(&q->rx_locker);
+    q->rx_free[q->rx_free_cnt++] = frame;
+    nlocker_unlock(&q->rx_locker);
+    xdp_dev_put(q->dev);
+}
+
+// 将空闲的接收帧补充到fill环
+static void xdp_fill_refill(xdp_queue_t* q)
+{
+    xdp_ring_t* fill = &q->fill;
+    uint32_t free_slots = ring_prod_free(fill, XDP_RING_SIZE);
+    if (free_slots == 0)
+    {
+        return;
+    }
+
+    nlocker_lock(&q->rx_locker);
+    uint32_t n = (uint32_t)q->rx_free_cnt < free_slots ? (uint32_t)q->rx_free_cnt : free_slots;
+    uint64_t* addrs = fill->ring;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const uint32_t frame = q->rx_free[--q->rx_free_cnt];
+        addrs[(fill->cached_prod + i) & fill->mask] = (uint64_t)frame * XDP_FRAME_SIZE;
+    }
+    nlocker_unlock(&q->rx_locker);
+
+    if (n == 0)
+    {
+        q->stats.rx_fill_empty++;
+        return;
+    }
+    fill->cached_prod += n;
+    ring_store_release(fill->producer, fill->cached_prod);
+}
+
+// 回收completion环中已发送完成的帧
+static void xdp_comp_reap(xdp_queue_t* q)
+{
+    xdp_ring_t* comp = &q->comp;
+    const uint32_t n = ring_cons_avail(comp);
+    const uint64_t* addrs = comp->ring;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const uint64_t addr = addrs[(comp->cached_cons + i) & comp->mask];
+        q->tx_free[q->tx_free_cnt++] = (uint32_t)(addr / XDP_FRAME_SIZE);
+    }
+    if (n)
+    {
+        comp->cached_cons += n;
+        ring_store_release(comp->consumer, comp->cached_cons);
+    }
+}
+
+static void xdp_recv_thread(void* arg)
+{
+    xdp_queue_t* q = arg;
+    xdp_dev_t* dev = q->dev;
+    netif_t* netif = dev->netif;
+    plat_printf("xdp recv_thread started, queue %d\n", q->queue_id);
+
+    struct pollfd pfd = {.fd = q->fd, .events = POLLIN};
+    while (dev->running)
+    {
+        xdp_fill_refill(q);
+
+        xdp_ring_t* rx = &q->rx;
+        uint32_t n = ring_cons_avail(rx);
+        if (n == 0)
+        {
+            poll(&pfd, 1, XDP_POLL_TMO);
+            continue;
+        }
+        if (n > XDP_BATCH_SIZE)
+        {
+            n = XDP_BATCH_SIZE;
+        }
+
+        const struct xdp_desc* descs = rx->ring;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const struct xdp_desc* desc = &descs[(rx->cached_cons + i) & rx->mask];
+            const uint64_t base = desc->addr & ~((uint64_t)XDP_FRAME_SIZE - 1);
+
+            // UMEM帧直接作为pktbuf的外部数据区，不复制；帧释放前网卡关闭也不会解除UMEM映射
+            __atomic_add_fetch(&dev->ref, 1, __ATOMIC_RELAXED);
+            pktbuf_t* buf = pktbuf_alloc_ext(q->umem + base, XDP_FRAME_SIZE, (int)(desc->addr - base),
+                                             (int)desc->len, xdp_frame_release, q);
+            if (!buf)
+            {
+                dbug_warn(DBG_MOD_PLATFORM, "xdp recv_thread: pktbuf_alloc_ext failed");
+                xdp_frame_release(q, q->umem + base);
+                q->stats.rx_dropped++;
+                netif_stats_drop(netif, NETIF_DROP_NO_BUF);
+                continue;
+            }
+
+            if (netif_put_in(netif, buf, -1) != NET_ERR_OK)
+            {
+                dbug_warn(DBG_MOD_PLATFORM, "xdp recv_thread: netif_put_in failed");
+                pktbuf_free(buf);
+                q->stats.rx_dropped++;
+                continue;
+            }
+            q->stats.rx_packets++;
+            q->stats.rx_bytes += desc->len;
+        }
+        rx->cached_cons += n;
+        ring_store_release(rx->consumer, rx->cached_cons);
+    }
+
+    sys_sem_notify(dev->exit_sem);
+}
+
+// 将一个数据包复制到发送帧并放入tx环
+static bool xdp_tx_one(xdp_queue_t* q, pktbuf_t* buf)
+{
+    const int total_size = (int)buf->total_size;
+    if (total_size > XDP_FRAME_SIZE || q->tx_free_cnt == 0 || ring_prod_free(&q->tx, XDP_RING_SIZE) == 0)
+    {
+        q->stats.tx_dropped++;
+        return false;
+    }
+
+    const uint32_t frame = q->tx_free[--q->tx_free_cnt];
+    const uint64_t addr = (uint64_t)frame * XDP_FRAME_SIZE;
+    pktbuf_read(buf, q->umem + addr, total_size);
+
+    struct xdp_desc* descs = q->tx.ring;
+    struct xdp_desc* desc = &descs[q->tx.cached_prod++ & q->tx.mask];
+    desc->addr = addr;
+    desc->len = (uint32_t)total_size;
+    desc->options = 0;
+
+    q->stats.tx_packets++;
+    q->stats.tx_bytes += total_size;
+    return true;
+}
+
+static void xdp_send_thread(void* arg)
+{
+    xdp_dev_t* dev = arg;
+    netif_t* netif = dev->netif;
+    // 发送统一使用第一个队列
+    xdp_queue_t* q = &dev->queues[0];
+    plat_printf("xdp send_thread started\n");
+
+    while (dev->running)
+    {
+        xdp_comp_reap(q);
+
+        pktbuf_t* buf = netif_get_out(netif, XDP_POLL_TMO);
+        if (buf == NULL)
+        {
+            continue;
+        }
+
+        // 批量取出发送队列中的包后再统一通知内核
+        int cnt = 0;
+        do
+        {
+            if (q->tx_free_cnt == 0)
+            {
+                xdp_comp_reap(q);
+            }
+            if (xdp_tx_one(q, buf))
+            {
+                cnt++;
+            }
+            pktbuf_free(buf);
+        }
+        while (cnt < XDP_BATCH_SIZE && (buf = netif_get_out(netif, -1)) != NULL);
+
+        if (cnt)
+        {
+            ring_store_release(q->tx.producer, q->tx.cached_prod);
+            // 通用(SKB)模式下需要sendto触发发送
+            if (sendto(q->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0 && errno != EAGAIN && errno != EBUSY &&
+                errno != ENOBUFS)
+            {
+                dbug_error(DBG_MOD_PLATFORM, "xdp send_thread: sendto failed, errno=%d", errno);
+            }
+        }
+    }
+
+    sys_sem_notify(dev->exit_sem);
+}
+
+// 内置XDP程序：return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+static int xdp_prog_load(const int map_fd)
+{
+    const xdp_bpf_insn_t insns[] = {
+        // r2 = ctx->rx_queue_index
+        {.code = XDP_BPF_OP_LDX_MEM_W, .dst_reg = 2, .src_reg = 1, .off = XDP_MD_RX_QUEUE_INDEX_OFF},
+        // r1 = map_fd（64位立即数占两条指令）
+        {.code = XDP_BPF_OP_LD_IMM64, .dst_reg = 1, .src_reg = XDP_BPF_PSEUDO_MAP_FD, .imm = map_fd},
+        {0},
+        // r3 = XDP_PASS，队列未绑定socket时交给内核协议栈
+        {.code = XDP_BPF_OP_MOV64_IMM, .dst_reg = 3, .imm = XDP_ACT_PASS},
+        {.code = XDP_BPF_OP_CALL, .imm = XDP_BPF_FUNC_REDIRECT_MAP},
+        {.code = XDP_BPF_OP_EXIT},
+    };
+    static const char license[] = "GPL";
+
+    xdp_bpf_prog_load_t attr;
+    plat_memset(&attr, 0, sizeof(attr));
+    attr.prog_type = XDP_BPF_PROG_TYPE_XDP;
+    attr.insns = (uint64_t)(uintptr_t)insns;
+    attr.insn_cnt = sizeof(insns) / sizeof(insns[0]);
+    attr.license = (uint64_t)(uintptr_t)license;
+    return sys_bpf(XDP_BPF_PROG_LOAD, &attr, sizeof(attr));
+}
+
+static int xdp_map_create(void)
+{
+    xdp_bpf_map_create_t attr;
+    plat_memset(&attr, 0, sizeof(attr));
+    attr.map_type = XDP_BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(int);
+    attr.value_size = sizeof(int);
+    attr.max_entries = XDP_XSKMAP_SIZE;
+    return sys_bpf(XDP_BPF_MAP_CREATE, &attr, sizeof(attr));
+}
+
+static int xdp_map_update(const int map_fd, int key, int value)
+{
+    xdp_bpf_map_elem_t attr;
+    plat_memset(&attr, 0, sizeof(attr));
+    attr.map_fd = (uint32_t)map_fd;
+    attr.key = (uint64_t)(uintptr_t)&key;
+    attr.value = (uint64_t)(uintptr_t)&value;
+    attr.flags = 0;
+    return sys_bpf(XDP_BPF_MAP_UPDATE_ELEM, &attr, sizeof(attr));
+}
+
+// 通过netlink以通用(SKB)模式挂载或卸载(prog_fd = -1)XDP程序
+static net_err_t xdp_link_set(const int ifindex, const int prog_fd)
+{
+    struct
+    {
+        struct nlmsghdr nh;
+        struct ifinfomsg ifinfo;
+        char attrbuf[64];
+    } req;
+
+    int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (sock < 0)
+    {
+        return NET_ERR_SYS;
+    }
+
+    plat_memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    req.nh.nlmsg_type = RTM_SETLINK;
+    req.ifinfo.ifi_family = AF_UNSPEC;
+    req.ifinfo.ifi_index = ifindex;
+
+    // IFLA_XDP { IFLA_XDP_FD, IFLA_XDP_FLAGS }
+    struct nlattr* nla = (struct nlattr*)((char*)&req + NLMSG_ALIGN(req.nh.nlmsg_len));
+    nla->nla_type = NLA_F_NESTED | IFLA_XDP;
+    nla->nla_len = NLA_HDRLEN;
+
+    struct nlattr* attr = (struct nlattr*)((char*)nla + nla->nla_len);
+    attr->nla_type = IFLA_XDP_FD;
+    attr->nla_len = NLA_HDRLEN + sizeof(int);
+    plat_memcpy((char*)attr + NLA_HDRLEN, &prog_fd, sizeof(int));
+    nla->nla_len += NLA_ALIGN(attr->nla_len);
+
+    const uint32_t flags = XDP_FLAGS_SKB_MODE;
+    attr = (struct nlattr*)((char*)nla + nla->nla_len);
+    attr->nla_type = IFLA_XDP_FLAGS;
+    attr->nla_len = NLA_HDRLEN + sizeof(uint32_t);
+    plat_memcpy((char*)attr + NLA_HDRLEN, &flags, sizeof(uint32_t));
+    nla->nla_len += NLA_ALIGN(attr->nla_len);
+
+    req.nh.nlmsg_len += NLA_ALIGN(nla->nla_len);
+
+    net_err_t err = NET_ERR_OK;
+    if (send(sock, &req, req.nh.nlmsg_len, 0) < 0)
+    {
+        err = NET_ERR_SYS;
+    }
+    else
+    {
+        char ack[256];
+        const ssize_t len = recv(sock, ack, sizeof(ack), 0);
+        const struct nlmsghdr* nh = (const struct nlmsghdr*)ack;
+        if (len < (ssize_t)NLMSG_LENGTH(sizeof(struct nlmsgerr)) || nh->nlmsg_type != NLMSG_ERROR ||
+            ((const struct nlmsgerr*)NLMSG_DATA(nh))->error != 0)
+        {
+            err = NET_ERR_SYS;
+        }
+    }
+    close(sock);
+    return err;
+}
+
+static void xdp_queue_close(xdp_queue_t* q)
+{
+    ring_unmap(&q->fill);
+    ring_unmap(&q->comp);
+    ring_unmap(&q->rx);
+    ring_unmap(&q->tx);
+    if (q->fd >= 0)
+    {
+        close(q->fd);
+        q->fd = -1;
+    }
+    if (q->umem)
+    {
+        munmap(q->umem, q->umem_len);
+        q->umem = NULL;
+    }
+    nlocker_destroy(&q->rx_locker);
+}
+
+static net_err_t xdp_queue_open(xdp_dev_t* dev, xdp_queue_t* q, const int queue_id)
+{
+    plat_memset(q, 0, sizeof(xdp_queue_t));
+    q->dev = dev;
+    q->fd = -1;
+    q->queue_id = queue_id;
+    if (nlocker_init(&q->rx_locker, NLOCKER_TYPE_THREAD) != NET_ERR_OK)
+    {
+        return NET_ERR_SYS;
+    }
+
+    q->umem_len = (size_t)XDP_FRAME_NR * XDP_FRAME_SIZE;
+    q->umem = mmap(NULL, q->umem_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (q->umem == MAP_FAILED)
+    {
+        q->umem = NULL;
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: mmap umem failed");
+        goto open_failed;
+    }
+
+    q->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (q->fd < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: create AF_XDP socket failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    struct xdp_umem_reg mr;
+    plat_memset(&mr, 0, sizeof(mr));
+    mr.addr = (uint64_t)(uintptr_t)q->umem;
+    mr.len = q->umem_len;
+    mr.chunk_size = XDP_FRAME_SIZE;
+    mr.headroom = 0;
+    if (setsockopt(q->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: register umem failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    const int ring_size = XDP_RING_SIZE;
+    if (setsockopt(q->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(int)) < 0 ||
+        setsockopt(q->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(int)) < 0 ||
+        setsockopt(q->fd, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(int)) < 0 ||
+        setsockopt(q->fd, SOL_XDP, XDP_TX_RING, &ring_size, sizeof(int)) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: set ring size failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if (getsockopt(q->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: get mmap offsets failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    if (ring_map(&q->fill, q->fd, &off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) != NET_ERR_OK ||
+        ring_map(&q->comp, q->fd, &off.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) != NET_ERR_OK ||
+        ring_map(&q->rx, q->fd, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) != NET_ERR_OK ||
+        ring_map(&q->tx, q->fd, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: mmap rings failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    // 划分接收帧与发送帧
+    for (int i = 0; i < XDP_RX_FRAME_NR; i++)
+    {
+        q->rx_free[q->rx_free_cnt++] = (uint32_t)i;
+    }
+    for (int i = 0; i < XDP_TX_FRAME_NR; i++)
+    {
+        q->tx_free[q->tx_free_cnt++] = (uint32_t)(XDP_RX_FRAME_NR + i);
+    }
+    xdp_fill_refill(q);
+
+    // 通用模式使用复制方式，无需网卡驱动支持
+    struct sockaddr_xdp sxdp;
+    plat_memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = dev->ifindex;
+    sxdp.sxdp_queue_id = queue_id;
+    sxdp.sxdp_flags = XDP_COPY;
+    if (bind(q->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: bind queue %d failed, errno=%d", queue_id, errno);
+        goto open_failed;
+    }
+
+    if (xdp_map_update(dev->map_fd, queue_id, q->fd) < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "xdp_queue_open: update xskmap failed, errno=%d", errno);
+        goto open_failed;
+    }
+    return NET_ERR_OK;
+
+open_failed:
+    xdp_queue_close(q);
+    return NET_ERR_IO;
+}
+
+static void xdp_dev_free(xdp_dev_t* dev)
+{
+    if (dev->prog_fd >= 0)
+    {
+        xdp_link_set(dev->ifindex, -1);
+        close(dev->prog_fd);
+    }
+    for (int i = 0; i < dev->queue_nr; i++)
+    {
+        xdp_queue_close(&dev->queues[i]);
+    }
+    if (dev->map_fd >= 0)
+    {
+        close(dev->map_fd);
+    }
+    if (dev->exit_sem != SYS_SEM_INVALID)
+    {
+        sys_sem_free(dev->exit_sem);
+    }
+    mblock_free(&xdp_dev_mblock, dev);
+}
+
+static net_err_t xdp_get_hwaddr(const char* ifname, uint8_t* hwaddr)
+{
+    struct ifreq ifr;
+    plat_memset(&ifr, 0, sizeof(ifr));
+    plat_strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        return NET_ERR_SYS;
+    }
+    const int ret = ioctl(sock, SIOCGIFHWADDR, &ifr);
+    close(sock);
+    if (ret < 0)
+    {
+        return NET_ERR_SYS;
+    }
+    plat_memcpy(hwaddr, ifr.ifr_hwaddr.sa_data, 6);
+    return NET_ERR_OK;
+}
+
+net_err_t netif_xdp_open(netif_t* netif, void* data)
+{
+    const xdp_data_t* xdp_data = data;
+
+    if (!xdp_dev_inited)
+    {
+        // 设备可能在协议栈线程释放最后一帧时归还
+        mblock_init(&xdp_dev_mblock, xdp_dev_tbl, sizeof(xdp_dev_t), XDP_DEV_NR, NLOCKER_TYPE_THREAD);
+        xdp_dev_inited = true;
+    }
+
+    const int queue_nr = xdp_data->queue_nr > 0 ? xdp_data->queue_nr : 1;
+    if (queue_nr > XDP_QUEUE_MAX_NR || xdp_data->queue_id < 0 || xdp_data->queue_id + queue_nr > XDP_XSKMAP_SIZE)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: invalid queue range %d+%d", xdp_data->queue_id, queue_nr);
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    xdp_dev_t* dev = mblock_alloc(&xdp_dev_mblock, -1);
+    if (dev == NULL)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: no free xdp dev");
+        return NET_ERR_MEM;
+    }
+    plat_memset(dev, 0, sizeof(xdp_dev_t));
+    dev->netif = netif;
+    dev->map_fd = -1;
+    dev->prog_fd = -1;
+    dev->exit_sem = SYS_SEM_INVALID;
+    dev->ref = 1;
+
+    dev->ifindex = (int)if_nametoindex(xdp_data->ifname);
+    if (dev->ifindex == 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: no such interface %s", xdp_data->ifname);
+        goto open_failed;
+    }
+
+    dev->exit_sem = sys_sem_create(0);
+    if (dev->exit_sem == SYS_SEM_INVALID)
+    {
+        goto open_failed;
+    }
+
+    dev->map_fd = xdp_map_create();
+    if (dev->map_fd < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: create xskmap failed, errno=%d", errno);
+        goto open_failed;
+    }
+
+    for (int i = 0; i < queue_nr; i++)
+    {
+        if (xdp_queue_open(dev, &dev->queues[i], xdp_data->queue_id + i) != NET_ERR_OK)
+        {
+            goto open_failed;
+        }
+        dev->queue_nr++;
+    }
+
+    dev->prog_fd = xdp_prog_load(dev->map_fd);
+    if (dev->prog_fd < 0)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: load xdp prog failed, errno=%d", errno);
+        goto open_failed;
+    }
+    if (xdp_link_set(dev->ifindex, dev->prog_fd) != NET_ERR_OK)
+    {
+        dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: attach xdp prog to %s failed", xdp_data->ifname);
+        close(dev->prog_fd);
+        dev->prog_fd = -1;
+        goto open_failed;
+    }
+
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = 1500;
+    // UMEM帧固定为XDP_FRAME_SIZE，不支持巨帧
+    netif->mtu_max = 1500;
+    netif->opts_data = dev;
+
+    uint8_t hwaddr[6];
+    if (xdp_data->hwaddr)
+    {
+        netif_set_hwaddr(netif, xdp_data->hwaddr, 6);
+    }
+    else if (xdp_get_hwaddr(xdp_data->ifname, hwaddr) == NET_ERR_OK)
+    {
+        netif_set_hwaddr(netif, hwaddr, 6);
+    }
+
+    dev->running = true;
+    for (int i = 0; i < dev->queue_nr; i++)
+    {
+        if (sys_thread_create(xdp_recv_thread, &dev->queues[i]) == SYS_THREAD_INVALID)
+        {
+            goto thread_failed;
+        }
+        dev->thread_cnt++;
+    }
+    if (sys_thread_create(xdp_send_thread, dev) == SYS_THREAD_INVALID)
+    {
+        goto thread_failed;
+    }
+    dev->thread_cnt++;
+    return NET_ERR_OK;
+
+thread_failed:
+    dev->running = false;
+    while (dev->thread_cnt-- > 0)
+    {
+        sys_sem_wait(dev->exit_sem, 0);
+    }
+    netif->opts_data = NULL;
+open_failed:
+    // 已启动的接收线程可能把UMEM帧交给了协议栈，由最后一个引用归还设备
+    xdp_dev_put(dev);
+    return NET_ERR_IO;
+}
+
+net_err_t netif_xdp_close(netif_t* netif)
+{
+    xdp_dev_t* dev = netif->opts_data;
+
+    // 先卸载XDP程序，不再有新帧重定向到套接字
+    if (dev->prog_fd >= 0)
+    {
+        xdp_link_set(dev->ifindex, -1);
+        close(dev->prog_fd);
+        dev->prog_fd = -1;
+    }
+
+    // 等待所有驱动线程退出
+    dev->running = false;
+    while (dev->thread_cnt-- > 0)
+    {
+        sys_sem_wait(dev->exit_sem, 0);
+    }
+
+    // 仍有UMEM帧在协议栈中时，由最后释放的帧解除映射并归还设备
+    netif->opts_data = NULL;
+    xdp_dev_put(dev);
+    return NET_ERR_OK;
+}
+
+net_err_t netif_xdp_output(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_xdp_get_stats(netif_t* netif, const int queue, xdp_queue_stats_t* stats)
+{
+    xdp_dev_t* dev = netif->opts_data;
+    if (netif->opts != &netdev_xdp_ops || dev == NULL || queue < 0 || queue >= dev->queue_nr)
+    {
+        return NET_ERR_INVALID_PARAM;
+    }
+
+    xdp_queue_t* q = &dev->queues[queue];
+    *stats = q->stats;
+
+    struct xdp_statistics kstats;
+    socklen_t optlen = sizeof(kstats);
+    plat_memset(&kstats, 0, sizeof(kstats));
+    if (getsockopt(q->fd, SOL_XDP, XDP_STATISTICS, &kstats, &optlen) == 0)
+    {
+        stats->kern_rx_dropped = kstats.rx_dropped;
+        stats->kern_rx_invalid_descs = kstats.rx_invalid_descs;
+        stats->kern_tx_invalid_descs = kstats.tx_invalid_descs;
+    }
+    return NET_ERR_OK;
+}
+
+#else
+
+net_err_t netif_xdp_open(netif_t* netif, void* data)
+{
+    dbug_error(DBG_MOD_PLATFORM, "netif_xdp_open: AF_XDP is only supported on linux");
+    return NET_ERR_SYS;
+}
+
+net_err_t netif_xdp_close(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_xdp_output(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+net_err_t netif_xdp_get_stats(netif_t* netif, int queue, xdp_queue_stats_t* stats)
+{
+    return NET_ERR_SYS;
+}
+
+#endif
+
+const netif_open_options_t netdev_xdp_ops = {
+    .open = netif_xdp_open,
+    .close = netif_xdp_close,
+    .linkoutput = netif_xdp_output,
+};
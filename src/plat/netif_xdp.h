@@ -0,0 +1,63 @@
+#ifndef TINY_NET_NETIF_XDP_H
+#define TINY_NET_NETIF_XDP_H
+
+#include "net_err.h"
+#include "netif.h"
+
+// UMEM帧大小，必须为2的幂
+#define XDP_FRAME_SIZE 2048
+
+// 每个队列的UMEM帧数量
+#define XDP_FRAME_NR 4096
+
+// fill/completion/rx/tx 环大小，必须为2的幂
+#define XDP_RING_SIZE 2048
+
+// 每次从环中批量处理的描述符数量
+#define XDP_BATCH_SIZE 64
+
+// 单个网卡最多绑定的队列数量
+#define XDP_QUEUE_MAX_NR 4
+
+// 驱动线程轮询超时时间，单位：毫秒
+#define XDP_POLL_TMO 100
+
+typedef struct xdp_data_t
+{
+    // 绑定的系统网卡名称，如 veth0
+    const char* ifname;
+    // 起始队列号
+    int queue_id;
+    // 队列数量，每个队列独立的UMEM与收包线程
+    int queue_nr;
+    // 设备硬件地址
+    const uint8_t* hwaddr;
+} xdp_data_t;
+
+// 单个队列的统计信息
+typedef struct xdp_queue_stats_t
+{
+    // 接收包数与字节数
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    // 接收丢包（pktbuf不足或输入队列已满）
+    uint64_t rx_dropped;
+    // fill环无可用帧次数
+    uint64_t rx_fill_empty;
+    // 发送包数与字节数
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    // 发送丢包（无空闲帧或包过大）
+    uint64_t tx_dropped;
+    // 内核统计：XDP_STATISTICS
+    uint64_t kern_rx_dropped;
+    uint64_t kern_rx_invalid_descs;
+    uint64_t kern_tx_invalid_descs;
+} xdp_queue_stats_t;
+
+// 获取指定队列的统计信息
+net_err_t netif_xdp_get_stats(netif_t* netif, int queue, xdp_queue_stats_t* stats);
+
+extern const netif_open_options_t netdev_xdp_ops;
+
+#endif //TINY_NET_NETIF_XDP_H
@@ -44,6 +44,12 @@ int sys_time_goes(net_time_t* pre)
     return diff_ms;
 }
 
+uint32_t sys_time_us(void)
+{
+    // 精度受限于系统节拍
+    return sys_get_ticks() * OS_TICK_MS * 1000;
+}
+
 // 计数信号量相关：由具体平台实现
 sys_sem_t sys_sem_create(int init_count)
 {
@@ -65,6 +71,20 @@ int sys_sem_wait(sys_sem_t sem, uint32_t ms)
     return sem_wait_tmo(sem, ms);
 }
 
+int sys_sem_trywait(sys_sem_t sem)
+{
+    // 关中断期间检查计数，计数大于0时等待不会阻塞
+    sys_intlocker_t state = irq_enter_protection();
+    int err = -1;
+    if (sem_count(sem) > 0)
+    {
+        sem_wait(sem);
+        err = 0;
+    }
+    irq_leave_protection(state);
+    return err;
+}
+
 void sys_sem_notify(sys_sem_t sem)
 {
     sem_notify(sem);
@@ -140,6 +160,17 @@ void sys_sleep(int ms)
     sys_msleep(ms);
 }
 
+// 内核中没有文件系统接口
+int sys_file_save(const char* path, const void* data, int size)
+{
+    return -1;
+}
+
+int sys_file_load(const char* path, void* data, int size)
+{
+    return -1;
+}
+
 void sys_plat_init(void)
 {
     mblock_init(&task_mblock, task_tbl, sizeof(net_task_t), NET_TASK_NR, NLOCKER_NONE);
@@ -218,6 +249,18 @@ int sys_time_goes(net_time_t* pre)
     return diff_ms;
 }
 
+uint32_t sys_time_us(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (freq.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&count);
+    return (uint32_t)(count.QuadPart * 1000000 / freq.QuadPart);
+}
+
 sys_sem_t sys_sem_create(int init_count)
 {
     return CreateSemaphore(NULL, init_count, 0xFFFF, NULL);
@@ -246,6 +289,11 @@ int sys_sem_wait(sys_sem_t sem, uint32_t tmo_ms)
     return -1;
 }
 
+int sys_sem_trywait(sys_sem_t sem)
+{
+    return WaitForSingleObject(sem, 0) == WAIT_OBJECT_0 ? 0 : -1;
+}
+
 void sys_sem_notify(sys_sem_t sem)
 {
     ReleaseSemaphore(sem, 1, NULL);
@@ -325,6 +373,46 @@ void sys_sleep(int ms)
     Sleep(ms);
 }
 
+// 先写临时文件再改名，保存中途退出不会损坏旧文件
+int sys_file_save(const char* path, const void* data, int size)
+{
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    const int written = (int)fwrite(data, 1, size, file);
+    fclose(file);
+    if (written != size)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    // 目标文件已存在时改名会失败
+    remove(path);
+    if (rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return written;
+}
+
+int sys_file_load(const char* path, void* data, int size)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    const int nread = (int)fread(data, 1, size, file);
+    fclose(file);
+    return nread;
+}
+
 void sys_plat_init(void)
 {
 }
@@ -342,6 +430,7 @@ void sys_plat_init(void)
 #include <unistd.h>
 #include <semaphore.h>
 #include <sys/time.h>
+#include <time.h>
 
 int load_pcap_lib(void)
 {
@@ -369,12 +458,30 @@ int sys_time_goes(net_time_t* pre)
 
     // 记录过去了多少毫秒
     int diff_ms = (curr.tv_sec - pre->tv_sec) * 1000 + (curr.tv_usec - pre->tv_usec) / 1000;
+    if (diff_ms < 0)
+    {
+        *pre = curr;
+        return diff_ms;
+    }
 
-    // 记录下这次调用的时间
-    *pre = curr;
+    // 只前进已计入的整毫秒，不足1毫秒的零头留到下次，频繁调用时定时器不会变慢
+    pre->tv_sec += diff_ms / 1000;
+    pre->tv_usec += (diff_ms % 1000) * 1000;
+    if (pre->tv_usec >= 1000000)
+    {
+        pre->tv_sec++;
+        pre->tv_usec -= 1000000;
+    }
     return diff_ms;
 }
 
+uint32_t sys_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
 sys_sem_t sys_sem_create(int init_count)
 {
     sys_sem_t sem = (sys_sem_t)malloc(sizeof(struct _xsys_sem_t));
@@ -422,15 +529,27 @@ int sys_sem_wait(sys_sem_t sem, uint32_t tmo_ms)
 {
     pthread_mutex_lock(&sem->locker);
 
-    if (sem->count <= 0)
+    // 超时时间换算成绝对时刻，精确到纳秒，否则毫秒级的超时会按秒取整
+    struct timespec ts;
+    if (tmo_ms > 0)
+    {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += tmo_ms / 1000;
+        ts.tv_nsec += (tmo_ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+    }
+
+    // 虚假唤醒时继续等待，直到有计数或超时
+    while (sem->count <= 0)
     {
         int ret;
 
         if (tmo_ms > 0)
         {
-            struct timespec ts;
-            ts.tv_nsec = (tmo_ms % 1000) * 1000000L;
-            ts.tv_sec = time(NULL) + tmo_ms / 1000;
             ret = pthread_cond_timedwait(&sem->cond, &sem->locker, &ts);
             if (ret == ETIMEDOUT)
             {
@@ -441,11 +560,12 @@ int sys_sem_wait(sys_sem_t sem, uint32_t tmo_ms)
         else
         {
             ret = pthread_cond_wait(&sem->cond, &sem->locker);
-            if (ret < 0)
-            {
-                pthread_mutex_unlock(&sem->locker);
-                return -1;
-            }
+        }
+
+        if (ret != 0 && ret != ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&sem->locker);
+            return -1;
         }
     }
 
@@ -454,6 +574,24 @@ int sys_sem_wait(sys_sem_t sem, uint32_t tmo_ms)
     return 0;
 }
 
+/**
+ * 不等待地获取信号量
+ * @param sem 信号量
+ * @return 成功返回0，无可用计数返回-1
+ */
+int sys_sem_trywait(sys_sem_t sem)
+{
+    int err = -1;
+    pthread_mutex_lock(&sem->locker);
+    if (sem->count > 0)
+    {
+        sem->count--;
+        err = 0;
+    }
+    pthread_mutex_unlock(&sem->locker);
+    return err;
+}
+
 /**
  * 通知信号量
  * @param sem 待通知的信号量
@@ -569,6 +707,44 @@ sys_thread_t sys_thread_self(void)
     return pthread_self();
 }
 
+// 先写临时文件再改名，保存中途退出不会损坏旧文件
+int sys_file_save(const char* path, const void* data, int size)
+{
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    const int written = (int)fwrite(data, 1, size, file);
+    fclose(file);
+    if (written != size)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    if (rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return written;
+}
+
+int sys_file_load(const char* path, void* data, int size)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    const int nread = (int)fread(data, 1, size, file);
+    fclose(file);
+    return nread;
+}
+
 void sys_plat_init(void)
 {
 }
@@ -815,18 +991,8 @@ pcap_t* pcap_device_open(const char* ip, const uint8_t* mac_addr)
         return (pcap_t*)0;
     }
 
-    // 根据名称获取ip地址、掩码等
-    char err_buf[PCAP_ERRBUF_SIZE];
-    bpf_u_int32 mask;
-    bpf_u_int32 net;
-    if (pcap_lookupnet(name_buf, &net, &mask, err_buf) == -1)
-    {
-        printf("pcap_lookupnet error: no net card: %s\n", name_buf);
-        net = 0;
-        mask = 0;
-    }
-
     // 打开设备
+    char err_buf[PCAP_ERRBUF_SIZE];
     pcap_t* pcap = pcap_create(name_buf, err_buf);
     if (pcap == NULL)
     {
@@ -873,24 +1039,83 @@ pcap_t* pcap_device_open(const char* ip, const uint8_t* mac_addr)
         return (pcap_t*)0;
     }
 
-    // 只捕获发往本接口与广播的数据帧。相当于只处理发往这张网卡的包
+    if (pcap_set_rx_filter(pcap, mac_addr) < 0)
+    {
+        return (pcap_t*)0;
+    }
+    return pcap;
+}
+
+/**
+ * 设置接收过滤：只捕获发往mac_addr与广播的数据帧，相当于只处理发往这张网卡的包
+ * 网卡加入聚合接口后用聚合接口的地址重新设置
+ */
+int pcap_set_rx_filter(pcap_t* pcap, const uint8_t* mac_addr)
+{
     char filter_exp[256];
     struct bpf_program fp;
     sprintf(filter_exp,
             "(ether dst %02x:%02x:%02x:%02x:%02x:%02x or ether broadcast) and (not ether src %02x:%02x:%02x:%02x:%02x:%02x)",
             mac_addr[0], mac_addr[1], mac_addr[2], mac_addr[3], mac_addr[4], mac_addr[5],
             mac_addr[0], mac_addr[1], mac_addr[2], mac_addr[3], mac_addr[4], mac_addr[5]);
-    if (pcap_compile(pcap, &fp, filter_exp, 0, net) == -1)
+    if (pcap_compile(pcap, &fp, filter_exp, 0, PCAP_NETMASK_UNKNOWN) == -1)
     {
         printf("pcap_open: couldn't parse filter %s: %s\n", filter_exp, pcap_geterr(pcap));
-        return (pcap_t*)0;
+        return -1;
     }
     if (pcap_setfilter(pcap, &fp) == -1)
     {
         printf("pcap_open: couldn't install filter %s: %s\n", filter_exp, pcap_geterr(pcap));
-        return (pcap_t*)0;
+        pcap_freecode(&fp);
+        return -1;
     }
-    return pcap;
+    pcap_freecode(&fp);
+    return 0;
+}
+
+/**
+ * 查询网络接口的载波状态
+ * @return 1连通，0断开，-1找不到接口或pcap库不提供连接状态
+ */
+int pcap_device_carrier(const char* name)
+{
+    char err_buf[PCAP_ERRBUF_SIZE];
+    pcap_if_t* pcap_if_list = NULL;
+    if (pcap_findalldevs(&pcap_if_list, err_buf) < 0)
+    {
+        return -1;
+    }
+
+    int carrier = -1;
+    for (pcap_if_t* item = pcap_if_list; item != NULL; item = item->next)
+    {
+        if (strcmp(item->name, name) != 0)
+        {
+            continue;
+        }
+#if defined(PCAP_IF_CONNECTION_STATUS)
+        // 较新的pcap库直接给出连接状态，无线等不适用的接口退回运行标志
+        const bpf_u_int32 status = item->flags & PCAP_IF_CONNECTION_STATUS;
+        if (status == PCAP_IF_CONNECTION_STATUS_CONNECTED)
+        {
+            carrier = 1;
+        }
+        else if (status == PCAP_IF_CONNECTION_STATUS_DISCONNECTED)
+        {
+            carrier = 0;
+        }
+        else
+        {
+            carrier = (item->flags & PCAP_IF_RUNNING) ? 1 : 0;
+        }
+#elif defined(PCAP_IF_RUNNING)
+        carrier = (item->flags & PCAP_IF_RUNNING) ? 1 : 0;
+#endif
+        break;
+    }
+
+    pcap_freealldevs(pcap_if_list);
+    return carrier;
 }
 
 #endif
@@ -52,6 +52,9 @@ typedef mutex_t* sys_mutex_t; // 互斥锁
 typedef task_t* sys_thread_t; // 线程
 typedef sem_t* sys_sem_t; // 信号量
 
+// 内核任务不支持线程局部存储，所有任务共用同一份变量
+#define SYS_THREAD_LOCAL
+
 #define plat_strlen         kernel_strlen
 #define plat_strcpy         kernel_strcpy
 #define plat_strncpy        kernel_strncpy
@@ -83,6 +86,13 @@ typedef HANDLE sys_mutex_t; // 互斥锁
 typedef HANDLE sys_thread_t; // 线程
 typedef HANDLE sys_sem_t; // 信号量
 
+// 线程局部存储
+#if defined(_MSC_VER)
+#define SYS_THREAD_LOCAL __declspec(thread)
+#else
+#define SYS_THREAD_LOCAL __thread
+#endif
+
 #define plat_strlen         strlen
 #define plat_strcpy         strcpy
 #define plat_strncpy        strncpy
@@ -99,6 +109,8 @@ typedef HANDLE sys_sem_t; // 信号量
 int pcap_find_device(const char* ip, char* name_buf);
 int pcap_show_list(void);
 pcap_t* pcap_device_open(const char* ip, const uint8_t* mac_addr);
+int pcap_set_rx_filter(pcap_t* pcap, const uint8_t* mac_addr);
+int pcap_device_carrier(const char* name);
 
 // 网络接口信息结构体
 typedef struct _netif_info_t {
@@ -149,10 +161,15 @@ typedef struct _xsys_sem_t
 typedef pthread_t sys_thread_t; // 线程重定义
 typedef pthread_mutex_t* sys_mutex_t; // 互斥信号量
 
+// 线程局部存储
+#define SYS_THREAD_LOCAL __thread
+
 // PCAP网卡驱动相关函数
 int pcap_find_device(const char* ip, char* name_buf);
 int pcap_show_list(void);
 pcap_t* pcap_device_open(const char* ip, const uint8_t* mac_addr);
+int pcap_set_rx_filter(pcap_t* pcap, const uint8_t* mac_addr);
+int pcap_device_carrier(const char* name);
 
 // 网络接口信息结构体
 typedef struct _netif_info_t {
@@ -171,6 +188,8 @@ int pcap_get_first_netif(netif_info_t* info);
 sys_sem_t sys_sem_create(int init_count);
 void sys_sem_free(sys_sem_t sem);
 int sys_sem_wait(sys_sem_t sem, uint32_t ms);
+// 不等待地获取信号量，成功返回0，无可用计数时返回-1
+int sys_sem_trywait(sys_sem_t sem);
 void sys_sem_notify(sys_sem_t sem);
 
 // 互斥信号量：由具体平台实现
@@ -0,0 +1,196 @@
+#include <string.h>
+#include "common.h"
+#include "exmsg.h"
+#include "netif.h"
+#include "ipv4.h"
+#include "arp.h"
+#include "ether.h"
+#include "udp.h"
+#include "protocol.h"
+#include "pktbuf.h"
+#include "tool.h"
+#include "sys_plat.h"
+
+// GRO合并包拆分时耗尽pktbuf：大包必须只被释放一次，拆分后池中的包全部归还
+
+#define TEST_SEG_CNT        4               // 合并包中的数据报个数
+#define TEST_SEG_DATA       16              // 每个数据报的负载长度
+#define TEST_HOARD_MAX      512             // 占满池时最多持有的包数
+
+static netif_t* test_netif;
+static pktbuf_t* hoard[TEST_HOARD_MAX];
+
+typedef struct gro_split_case_t
+{
+    int spare;                              // 拆分前留给协议栈的空闲包数
+    net_err_t err;                          // ipv4_input返回值
+} gro_split_case_t;
+
+static net_err_t test_open(netif_t* netif, void* data)
+{
+    static const uint8_t hwaddr[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = ETHER_PAYLOAD_MAX_LEN;
+    netif->mtu_max = ETHER_PAYLOAD_MAX_LEN;
+    netif_set_hwaddr(netif, hwaddr, sizeof(hwaddr));
+    return NET_ERR_OK;
+}
+
+static net_err_t test_close(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+// 发出的包直接丢弃
+static net_err_t test_linkoutput(netif_t* netif)
+{
+    pktbuf_t* buf;
+    while ((buf = netif_get_out(netif, -1)) != NULL)
+    {
+        pktbuf_free(buf);
+    }
+    return NET_ERR_OK;
+}
+
+static const netif_open_options_t test_ops = {
+    .open = test_open,
+    .close = test_close,
+    .linkoutput = test_linkoutput,
+};
+
+static net_err_t test_setup(const func_msg_t* msg)
+{
+    test_netif = netif_open("gro0", &test_ops, NULL);
+    if (test_netif == NULL)
+    {
+        return NET_ERR_SYS;
+    }
+
+    ipaddr_t ipaddr, netmask, peer;
+    ipaddr4_form_str(&ipaddr, "10.7.0.1");
+    ipaddr4_form_str(&netmask, "255.255.255.0");
+    netif_set_addr(test_netif, &ipaddr, &netmask, NULL);
+    netif_set_active(test_netif);
+
+    // 端口不可达的ICMP回复不经过ARP排队，直接由网卡丢弃
+    static const uint8_t peer_hwaddr[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    ipaddr4_form_str(&peer, "10.7.0.2");
+    return arp_entry_add_static(test_netif, &peer, peer_hwaddr);
+}
+
+// 构造GRO合并后的UDP大包：一个IP头后接多个完整UDP数据报
+static pktbuf_t* build_merged(void)
+{
+    static uint8_t data[sizeof(ipv4_header_t) + TEST_SEG_CNT * (sizeof(udp_header_t) + TEST_SEG_DATA)];
+    const int udp_len = sizeof(udp_header_t) + TEST_SEG_DATA;
+    plat_memset(data, 0, sizeof(data));
+
+    ipv4_header_t* ip = (ipv4_header_t*)data;
+    ip->version = NET_VERSION_IPV4;
+    ip->shdr = sizeof(ipv4_header_t) / 4;
+    ip->total_len = x_htons(sizeof(data));
+    ip->ttl = 64;
+    ip->protocol = PROTOCOL_TYPE_UDP;
+    ipaddr_t src, dest;
+    ipaddr4_form_str(&src, "10.7.0.2");
+    ipaddr4_form_str(&dest, "10.7.0.1");
+    ipaddr_to_buf(&src, ip->src_addr);
+    ipaddr_to_buf(&dest, ip->dest_addr);
+    ip->header_checksum = checksum16(ip, sizeof(ipv4_header_t), 0, true);
+
+    for (int i = 0; i < TEST_SEG_CNT; i++)
+    {
+        udp_header_t* udp = (udp_header_t*)(data + sizeof(ipv4_header_t) + i * udp_len);
+        udp->src_port = x_htons(5000);
+        udp->dest_port = x_htons(9);
+        udp->length = x_htons(udp_len);
+    }
+
+    pktbuf_t* buf = pktbuf_alloc(sizeof(data));
+    if (buf == NULL)
+    {
+        return NULL;
+    }
+    pktbuf_reset_access(buf);
+    pktbuf_write(buf, data, sizeof(data));
+    buf->segs = TEST_SEG_CNT;
+    return buf;
+}
+
+// 在工作线程中占满pktbuf池后输入合并包，再归还占用的包
+static net_err_t test_split(const func_msg_t* msg)
+{
+    gro_split_case_t* c = msg->arg;
+    pktbuf_t* merged = build_merged();
+    if (merged == NULL)
+    {
+        return NET_ERR_MEM;
+    }
+
+    int cnt = 0;
+    while (cnt < TEST_HOARD_MAX && (hoard[cnt] = pktbuf_alloc(1)) != NULL)
+    {
+        cnt++;
+    }
+    for (int i = 0; i < c->spare && cnt > 0; i++)
+    {
+        pktbuf_free(hoard[--cnt]);
+    }
+
+    c->err = ipv4_input(test_netif, merged);
+
+    while (cnt > 0)
+    {
+        pktbuf_free(hoard[--cnt]);
+    }
+    return NET_ERR_OK;
+}
+
+// 统计当前可分配的pktbuf个数
+static int pktbuf_free_count(void)
+{
+    int cnt = 0;
+    while (cnt < TEST_HOARD_MAX && (hoard[cnt] = pktbuf_alloc(1)) != NULL)
+    {
+        cnt++;
+    }
+    for (int i = 0; i < cnt; i++)
+    {
+        pktbuf_free(hoard[i]);
+    }
+    return cnt;
+}
+
+int main(void)
+{
+    tiny_net_init();
+
+    if (exmsg_func_exec(test_setup, NULL) != NET_ERR_OK)
+    {
+        plat_printf("gro_split: setup failed\n");
+        return 1;
+    }
+    sys_sleep(100);
+
+    const int base = pktbuf_free_count();
+    int failed = 0;
+
+    // 无空闲包、只够拆出部分数据报、足够拆完所有数据报
+    static const int spares[] = {0, 1, 2, 3, 5, 8, 64};
+    for (int i = 0; i < sizeof(spares) / sizeof(spares[0]); i++)
+    {
+        gro_split_case_t c = {.spare = spares[i], .err = NET_ERR_SYS};
+        net_err_t err = exmsg_func_exec(test_split, &c);
+        sys_sleep(20);
+
+        const int now = pktbuf_free_count();
+        if (err != NET_ERR_OK || c.err != NET_ERR_OK || now != base)
+        {
+            plat_printf("gro_split: spare=%d err=%d input=%d free=%d, expect %d\n", spares[i], err, c.err, now, base);
+            failed++;
+        }
+    }
+
+    plat_printf("gro_split: %s\n", failed ? "FAILED" : "PASSED");
+    return failed ? 1 : 0;
+}
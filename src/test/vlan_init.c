@@ -0,0 +1,169 @@
+#include <string.h>
+#include "common.h"
+#include "exmsg.h"
+#include "netif.h"
+#include "ipv4.h"
+#include "arp.h"
+#include "ether.h"
+#include "vlan.h"
+#include "icmp_v4.h"
+#include "protocol.h"
+#include "pktbuf.h"
+#include "tool.h"
+#include "sys_plat.h"
+
+// 经tiny_net_init初始化后创建VLAN子接口，带标签的回显请求应从父接口带同一标签应答
+
+#define TEST_VLAN_ID        100
+#define TEST_ECHO_DATA      32              // 回显请求的负载长度
+
+static netif_t* parent;
+static netif_t* vlan;
+static const uint8_t parent_hwaddr[] = {0x02, 0x00, 0x00, 0x00, 0x01, 0x01};
+static const uint8_t peer_hwaddr[] = {0x02, 0x00, 0x00, 0x00, 0x01, 0x02};
+
+// 父接口发出的应答，在工作线程中记录
+static volatile int reply_cnt;
+static volatile int reply_vlan_id;
+static volatile int reply_icmp_type;
+
+static net_err_t test_open(netif_t* netif, void* data)
+{
+    netif->type = NETIF_TYPE_ETHERNET;
+    netif->mtu = ETHER_PAYLOAD_MAX_LEN;
+    netif->mtu_max = ETHER_PAYLOAD_MAX_LEN;
+    netif_set_hwaddr(netif, parent_hwaddr, sizeof(parent_hwaddr));
+    return NET_ERR_OK;
+}
+
+static net_err_t test_close(netif_t* netif)
+{
+    return NET_ERR_OK;
+}
+
+// 只记录带标签的IPv4帧，免费ARP等其余帧直接丢弃
+static net_err_t test_linkoutput(netif_t* netif)
+{
+    pktbuf_t* buf;
+    while ((buf = netif_get_out(netif, -1)) != NULL)
+    {
+        uint8_t frame[sizeof(ether_header_t) + ETHER_VLAN_TAG_LEN + sizeof(ipv4_header_t) + sizeof(icmp_v4_header_t)];
+        pktbuf_reset_access(buf);
+        if (buf->total_size >= sizeof(frame) && pktbuf_read(buf, frame, sizeof(frame)) == NET_ERR_OK)
+        {
+            const uint16_t tpid = (frame[12] << 8) | frame[13];
+            const uint16_t type = (frame[16] << 8) | frame[17];
+            if (tpid == PROTOCOL_TYPE_VLAN && type == PROTOCOL_TYPE_IPv4)
+            {
+                reply_vlan_id = ((frame[14] << 8) | frame[15]) & 0x0FFF;
+                reply_icmp_type = frame[sizeof(ether_header_t) + ETHER_VLAN_TAG_LEN + sizeof(ipv4_header_t)];
+                reply_cnt++;
+            }
+        }
+        pktbuf_free(buf);
+    }
+    return NET_ERR_OK;
+}
+
+static const netif_open_options_t test_ops = {
+    .open = test_open,
+    .close = test_close,
+    .linkoutput = test_linkoutput,
+};
+
+static net_err_t test_setup(const func_msg_t* msg)
+{
+    parent = netif_open("eth9", &test_ops, NULL);
+    if (parent == NULL)
+    {
+        return NET_ERR_SYS;
+    }
+    netif_set_active(parent);
+
+    vlan = vlan_open(parent, TEST_VLAN_ID, "eth9.100");
+    if (vlan == NULL)
+    {
+        return NET_ERR_SYS;
+    }
+
+    ipaddr_t ipaddr, netmask, peer;
+    ipaddr4_form_str(&ipaddr, "10.9.100.1");
+    ipaddr4_form_str(&netmask, "255.255.255.0");
+    netif_set_addr(vlan, &ipaddr, &netmask, NULL);
+    netif_set_active(vlan);
+
+    // 应答直接发出，不经过ARP请求
+    ipaddr4_form_str(&peer, "10.9.100.2");
+    return arp_entry_add_static(vlan, &peer, peer_hwaddr);
+}
+
+// 构造带VLAN标签的ICMP回显请求帧，返回帧长度
+static int build_echo_request(uint8_t* frame)
+{
+    const int ip_len = sizeof(ipv4_header_t) + sizeof(icmp_v4_header_t) + TEST_ECHO_DATA;
+    const int size = sizeof(ether_header_t) + ETHER_VLAN_TAG_LEN + ip_len;
+    plat_memset(frame, 0, size);
+
+    plat_memcpy(frame, parent_hwaddr, ETHER_HWADDR_LEN);
+    plat_memcpy(frame + ETHER_HWADDR_LEN, peer_hwaddr, ETHER_HWADDR_LEN);
+    frame[12] = PROTOCOL_TYPE_VLAN >> 8;
+    frame[13] = PROTOCOL_TYPE_VLAN & 0xFF;
+    frame[14] = TEST_VLAN_ID >> 8;
+    frame[15] = TEST_VLAN_ID & 0xFF;
+    frame[16] = PROTOCOL_TYPE_IPv4 >> 8;
+    frame[17] = PROTOCOL_TYPE_IPv4 & 0xFF;
+
+    ipv4_header_t* ip = (ipv4_header_t*)(frame + sizeof(ether_header_t) + ETHER_VLAN_TAG_LEN);
+    ip->version = NET_VERSION_IPV4;
+    ip->shdr = sizeof(ipv4_header_t) / 4;
+    ip->total_len = x_htons(ip_len);
+    ip->ttl = 64;
+    ip->protocol = PROTOCOL_TYPE_ICMP_V4;
+    ipaddr_t src, dest;
+    ipaddr4_form_str(&src, "10.9.100.2");
+    ipaddr4_form_str(&dest, "10.9.100.1");
+    ipaddr_to_buf(&src, ip->src_addr);
+    ipaddr_to_buf(&dest, ip->dest_addr);
+    ip->header_checksum = checksum16(ip, sizeof(ipv4_header_t), 0, true);
+
+    icmp_v4_header_t* icmp = (icmp_v4_header_t*)((uint8_t*)ip + sizeof(ipv4_header_t));
+    icmp->type = ICMP_V4_TYPE_ECHO_REQUEST;
+    icmp->checksum = checksum16(icmp, sizeof(icmp_v4_header_t) + TEST_ECHO_DATA, 0, true);
+    return size;
+}
+
+int main(void)
+{
+    tiny_net_init();
+
+    if (exmsg_func_exec(test_setup, NULL) != NET_ERR_OK)
+    {
+        plat_printf("vlan_init: setup failed\n");
+        return 1;
+    }
+
+    static uint8_t frame[sizeof(ether_header_t) + ETHER_VLAN_TAG_LEN + ETHER_PAYLOAD_MAX_LEN];
+    const int size = build_echo_request(frame);
+    pktbuf_t* buf = pktbuf_alloc(size);
+    if (buf == NULL)
+    {
+        plat_printf("vlan_init: no free pktbuf\n");
+        return 1;
+    }
+    pktbuf_reset_access(buf);
+    pktbuf_write(buf, frame, size);
+    netif_put_in(parent, buf, -1);
+
+    for (int i = 0; i < 100 && reply_cnt == 0; i++)
+    {
+        sys_sleep(10);
+    }
+
+    if (reply_cnt != 1 || reply_vlan_id != TEST_VLAN_ID || reply_icmp_type != ICMP_V4_TYPE_ECHO_REPLY)
+    {
+        plat_printf("vlan_init: FAILED, replies=%d vlan=%d type=%d\n", reply_cnt, reply_vlan_id, reply_icmp_type);
+        return 1;
+    }
+    plat_printf("vlan_init: PASSED\n");
+    return 0;
+}